@@ -12,9 +12,6 @@ layout(location = 2) out vec2 v_uv;
 
 layout(push_constant) uniform graphics_pc {
 	mat4 model;
-	mat4 view;
-	mat4 proj;
-	mat4 view_inv;
 };
 
 void main() {
@@ -0,0 +1,93 @@
+#version 460
+
+layout(local_size_x = 64) in;
+
+struct cull_object {
+	mat4 model;
+	vec3 aabb_min;
+	uint batch;
+	vec3 aabb_max;
+	uint batch_first;
+
+	uint index_count;
+	uint first_index;
+	int vertex_offset;
+	uint command;
+};
+
+struct draw_command {
+	uint index_count;
+	uint instance_count;
+	uint first_index;
+	int vertex_offset;
+	uint first_instance;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer objects_buffer {
+	cull_object objects[];
+};
+
+layout(std430, set = 0, binding = 1) writeonly buffer commands_buffer {
+	draw_command commands[];
+};
+
+layout(std430, set = 0, binding = 2) buffer counts_buffer {
+	uint counts[];
+};
+
+layout(push_constant) uniform cull_pc {
+	vec4 planes[6];
+	uint object_count;
+	uint command_offset;
+	uint count_offset;
+	uint compact;
+};
+
+bool is_visible(cull_object o) {
+	// World space aabb of the transformed local bounds.
+	vec3 center = (o.aabb_min + o.aabb_max) * 0.5f;
+	vec3 extent = (o.aabb_max - o.aabb_min) * 0.5f;
+
+	vec3 world_center = (o.model * vec4(center, 1.0f)).xyz;
+	mat3 abs_model = mat3(abs(o.model[0].xyz), abs(o.model[1].xyz), abs(o.model[2].xyz));
+	vec3 world_extent = abs_model * extent;
+
+	for (int i = 0; i < 6; i++) {
+		float radius = dot(world_extent, abs(planes[i].xyz));
+		if (dot(planes[i].xyz, world_center) + planes[i].w < -radius) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void main() {
+	uint object_idx = gl_GlobalInvocationID.x;
+	if (object_idx >= object_count) {
+		return;
+	}
+
+	cull_object o = objects[object_idx];
+	bool visible = is_visible(o);
+
+	draw_command cmd;
+	cmd.index_count = o.index_count;
+	cmd.instance_count = 1;
+	cmd.first_index = o.first_index;
+	cmd.vertex_offset = o.vertex_offset;
+	cmd.first_instance = object_idx;
+
+	if (compact != 0) {
+		if (!visible) {
+			return;
+		}
+
+		uint slot = atomicAdd(counts[count_offset + o.batch], 1);
+		commands[command_offset + o.batch_first + slot] = cmd;
+	} else {
+		// Every object keeps its slot, culled draws have no instances.
+		cmd.instance_count = visible ? 1 : 0;
+		commands[command_offset + o.command] = cmd;
+	}
+}
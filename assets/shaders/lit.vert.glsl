@@ -16,8 +16,12 @@ layout(location = 5) out mat3 TBN;
 
 layout(push_constant) uniform graphics_pc {
 	mat4 model;
+};
+
+layout(set = 3, binding = 0) uniform mgfx_view {
 	mat4 view;
 	mat4 proj;
+	mat4 view_proj;
 	mat4 view_inv;
 };
 
@@ -34,6 +38,6 @@ void main() {
 
 	// TODO: send from cpu
 	//cam_position = view_inv[3].xyz;
-	cam_position = inverse(view)[3].xyz;
-	gl_Position = proj * view * model * vec4(position, 1.0f);
+	cam_position = view_inv[3].xyz;
+	gl_Position = view_proj * model * vec4(position, 1.0f);
 }
@@ -0,0 +1,196 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 v_normal;
+layout(location = 1) in vec2 v_uv;
+layout(location = 2) in vec3 v_color;
+
+layout(location = 3) in vec3 world_position;
+layout(location = 4) in flat vec3 cam_position;
+layout(location = 5) in mat3 TBN;
+
+layout(location = 0) out vec4 frag_color;
+
+const float PI = 3.14159265359;
+
+struct point_light {
+    vec3 position;
+    vec3 color;
+    float intensity;
+};
+
+struct directional_light  {
+    vec3 direction;
+    vec3 color;
+};
+
+const int POINT_LIGHT_COUNT = 3;
+point_light point_lights[] = point_light[](
+    // HDR.
+    // point_light(vec3(5.0, 5.0, 0.0), vec3(1.0, 1.0, 1.0) * 255.0, 5.0),
+    // point_light(vec3(-10.0, 10.0, 4.0), vec3(0.7, 0.3, 0.3) * 255.0, 10.0),
+    // point_light(vec3(0.0, -10.0, 5.0), vec3(160.0, 32.0, 240.0), 5.0)
+
+    point_light(vec3(5.0, 5.0, 0.0), vec3(1.0, 1.0, 1.0), 5.0),
+    point_light(vec3(-5.0, 5.0, 0.0), vec3(1.0, 1.0, 1.0), 5.0),
+    point_light(vec3(0.0, 5.0, 0.0), vec3(1.0, 1.0, 1.0), 5.0)
+    // point_light(vec3(-10.0, 10.0, 4.0), vec3(0.7, 0.3, 0.3), 10.0),
+    // point_light(vec3(0.0, -10.0, 5.0), vec3(0.4, 0.2, 0.9), 5.0)
+);
+
+const int DIR_LIGHT_COUNT = 1;
+directional_light directional_lights[] = directional_light[](
+    directional_light(vec3(1.0, -1.0, 0.0), vec3(1.0, 1.0f, 1.0))
+);
+
+// Materials and textures are read from the global bindless arrays, see gltf_loader_flag_bindless.
+layout(push_constant) uniform bindless_pc {
+	layout(offset = 64) uint material_buffer;
+	uint material_idx;
+};
+
+struct material_data {
+	vec3 albedo_factor;
+	float metallic_factor;
+
+	float roughness_factor;
+	float ao_factor;
+	float normal_factor;
+	float padding;
+
+	vec3 emissive_factor;
+	float emissive_strength;
+
+	uint albedo_map;
+	uint metallic_roughness_map;
+	uint normal_map;
+	uint occlusion_map;
+	uint emissive_map;
+};
+
+layout(set = 2, binding = 0) uniform sampler2D b_textures[];
+layout(std430, set = 2, binding = 1) readonly buffer materials_buffer {
+	material_data materials[];
+} b_buffers[];
+
+vec3 fresnel_schlick(float cos_theta, vec3 f0)
+{
+    return f0 + (1.0 - f0) * pow(clamp(1.0 - cos_theta, 0.0, 1.0), 5.0);
+}
+
+float distribution_GGX(vec3 N, vec3 H, float roughness)
+{
+    float a = roughness*roughness;
+    float a2 = a*a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH*NdotH;
+	
+    float num = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+	
+    return num / denom;
+}
+
+float geometry_schlick_ggx(float NdotV, float roughness)
+{
+    float r = (roughness + 1.0);
+    float k = (r*r) / 8.0;
+
+    float num   = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+	
+    return num / denom;
+}
+
+float geometry_smith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2  = geometry_schlick_ggx(NdotV, roughness);
+    float ggx1  = geometry_schlick_ggx(NdotL, roughness);
+	
+    return ggx1 * ggx2;
+}
+
+void main() {
+    // Indices are pushed per draw and stay uniform, no nonuniformEXT needed.
+    material_data material = b_buffers[material_buffer].materials[material_idx];
+
+    vec3 n = texture(b_textures[material.normal_map], v_uv).xyz * 2.0 - 1.0;
+    n = normalize(TBN * n);
+
+    vec3 v = normalize(cam_position - world_position);
+
+    vec3 albedo = pow(texture(b_textures[material.albedo_map], v_uv).rgb, vec3(2.2));
+    float metallic = texture(b_textures[material.metallic_roughness_map], v_uv).b;
+    float roughness = texture(b_textures[material.metallic_roughness_map], v_uv).g;
+    float ao = texture(b_textures[material.occlusion_map], v_uv).r * material.ao_factor;
+    vec3 emissive = pow(texture(b_textures[material.emissive_map], v_uv).rgb, vec3(2.2)) *
+                    material.emissive_factor * material.emissive_strength;
+
+    vec3 lo = vec3(0.0f);
+
+    for(int i = 0; i < POINT_LIGHT_COUNT; i++) {
+	    vec3 l = normalize(point_lights[i].position - world_position);
+	    vec3 h = normalize(v + l);
+
+	    float distance = length(point_lights[i].position - world_position);
+	    float attenuation = 1.0f / (distance * distance);
+	    vec3 radiance = point_lights[i].color * attenuation;
+
+	    // Specular factor
+	    vec3 f0 = vec3(0.04); // surface reflection at 0
+	    f0 = mix(f0, albedo, metallic);
+	    vec3 f = fresnel_schlick(max(dot(h, v), 0.0), f0);
+
+	    float ndf = distribution_GGX(n, h, roughness);
+	    float g = geometry_smith(n, v, l, roughness);
+
+	    vec3 numerator = ndf * g * f;
+	    float denominator = 4 * max(dot(n, v), 0.0) * max(dot(n, l), 0.0)  + 0.0001; 
+	    vec3 specular = numerator / denominator;
+
+	    vec3 ks = f;
+	    vec3 kd = vec3(1.0f) - ks;
+	    kd *= (1.0f - metallic);
+
+	    float lambertian_factor = max(dot(n,l), 0.0f);
+	    lo += (kd * albedo / PI + specular) * radiance * lambertian_factor;
+    }
+
+    for(int i = 0; i < DIR_LIGHT_COUNT ; i++) {
+	    vec3 l = normalize(-directional_lights[i].direction);
+	    vec3 h = normalize(v + l);
+
+	    vec3 radiance = directional_lights[i].color;
+
+	    // Specular factor
+	    vec3 f0 = vec3(0.04); // surface reflection at 0
+	    f0 = mix(f0, albedo, metallic);
+	    vec3 f = fresnel_schlick(max(dot(h, v), 0.0), f0);
+
+	    float ndf = distribution_GGX(n, h, roughness);
+	    float g = geometry_smith(n, v, l, roughness);
+
+	    vec3 numerator = ndf * g * f;
+	    float denominator = 4 * max(dot(n, v), 0.0) * max(dot(n, l), 0.0)  + 0.0001; 
+	    vec3 specular = numerator / denominator;
+
+	    vec3 ks = f;
+	    vec3 kd = vec3(1.0f) - ks;
+	    kd *= (1.0f - metallic);
+
+	    float lambertian_factor = max(dot(n,l), 0.0f);
+	    lo += (kd * albedo / PI + specular) * radiance * lambertian_factor;
+    }
+
+    // Ambient lighting
+    vec3 ambient = vec3(0.03) * albedo * ao;
+    vec3 color = ambient + lo;
+
+    // Emissive 
+    color += emissive;
+
+    frag_color = vec4(color, 1.0f);
+}
@@ -100,7 +100,10 @@ float geometry_smith(vec3 N, vec3 V, vec3 L, float roughness)
 }
 
 void main() {
-    vec3 n = texture(normal_map, v_uv).xyz * 2.0 - 1.0;
+    // Z is rebuilt from xy so two channel (bc5) normal maps sample the same as rgb ones.
+    vec3 n;
+    n.xy = texture(normal_map, v_uv).xy * 2.0 - 1.0;
+    n.z = sqrt(max(1.0 - dot(n.xy, n.xy), 0.0));
     n = normalize(TBN * n);
 
     vec3 v = normalize(cam_position - world_position);
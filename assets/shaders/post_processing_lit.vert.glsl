@@ -22,14 +22,32 @@ layout(set = 0, binding = 1) uniform directional_light {
 	vec3 color;
 } dir_light;
 
-layout(push_constant) uniform graphics_pc {
+struct cull_object {
 	mat4 model;
+	vec4 aabb_min;
+	vec4 aabb_max;
+	uvec4 draw;
+};
+
+// Culled on the gpu, first_instance is the object index.
+layout(std430, set = 2, binding = 0) readonly buffer objects_buffer {
+	cull_object objects[];
+};
+
+layout(push_constant) uniform graphics_pc {
+	mat4 pc_model;
+};
+
+layout(set = 3, binding = 0) uniform mgfx_view {
 	mat4 view;
 	mat4 proj;
+	mat4 view_proj;
 	mat4 view_inv;
 };
 
 void main() {
+	mat4 model = objects[gl_InstanceIndex].model;
+
 	v_normal = normalize(transpose(inverse(mat3(model))) * normal);
 	v_uv = uv;
 	v_color = color.xyz;
@@ -44,7 +62,7 @@ void main() {
 
 	// TODO: send from cpu
 	//cam_position = view_inv[3].xyz;
-	cam_position = inverse(view)[3].xyz;
+	cam_position = view_inv[3].xyz;
 
-	gl_Position = proj * view * model * vec4(position, 1.0f);
+	gl_Position = view_proj * model * vec4(position, 1.0f);
 }
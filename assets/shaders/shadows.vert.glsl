@@ -6,14 +6,32 @@ layout(location = 2) in vec2 uv;
 layout(location = 3) in vec4 color;
 layout(location = 4) in vec4 tangent;
 
-layout(push_constant) uniform graphics_pc {
+struct cull_object {
 	mat4 model;
+	vec4 aabb_min;
+	vec4 aabb_max;
+	uvec4 draw;
+};
+
+// Culled on the gpu, first_instance is the object index.
+layout(std430, set = 0, binding = 0) readonly buffer objects_buffer {
+	cull_object objects[];
+};
+
+layout(push_constant) uniform graphics_pc {
+	mat4 pc_model;
+};
+
+layout(set = 3, binding = 0) uniform mgfx_view {
 	mat4 view;
 	mat4 proj;
+	mat4 view_proj;
 	mat4 view_inv;
 };
 
 void main() {
-	vec3 cam_position = inverse(view)[3].xyz;
-	gl_Position = proj * view * model * vec4(position, 1.0f);
+	mat4 model = objects[gl_InstanceIndex].model;
+
+	vec3 cam_position = view_inv[3].xyz;
+	gl_Position = view_proj * model * vec4(position, 1.0f);
 }
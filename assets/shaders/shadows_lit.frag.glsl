@@ -19,7 +19,7 @@ layout(set = 0, binding = 0) uniform directional_light {
     float distance;  // Padding to align vec3 to 16 bytes
     vec3 color;
     float _pad2;    // Padding to align vec3 to 16 bytes
-} dir_light;
+} t_dir_light;
 
 layout(set = 0, binding = 1) uniform sampler2D shadow_map;
 
@@ -100,10 +100,10 @@ void main() {
 
     // Directional light
     {
-	vec3 l = normalize(-dir_light.direction);
+	vec3 l = normalize(-t_dir_light.direction);
 	vec3 h = normalize(v + l);
 
-	vec3 radiance = dir_light.color;
+	vec3 radiance = t_dir_light.color;
 
 	// Specular factor
 	vec3 f0 = vec3(0.04); // surface reflection at 0
@@ -6,12 +6,16 @@ layout(location = 0) out vec3 v_tex_coords;
 
 layout(push_constant) uniform graphics_pc {
 	mat4 model;
+};
+
+layout(set = 3, binding = 0) uniform mgfx_view {
 	mat4 view;
 	mat4 proj;
+	mat4 view_proj;
 	mat4 view_inv;
 };
 
 void main() {
 	v_tex_coords = vec3(position);
-	gl_Position = proj * view * vec4(position, 1.0f);
+	gl_Position = view_proj * vec4(position, 1.0f);
 }
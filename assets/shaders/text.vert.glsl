@@ -12,9 +12,6 @@ layout(location = 2) out vec2 v_uv;
 
 layout(push_constant) uniform graphics_pc {
 	mat4 model;
-	mat4 view;
-	mat4 proj;
-	mat4 view_inv;
 };
 
 void main() {
@@ -22,5 +19,5 @@ void main() {
 	v_color = (color.xyz);
 
 	v_uv = vec2(uv_x, uv_y);
-	gl_Position = proj * view * model * vec4(position, 1.0f);
+	gl_Position = model * vec4(position, 1.0f);
 }
@@ -12,8 +12,12 @@ layout(location = 2) out vec2 v_uv;
 
 layout(push_constant) uniform graphics_pc {
 	mat4 model;
+};
+
+layout(set = 3, binding = 0) uniform mgfx_view {
 	mat4 view;
 	mat4 proj;
+	mat4 view_proj;
 	mat4 view_inv;
 };
 
@@ -21,5 +25,5 @@ void main() {
 	v_normal = (normal.xyz);
 	v_color = (color.xyz);
 	v_uv = vec2(uv_x, uv_y);
-	gl_Position = proj * view * model * vec4(position, 1.0f);
+	gl_Position = view_proj * model * vec4(position, 1.0f);
 }
@@ -0,0 +1,35 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in float uv_x;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in float uv_y;
+layout(location = 4) in vec4 color;
+
+// Per instance, xyz offset and w uniform scale.
+layout(location = 5) in vec4 i_offset_scale;
+layout(location = 6) in vec4 i_color;
+
+layout(location = 0) out vec3 v_normal;
+layout(location = 1) out vec3 v_color;
+layout(location = 2) out vec2 v_uv;
+
+layout(push_constant) uniform graphics_pc {
+	mat4 model;
+};
+
+layout(set = 3, binding = 0) uniform mgfx_view {
+	mat4 view;
+	mat4 proj;
+	mat4 view_proj;
+	mat4 view_inv;
+};
+
+void main() {
+	v_normal = (normal.xyz);
+	v_color = (color.xyz * i_color.xyz);
+	v_uv = vec2(uv_x, uv_y);
+
+	vec3 instance_position = position * i_offset_scale.w + i_offset_scale.xyz;
+	gl_Position = view_proj * model * vec4(instance_position, 1.0f);
+}
@@ -0,0 +1,16 @@
+#version 450
+
+layout(location = 0) in vec3 v_normal;
+layout(location = 1) in vec3 v_color;
+layout(location = 2) in vec2 v_uv;
+
+layout(location = 0) out vec4 frag_color;
+
+// Rewritten every frame, bound with a dynamic offset into the transient uniform ring.
+layout(set = 0, binding = 0) uniform tint_block {
+	vec4 tint;
+} t_tint;
+
+void main() {
+	frag_color = vec4(v_color * t_tint.tint.rgb, 1.0f);
+}
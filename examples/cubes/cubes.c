@@ -4,6 +4,7 @@
 #include <mx/mx_log.h>
 #include <mx/mx_math.h>
 #include <mx/mx_math_mtx.h>
+#include <mx/mx_memory.h>
 
 typedef struct my_vertex {
     float position[3];
@@ -95,20 +96,65 @@ static uint32_t k_indices[] = {
 };
 const size_t k_cube_index_count = sizeof(k_indices) / sizeof(uint32_t);
 
+// Every cube is one instance of a single instanced draw.
+typedef struct cube_instance {
+    float offset_scale[4];
+    float color[4];
+} cube_instance;
+
+enum { CUBES_GRID_X = 100 };
+enum { CUBES_GRID_Y = 100 };
+enum { CUBES_GRID_Z = 10 };
+enum { CUBES_COUNT = CUBES_GRID_X * CUBES_GRID_Y * CUBES_GRID_Z };
+
 mgfx_sh cube_sh, fsh;
 mgfx_ph gfxph;
 
+// The tint is rewritten every frame through the transient uniform ring.
+mgfx_dh u_tint;
+
 mgfx_vbh vbh;
 mgfx_ibh ibh;
+mgfx_instbh instbh;
 
 void mgfx_example_init() {
-    cube_sh = mgfx_shader_create("/Users/christianmarkg.solon/dev/mx_app/mgfx/unlit.vert.spv");
-    fsh = mgfx_shader_create("/Users/christianmarkg.solon/dev/mx_app/mgfx/unlit.frag.spv");
+    cube_sh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/unlit_instanced.vert.glsl.spv");
+    fsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/unlit_tint.frag.glsl.spv");
+
+    const mgfx_graphics_ex_create_info gfx_info = {
+        .polygon_mode = VK_POLYGON_MODE_FILL,
+        .primitive_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        .cull_mode = VK_CULL_MODE_BACK_BIT,
+        .instanced = MX_TRUE,
+    };
+    gfxph = mgfx_program_create_graphics_ex(cube_sh, fsh, &gfx_info);
 
-    gfxph = mgfx_program_create_graphics(cube_sh, fsh);
+    u_tint = mgfx_descriptor_create("t_tint", VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
 
     vbh = mgfx_vertex_buffer_create(k_vertices, sizeof(k_vertices));
     ibh = mgfx_index_buffer_create(k_indices, sizeof(k_indices));
+
+    cube_instance* instances =
+        mx_alloc(mx_default_allocator(), CUBES_COUNT * sizeof(cube_instance));
+    for (uint32_t i = 0; i < CUBES_COUNT; i++) {
+        const uint32_t x = i % CUBES_GRID_X;
+        const uint32_t y = (i / CUBES_GRID_X) % CUBES_GRID_Y;
+        const uint32_t z = i / (CUBES_GRID_X * CUBES_GRID_Y);
+
+        instances[i] = (cube_instance){
+            .offset_scale = {(x - CUBES_GRID_X * 0.5f) * 2.0f,
+                             (y - CUBES_GRID_Y * 0.5f) * 2.0f,
+                             z * -2.0f,
+                             1.0f},
+            .color = {(float)x / CUBES_GRID_X,
+                      (float)y / CUBES_GRID_Y,
+                      (float)z / CUBES_GRID_Z,
+                      1.0f},
+        };
+    }
+
+    instbh = mgfx_instance_buffer_create(instances, CUBES_COUNT * sizeof(cube_instance));
+    mx_free(mx_default_allocator(), instances);
 }
 
 void mgfx_example_update() {
@@ -120,29 +166,37 @@ void mgfx_example_update() {
     if (fabsf(cur_value - last_value) > epsilon) {
         last_value = cur_value;
     }
-    mgfx_debug_draw_text(0, APP_HEIGHT * 0.95f, "dt: %.2f ms", last_value * 1000.0f);
+    mgfx_debug_draw_text(
+        0, APP_HEIGHT * 0.95f, "dt: %.2f ms cubes: %u", last_value * 1000.0f, CUBES_COUNT);
 
-    for (int x = -2; x < 3; x++) {
-        mgfx_bind_vertex_buffer(vbh);
-        mgfx_bind_index_buffer(ibh);
+    mgfx_bind_vertex_buffer(vbh);
+    mgfx_bind_instance_buffer(instbh);
+    mgfx_bind_index_buffer(ibh);
 
-        mx_mat4 rot = mx_mat4_rotate_euler(MGFX_TIME, (mx_vec3){MGFX_TIME, MGFX_TIME, MGFX_TIME});
-        mx_mat4 translate = mx_translate((mx_vec3){x * 2.0f, 0.0f, 0.0f});
-        mgfx_set_transform(mx_mat4_mul(translate, rot).val);
+    const float pulse = 0.75f + 0.25f * sinf(MGFX_TIME * 2.0f);
+    const float tint[4] = {pulse, pulse, pulse, 1.0f};
 
-        mx_mat4 proj = mx_perspective(MX_DEG_TO_RAD(60.0), 16.0 / 9.0, 0.1, 1000.0f);
-        mgfx_set_proj(proj.val);
+    mgfx_transient_buffer tint_tb;
+    mgfx_transient_uniform_buffer_allocate(tint, sizeof(tint), &tint_tb);
+    mgfx_bind_transient_uniform_buffer(0, u_tint, tint_tb);
 
-        mx_mat4 view = mx_look_at((mx_vec3){.z = 5.0f}, (mx_vec3){0}, MX_VEC3_UP);
-        mgfx_set_view(view.val);
+    mx_mat4 rot = mx_mat4_rotate_euler(MGFX_TIME * 0.1f, (mx_vec3){0.0f, 1.0f, 0.0f});
+    mgfx_set_transform(rot.val);
 
-        mgfx_submit(MGFX_DEFAULT_VIEW_TARGET, gfxph);
-    }
+    mx_mat4 proj = mx_perspective(MX_DEG_TO_RAD(60.0), 16.0 / 9.0, 0.1, 1000.0f);
+
+    mx_mat4 view = mx_look_at((mx_vec3){.y = 60.0f, .z = 160.0f}, (mx_vec3){0}, MX_VEC3_UP);
+    mgfx_set_view_transform(MGFX_DEFAULT_VIEW_TARGET, view.val, proj.val);
+
+    mgfx_submit_instanced(MGFX_DEFAULT_VIEW_TARGET, gfxph, CUBES_COUNT);
 }
 
 void mgfx_example_shutdown() {
     mgfx_buffer_destroy(vbh.idx);
     mgfx_buffer_destroy(ibh.idx);
+    mgfx_buffer_destroy(instbh.idx);
+
+    mgfx_descriptor_destroy(u_tint);
 
     mgfx_program_destroy(gfxph);
     mgfx_shader_destroy(cube_sh);
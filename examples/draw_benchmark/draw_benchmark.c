@@ -0,0 +1,168 @@
+#include "ex_common.h"
+
+#include <GLFW/glfw3.h>
+#include <math.h>
+
+#include <mx/mx_log.h>
+#include <mx/mx_math.h>
+#include <mx/mx_math_mtx.h>
+
+// Measures the cpu cost of mgfx_submit and the draw arena footprint at increasing draw counts.
+// Each stage submits `draw_count` cubes for a number of frames and logs the averages.
+
+typedef struct benchmark_stage {
+    uint32_t draw_count;
+
+    double submit_time;
+    size_t draw_bytes;
+    uint64_t binds;
+    uint64_t binds_skipped;
+    uint32_t frames;
+} benchmark_stage;
+
+enum { BENCHMARK_WARMUP_FRAMES = 30 };
+enum { BENCHMARK_STAGE_FRAMES = 120 };
+
+static benchmark_stage s_stages[] = {
+    {.draw_count = 1000},
+    {.draw_count = 10000},
+    {.draw_count = 100000},
+};
+static const uint32_t k_stage_count = sizeof(s_stages) / sizeof(benchmark_stage);
+
+static uint32_t s_stage_idx = 0;
+static uint32_t s_stage_frame = 0;
+
+typedef struct benchmark_vertex {
+    float position[3];
+    float uv_x;
+    float normal[3];
+    float uv_y;
+    float color[4];
+} benchmark_vertex;
+
+static benchmark_vertex k_vertices[] = {
+    {{-0.5f, -0.5f, 0.5f}, 0.0f, {0.0f, 0.0f, 1.0f}, 0.0f, {1.0f, 0.0f, 0.0f, 1.0f}},
+    {{0.5f, -0.5f, 0.5f}, 1.0f, {0.0f, 0.0f, 1.0f}, 0.0f, {0.0f, 1.0f, 0.0f, 1.0f}},
+    {{0.5f, 0.5f, 0.5f}, 1.0f, {0.0f, 0.0f, 1.0f}, 1.0f, {0.0f, 0.0f, 1.0f, 1.0f}},
+    {{-0.5f, 0.5f, 0.5f}, 0.0f, {0.0f, 0.0f, 1.0f}, 1.0f, {1.0f, 1.0f, 0.0f, 1.0f}},
+    {{-0.5f, -0.5f, -0.5f}, 0.0f, {0.0f, 0.0f, -1.0f}, 0.0f, {1.0f, 0.0f, 1.0f, 1.0f}},
+    {{0.5f, -0.5f, -0.5f}, 1.0f, {0.0f, 0.0f, -1.0f}, 0.0f, {0.0f, 1.0f, 1.0f, 1.0f}},
+    {{0.5f, 0.5f, -0.5f}, 1.0f, {0.0f, 0.0f, -1.0f}, 1.0f, {1.0f, 1.0f, 1.0f, 1.0f}},
+    {{-0.5f, 0.5f, -0.5f}, 0.0f, {0.0f, 0.0f, -1.0f}, 1.0f, {0.5f, 0.5f, 0.5f, 1.0f}},
+};
+
+static uint32_t k_indices[] = {
+    0, 1, 2, 0, 2, 3, // Front
+    5, 4, 7, 5, 7, 6, // Back
+    4, 0, 3, 4, 3, 7, // Left
+    1, 5, 6, 1, 6, 2, // Right
+    3, 2, 6, 3, 6, 7, // Top
+    4, 5, 1, 4, 1, 0, // Bottom
+};
+
+static mgfx_sh vsh, fsh;
+static mgfx_ph ph;
+
+static mgfx_vbh vbh;
+static mgfx_ibh ibh;
+
+void mgfx_example_init() {
+    vsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/unlit.vert.glsl.spv");
+    fsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/unlit.frag.glsl.spv");
+    ph = mgfx_program_create_graphics(vsh, fsh);
+
+    vbh = mgfx_vertex_buffer_create(k_vertices, sizeof(k_vertices));
+    ibh = mgfx_index_buffer_create(k_indices, sizeof(k_indices));
+
+    g_example_camera.position = (mx_vec3){0.0f, 0.0f, 80.0f};
+}
+
+static uint32_t bind_count_total(const mgfx_bind_counts* counts) {
+    return counts->pipelines + counts->descriptor_sets + counts->vertex_buffers +
+           counts->index_buffers + counts->push_constants;
+}
+
+static void benchmark_stage_log(const benchmark_stage* stage) {
+    const double submit_ms = stage->submit_time / stage->frames * 1000.0;
+
+    MX_LOG_INFO("[DrawBenchmark] %6u draws | %7.1f bytes/draw | submit %.3f ms (%.1f ns/draw)",
+                stage->draw_count,
+                (double)stage->draw_bytes / stage->frames / stage->draw_count,
+                submit_ms,
+                submit_ms * 1e6 / stage->draw_count);
+
+    MX_LOG_INFO("[DrawBenchmark] %6u draws | %.2f binds/draw | %.2f redundant binds/draw skipped",
+                stage->draw_count,
+                (double)stage->binds / stage->frames / stage->draw_count,
+                (double)stage->binds_skipped / stage->frames / stage->draw_count);
+}
+
+void mgfx_example_update() {
+    benchmark_stage* stage = &s_stages[s_stage_idx];
+
+    // Stats describe the previous frame, which submitted this stage's draws.
+    const mgfx_stats* stats = mgfx_get_stats();
+    if (s_stage_frame > BENCHMARK_WARMUP_FRAMES && stats->draw_count > 0) {
+        stage->draw_bytes += stats->draw_bytes;
+        stage->binds += bind_count_total(&stats->binds);
+        stage->binds_skipped += bind_count_total(&stats->binds_skipped);
+    }
+
+    const uint32_t grid = (uint32_t)ceilf(sqrtf((float)stage->draw_count));
+
+    mgfx_set_view_transform(
+        MGFX_DEFAULT_VIEW_TARGET, g_example_camera.view.val, g_example_camera.proj.val);
+
+    const double submit_start = glfwGetTime();
+
+    for (uint32_t i = 0; i < stage->draw_count; i++) {
+        const float x = (float)(i % grid) - grid * 0.5f;
+        const float y = (float)(i / grid) - grid * 0.5f;
+
+        mx_mat4 model = mx_mat4_mul(mx_translate((mx_vec3){x * 1.5f, y * 1.5f, 0.0f}),
+                                    mx_scale((mx_vec3){0.5f, 0.5f, 0.5f}));
+        mgfx_set_transform(model.val);
+
+        mgfx_bind_vertex_buffer(vbh);
+        mgfx_bind_index_buffer(ibh);
+
+        mgfx_submit(MGFX_DEFAULT_VIEW_TARGET, ph);
+    }
+
+    const double submit_time = glfwGetTime() - submit_start;
+
+    if (++s_stage_frame > BENCHMARK_WARMUP_FRAMES) {
+        stage->submit_time += submit_time;
+        stage->frames++;
+    }
+
+    mgfx_debug_draw_text(0,
+                         APP_HEIGHT * 0.95f,
+                         "draws: %u submit: %.2f ms",
+                         stage->draw_count,
+                         submit_time * 1000.0);
+
+    if (stage->frames >= BENCHMARK_STAGE_FRAMES) {
+        benchmark_stage_log(stage);
+
+        s_stage_idx = (s_stage_idx + 1) % k_stage_count;
+        s_stage_frame = 0;
+        s_stages[s_stage_idx].submit_time = 0.0;
+        s_stages[s_stage_idx].draw_bytes = 0;
+        s_stages[s_stage_idx].binds = 0;
+        s_stages[s_stage_idx].binds_skipped = 0;
+        s_stages[s_stage_idx].frames = 0;
+    }
+}
+
+void mgfx_example_shutdown() {
+    mgfx_buffer_destroy(vbh.idx);
+    mgfx_buffer_destroy(ibh.idx);
+
+    mgfx_program_destroy(ph);
+    mgfx_shader_destroy(vsh);
+    mgfx_shader_destroy(fsh);
+}
+
+int main() { mgfx_example_app(); }
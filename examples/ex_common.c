@@ -12,10 +12,9 @@
 
 #include <GLFW/glfw3.h>
 
-#include <vulkan/vulkan_core.h>
+#include <string.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include <vulkan/vulkan_core.h>
 
 GLFWwindow* s_window = NULL;
 mx_bool s_keys[GLFW_KEY_LAST];
@@ -175,31 +174,28 @@ static uint32_t k_cube_indices[] = {
 
 static const size_t k_cube_index_count = sizeof(k_cube_indices) / sizeof(uint32_t);
 
-mgfx_th load_texture_2d_from_path(const char* path, VkFormat format) {
-    int width, height, channel_count;
-
-    stbi_uc* data = stbi_load(path, &width, &height, &channel_count, STBI_rgb_alpha);
-
-    MX_ASSERT(data, "Texture at %s failed to load", path);
-    MX_ASSERT(data != NULL, "[MGFX_EXAMPLES]: Failed to load texture!");
-
-    size_t size = width * height * 4;
-    MX_LOG_SUCCESS("Texture loaded: %s (%.2f mb)!", path, (float)size / MX_MB);
-
-    mgfx_image_info info = {
-        .format = format,
+mgfx_th load_texture_2d_from_path_ex(const char* path, VkFormat format, mgfx_th placeholder) {
+    // Prefer a sibling ktx2 baked by mgfx_texbake, its levels upload without decoding.
+    char baked_path[512];
+    const char* ext = strrchr(path, '.');
+    const size_t stem_len = ext ? (size_t)(ext - path) : strlen(path);
 
-        .width = width,
-        .height = height,
-        .layers = 1,
+    size_t baked_size = 0;
+    if (stem_len + sizeof(".ktx2") <= sizeof(baked_path)) {
+        memcpy(baked_path, path, stem_len);
+        memcpy(baked_path + stem_len, ".ktx2", sizeof(".ktx2"));
 
-        .cube_map = MX_FALSE,
-    };
+        if (mx_read_file(baked_path, &baked_size, NULL) == MX_SUCCESS) {
+            path = baked_path;
+        }
+    }
 
-    mgfx_th th = mgfx_texture_create_from_memory(&info, VK_FILTER_LINEAR, data, size);
+    // Decoded and streamed in by mgfx, the texture samples the placeholder until then.
+    return mgfx_texture_load_async(path, format, VK_FILTER_LINEAR, placeholder);
+}
 
-    stbi_image_free(data);
-    return th;
+mgfx_th load_texture_2d_from_path(const char* path, VkFormat format) {
+    return load_texture_2d_from_path_ex(path, format, (mgfx_th){0});
 }
 
 static void window_resize_callback(GLFWwindow* window, int width, int height) {
@@ -334,6 +330,7 @@ int mgfx_example_app() {
     glfwSetCursorPosCallback(s_window, mouse_callback);
 
     mgfx_init_info mgfx_info = {"Clear Screen", s_window};
+    mgfx_info.bindless = MX_TRUE; // Examples fall back to descriptors without support.
 
     if (mgfx_init(&mgfx_info) != 0) {
         return -1;
@@ -441,10 +438,13 @@ void mgfx_gizmo_draw_cube(const float* view,
                           const mx_vec3 position,
                           const mx_quat rotation,
                           const mx_vec3 scale) {
-    mgfx_set_proj(proj);
-    mgfx_set_view(view);
+    mx_mat4 view_mtx, proj_mtx;
+    memcpy(view_mtx.val, view, sizeof(view_mtx.val));
+    memcpy(proj_mtx.val, proj, sizeof(proj_mtx.val));
 
-    mgfx_set_transform(mx_translate(position).val);
+    // Gizmos push the full transform so they draw with any target's view block.
+    mx_mat4 mvp = mx_mat4_mul(proj_mtx, mx_mat4_mul(view_mtx, mx_translate(position)));
+    mgfx_set_transform(mvp.val);
 
     mgfx_bind_vertex_buffer(MGFX_DEFAULT_CUBE_VBH);
     mgfx_bind_index_buffer(MGFX_DEFAULT_CUBE_IBH);
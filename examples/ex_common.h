@@ -44,6 +44,7 @@ extern double MGFX_TIME;
 extern double MGFX_TIME_DELTA_TIME;
 
 mgfx_th load_texture_2d_from_path(const char* path, VkFormat format);
+mgfx_th load_texture_2d_from_path_ex(const char* path, VkFormat format, mgfx_th placeholder);
 
 int mgfx_example_app();
 
@@ -2,11 +2,13 @@
 #include "ex_common.h"
 
 #include <GLFW/glfw3.h>
+#include <mx/mx_asserts.h>
 #include <mx/mx_log.h>
 
 #include <mx/mx_file.h>
 #include <mx/mx_memory.h>
 
+#include <math.h>
 #include <string.h>
 #include <vulkan/vulkan_core.h>
 
@@ -132,6 +134,29 @@ gltf_process_node(const cgltf_data* gltf, mx_mat4 parent_mtx, mgfx_scene* scene,
     }
 };
 
+// One storage buffer holds every material, shaders index it and the bindless texture array.
+static void scene_bindless_materials_create(mgfx_scene* scene) {
+    const size_t size = sizeof(mgfx_bindless_material) * scene->material_count;
+    mgfx_bindless_material* materials = mx_alloc(mx_default_allocator(), size);
+
+    for (uint32_t i = 0; i < scene->material_count; i++) {
+        const mgfx_material* mat = &scene->materials[i];
+
+        materials[i] = (mgfx_bindless_material){
+            .properties = mat->properties,
+            .albedo_texture = mgfx_texture_bindless_index(mat->albedo_texture),
+            .metallic_roughness_texture =
+                mgfx_texture_bindless_index(mat->metallic_roughness_texture),
+            .normal_texture = mgfx_texture_bindless_index(mat->normal_texture),
+            .occlusion_texture = mgfx_texture_bindless_index(mat->occlusion_texture),
+            .emissive_texture = mgfx_texture_bindless_index(mat->emissive_texture),
+        };
+    }
+
+    scene->materials_buffer = mgfx_storage_buffer_create(materials, size);
+    mx_free(mx_default_allocator(), materials);
+}
+
 #define MGFX_MAX_DIR_LEN 256
 void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene* scene) {
     static mx_scoped_allocator(15 * MX_MB) tmp = mx_scoped_allocator_create();
@@ -186,7 +211,7 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
                         mat->pbr_metallic_roughness.base_color_texture.texture - data->textures;
 
                     // Check if texture already loaded
-                    if ((VkImageView)scene->textures[tex_idx].idx == VK_NULL_HANDLE) {
+                    if (scene->textures[tex_idx].idx == 0) {
                         char absolute_path[MGFX_MAX_DIR_LEN];
                         strcpy(absolute_path, dir_name);
                         strcat(absolute_path, data->textures[tex_idx].image->uri);
@@ -221,7 +246,7 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
                         data->textures;
 
                     // Check if texture already loaded
-                    if ((VkImageView)scene->textures[tex_idx].idx == VK_NULL_HANDLE) {
+                    if (scene->textures[tex_idx].idx == 0) {
                         char absolute_path[MGFX_MAX_DIR_LEN];
                         strcpy(absolute_path, dir_name);
                         strcat(absolute_path, data->textures[tex_idx].image->uri);
@@ -239,13 +264,16 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
                     size_t tex_idx = mat->normal_texture.texture - data->textures;
 
                     // Check if texture already loaded
-                    if ((VkImageView)scene->textures[tex_idx].idx == VK_NULL_HANDLE) {
+                    if (scene->textures[tex_idx].idx == 0) {
                         char absolute_path[MGFX_MAX_DIR_LEN];
                         strcpy(absolute_path, dir_name);
                         strcat(absolute_path, data->textures[tex_idx].image->uri);
 
+                        // Flat normals until the normal map is streamed in.
                         scene->textures[tex_idx] =
-                            load_texture_2d_from_path(absolute_path, VK_FORMAT_R8G8B8A8_SRGB);
+                            load_texture_2d_from_path_ex(absolute_path,
+                                                         VK_FORMAT_R8G8B8A8_SRGB,
+                                                         s_default_normal_map);
                     }
 
                     scene->materials[i].normal_texture = scene->textures[tex_idx];
@@ -257,7 +285,7 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
                     size_t tex_idx = mat->occlusion_texture.texture - data->textures;
 
                     // Check if texture already loaded
-                    if ((VkImageView)scene->textures[tex_idx].idx == VK_NULL_HANDLE) {
+                    if (scene->textures[tex_idx].idx == 0) {
                         char absolute_path[MGFX_MAX_DIR_LEN];
                         strcpy(absolute_path, dir_name);
                         strcat(absolute_path, data->textures[tex_idx].image->uri);
@@ -275,7 +303,7 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
                     size_t tex_idx = mat->emissive_texture.texture - data->textures;
 
                     // Check if texture already loaded
-                    if ((VkImageView)scene->textures[tex_idx].idx == VK_NULL_HANDLE) {
+                    if (scene->textures[tex_idx].idx == 0) {
                         char absolute_path[MGFX_MAX_DIR_LEN];
                         strcpy(absolute_path, dir_name);
                         strcat(absolute_path, data->textures[tex_idx].image->uri);
@@ -301,6 +329,29 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
         exit(-1);
     }
 
+    // Merged geometry outlives the temp arena, it is released once uploaded.
+    const mx_bool merged = (flags & gltf_loader_flag_merged) == gltf_loader_flag_merged;
+    uint8_t* merged_vertices = NULL;
+    uint32_t* merged_indices = NULL;
+    uint32_t merged_vertex_count = 0;
+    uint32_t merged_index_count = 0;
+
+    if (merged) {
+        size_t total_vertex_count = 0;
+        size_t total_index_count = 0;
+        for (size_t mesh_idx = 0; mesh_idx < data->meshes_count; mesh_idx++) {
+            for (size_t i = 0; i < data->meshes[mesh_idx].primitives_count; i++) {
+                const cgltf_primitive* primitive = &data->meshes[mesh_idx].primitives[i];
+
+                total_vertex_count += primitive->attributes[0].data->count;
+                total_index_count += primitive->indices ? primitive->indices->count : 0;
+            }
+        }
+
+        merged_vertices = mx_alloc(mx_default_allocator(), total_vertex_count * scene->vl->stride);
+        merged_indices = mx_alloc(mx_default_allocator(), total_index_count * sizeof(uint32_t));
+    }
+
     scene->mesh_count = data->meshes_count;
     for (size_t mesh_idx = 0; mesh_idx < data->meshes_count; mesh_idx++) {
         const cgltf_mesh* mesh = &data->meshes[mesh_idx];
@@ -462,6 +513,38 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
                 MX_LOG_WARN("Mesh has no vertex colors.");
             }
 
+            const uint32_t position_offset =
+                scene->vl->attribute_offsets[MGFX_VERTEX_ATTRIBUTE_POSITION];
+            for (uint32_t v = 0; v < mesh_primitive->vertex_count; v++) {
+                const float* position =
+                    (float*)(mesh_primitive->vertices + v * vertex_size + position_offset);
+
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    if (v == 0 || position[axis] < mesh_primitive->aabb_min.elements[axis]) {
+                        mesh_primitive->aabb_min.elements[axis] = position[axis];
+                    }
+
+                    if (v == 0 || position[axis] > mesh_primitive->aabb_max.elements[axis]) {
+                        mesh_primitive->aabb_max.elements[axis] = position[axis];
+                    }
+                }
+            }
+
+            if (merged) {
+                mesh_primitive->first_index = merged_index_count;
+                mesh_primitive->vertex_offset = (int32_t)merged_vertex_count;
+
+                memcpy(merged_vertices + merged_vertex_count * vertex_size,
+                       mesh_primitive->vertices,
+                       mesh_primitive->vertex_count * vertex_size);
+                memcpy(merged_indices + merged_index_count,
+                       mesh_primitive->indices,
+                       mesh_primitive->index_count * sizeof(uint32_t));
+
+                merged_vertex_count += mesh_primitive->vertex_count;
+                merged_index_count += mesh_primitive->index_count;
+            }
+
             mesh_primitive->vbh = mgfx_vertex_buffer_create(
                 mesh_primitive->vertices, mesh_primitive->vertex_count * scene->vl->stride);
 
@@ -476,6 +559,16 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
         }
     }
 
+    if (merged) {
+        scene->vbh =
+            mgfx_vertex_buffer_create(merged_vertices, merged_vertex_count * scene->vl->stride);
+        scene->ibh =
+            mgfx_index_buffer_create(merged_indices, merged_index_count * sizeof(uint32_t));
+
+        mx_free(mx_default_allocator(), merged_vertices);
+        mx_free(mx_default_allocator(), merged_indices);
+    }
+
     assert(data->scenes > 0);
 
     cgltf_scene* cgltf_scene = &data->scenes[0];
@@ -489,7 +582,10 @@ void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene*
         gltf_process_node(data, identity, scene, cgltf_scene->nodes[root_idx]);
     };
 
-    if ((flags & gltf_loader_flag_materials) == gltf_loader_flag_materials) {
+    if ((flags & gltf_loader_flag_materials) == gltf_loader_flag_materials &&
+        (flags & gltf_loader_flag_bindless) == gltf_loader_flag_bindless) {
+        scene_bindless_materials_create(scene);
+    } else if ((flags & gltf_loader_flag_materials) == gltf_loader_flag_materials) {
         for (int mat_idx = 0; mat_idx < scene->material_count; mat_idx++) {
             mgfx_material* mat = &scene->materials[mat_idx];
 
@@ -533,7 +629,13 @@ void scene_destroy(mgfx_scene* scene) {
     }
 
     for (uint32_t i = 0; i < scene->material_count; i++) {
-        mgfx_buffer_destroy(scene->materials[i].properties_buffer.idx);
+        if (scene->materials[i].properties_buffer.idx != 0) {
+            mgfx_buffer_destroy(scene->materials[i].properties_buffer.idx);
+        }
+    }
+
+    if (scene->materials_buffer.idx != 0) {
+        mgfx_buffer_destroy(scene->materials_buffer.idx);
     }
 
     for (uint32_t i = 0; i < scene->mesh_count; i++) {
@@ -543,4 +645,142 @@ void scene_destroy(mgfx_scene* scene) {
             mgfx_buffer_destroy(scene->meshes[i].primitives[primitive_idx].ibh.idx);
         }
     }
+
+    if (scene->objects != NULL) {
+        mx_free(mx_default_allocator(), scene->objects);
+        mx_free(mx_default_allocator(), scene->bounds.center_x);
+    }
+
+    if (scene->cullh.idx != 0) {
+        mgfx_descriptor_destroy(scene->u_objects);
+        mgfx_cull_destroy(scene->cullh);
+    }
+
+    if (scene->vbh.idx != 0) {
+        mgfx_buffer_destroy(scene->vbh.idx);
+        mgfx_buffer_destroy(scene->ibh.idx);
+    }
+}
+
+void scene_bounds_create(mgfx_scene* scene, mx_mat4 transform) {
+    uint32_t object_count = 0;
+    for (uint32_t n = 0; n < scene->node_count; n++) {
+        if (scene->nodes[n].mesh != NULL) {
+            object_count += scene->nodes[n].mesh->primitive_count;
+        }
+    }
+
+    scene->objects = mx_alloc(mx_default_allocator(), object_count * sizeof(mgfx_scene_object));
+
+    // One allocation split into the six SoA arrays.
+    float* bounds = mx_alloc(mx_default_allocator(), object_count * sizeof(float) * 6);
+    scene->bounds = (mgfx_bounds){
+        .center_x = bounds,
+        .center_y = bounds + object_count,
+        .center_z = bounds + object_count * 2,
+        .extent_x = bounds + object_count * 3,
+        .extent_y = bounds + object_count * 4,
+        .extent_z = bounds + object_count * 5,
+        .count = 0,
+    };
+
+    for (uint32_t n = 0; n < scene->node_count; n++) {
+        if (scene->nodes[n].mesh == NULL) {
+            continue;
+        }
+
+        const mx_mat4 model = mx_mat4_mul(transform, scene->nodes[n].matrix);
+        const float* m = model.val;
+
+        for (uint32_t p = 0; p < scene->nodes[n].mesh->primitive_count; p++) {
+            const struct primitive* node_primitive = &scene->nodes[n].mesh->primitives[p];
+
+            if (node_primitive->index_count <= 0) {
+                continue;
+            }
+
+            float center[3], extent[3];
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                center[axis] = (node_primitive->aabb_min.elements[axis] +
+                                node_primitive->aabb_max.elements[axis]) *
+                               0.5f;
+                extent[axis] = (node_primitive->aabb_max.elements[axis] -
+                                node_primitive->aabb_min.elements[axis]) *
+                               0.5f;
+            }
+
+            // Transformed center, extents grow by the absolute rotation and scale.
+            float world_center[3], world_extent[3];
+            for (uint32_t row = 0; row < 3; row++) {
+                world_center[row] = m[12 + row];
+                world_extent[row] = 0.0f;
+
+                for (uint32_t col = 0; col < 3; col++) {
+                    world_center[row] += m[col * 4 + row] * center[col];
+                    world_extent[row] += fabsf(m[col * 4 + row]) * extent[col];
+                }
+            }
+
+            const uint32_t i = scene->bounds.count++;
+            scene->objects[i] = (mgfx_scene_object){
+                .node = &scene->nodes[n],
+                .primitive = node_primitive,
+            };
+
+            scene->bounds.center_x[i] = world_center[0];
+            scene->bounds.center_y[i] = world_center[1];
+            scene->bounds.center_z[i] = world_center[2];
+            scene->bounds.extent_x[i] = world_extent[0];
+            scene->bounds.extent_y[i] = world_extent[1];
+            scene->bounds.extent_z[i] = world_extent[2];
+        }
+    }
+}
+
+void scene_cull_create(mgfx_scene* scene, mx_mat4 transform, uint32_t view_count) {
+    MX_ASSERT(scene->vbh.idx != 0, "Scene cull requires merged geometry!");
+
+    uint32_t object_count = 0;
+    for (uint32_t n = 0; n < scene->node_count; n++) {
+        if (scene->nodes[n].mesh != NULL) {
+            object_count += scene->nodes[n].mesh->primitive_count;
+        }
+    }
+
+    mgfx_cull_object* objects =
+        mx_alloc(mx_default_allocator(), object_count * sizeof(mgfx_cull_object));
+
+    object_count = 0;
+    for (uint32_t n = 0; n < scene->node_count; n++) {
+        if (scene->nodes[n].mesh == NULL) {
+            continue;
+        }
+
+        const mx_mat4 model = mx_mat4_mul(transform, scene->nodes[n].matrix);
+        for (uint32_t p = 0; p < scene->nodes[n].mesh->primitive_count; p++) {
+            const struct primitive* node_primitive = &scene->nodes[n].mesh->primitives[p];
+
+            if (node_primitive->index_count <= 0) {
+                continue;
+            }
+
+            mgfx_cull_object* object = &objects[object_count++];
+            memset(object, 0, sizeof(mgfx_cull_object));
+
+            memcpy(object->model, model.val, sizeof(object->model));
+            memcpy(object->aabb_min, node_primitive->aabb_min.elements, sizeof(float) * 3);
+            memcpy(object->aabb_max, node_primitive->aabb_max.elements, sizeof(float) * 3);
+
+            object->batch = (uint32_t)(node_primitive->material - scene->materials);
+            object->index_count = node_primitive->index_count;
+            object->first_index = node_primitive->first_index;
+            object->vertex_offset = node_primitive->vertex_offset;
+        }
+    }
+
+    scene->cullh = mgfx_cull_create(objects, object_count, scene->material_count, view_count);
+    mx_free(mx_default_allocator(), objects);
+
+    scene->u_objects = mgfx_descriptor_create("objects", VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    mgfx_set_storage_buffer(scene->u_objects, mgfx_cull_objects(scene->cullh));
 }
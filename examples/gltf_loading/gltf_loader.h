@@ -52,6 +52,18 @@ typedef struct mgfx_material {
     mgfx_material_flags flags;
 } mgfx_material;
 
+// Layout of `material_data` in lit_bindless.frag.glsl, textures are bindless indices.
+typedef struct mgfx_bindless_material {
+    struct properties properties;
+
+    uint32_t albedo_texture;
+    uint32_t metallic_roughness_texture;
+    uint32_t normal_texture;
+    uint32_t occlusion_texture;
+    uint32_t emissive_texture;
+    uint32_t padding[3];
+} mgfx_bindless_material;
+
 enum { MGFX_MESH_MAX_PRIMITIVES = 128 };
 typedef struct mgfx_mesh {
     struct primitive {
@@ -64,6 +76,14 @@ typedef struct mgfx_mesh {
         uint32_t* indices;
         uint32_t index_count;
 
+        // Local space bounds.
+        mx_vec3 aabb_min;
+        mx_vec3 aabb_max;
+
+        // Location in the scene merged buffers, see gltf_loader_flag_merged.
+        uint32_t first_index;
+        int32_t vertex_offset;
+
         const mgfx_material* material;
         const mgfx_vertex_layout* vl;
     } primitives[MGFX_MESH_MAX_PRIMITIVES];
@@ -77,6 +97,11 @@ typedef struct mgfx_node {
     const mgfx_mesh* mesh;
 } mgfx_node;
 
+typedef struct mgfx_scene_object {
+    const mgfx_node* node;
+    const struct primitive* primitive;
+} mgfx_scene_object;
+
 enum { MGFX_SCENE_MAX_NODES = 128 };
 enum { MGFX_SCENE_MAX_ROOTS = 32 };
 enum { MGFX_SCENE_MAX_MATERIALS = 128 };
@@ -95,9 +120,24 @@ typedef struct mgfx_scene {
     mgfx_material materials[MGFX_SCENE_MAX_MATERIALS];
     uint32_t material_count;
 
+    // Every material as mgfx_bindless_material, valid with gltf_loader_flag_bindless.
+    mgfx_sbh materials_buffer;
+
     mgfx_mesh meshes[MGFX_SCENE_MAX_MESHES];
     uint32_t mesh_count;
 
+    // Every primitive packed together, valid with gltf_loader_flag_merged.
+    mgfx_vbh vbh;
+    mgfx_ibh ibh;
+
+    // World space bounds of every node primitive, see scene_bounds_create.
+    mgfx_scene_object* objects;
+    mgfx_bounds bounds;
+
+    // Gpu culled nodes, see scene_cull_create.
+    mgfx_cullh cullh;
+    mgfx_dh u_objects;
+
     const mgfx_vertex_layout* vl;
     /*mx_arena allocator;*/
 } mgfx_scene;
@@ -111,6 +151,11 @@ typedef enum gltf_loader_flags {
         gltf_loader_flag_textures | gltf_loader_flag_materials | gltf_loader_flag_meshes,
 
     gltf_loader_flag_flip_winding = 1 << 3,
+    gltf_loader_flag_merged = 1 << 4,
+
+    // Materials are packed into `materials_buffer` instead of creating descriptors, draws push
+    // its bindless index and their material index. Requires mgfx_bindless_enabled.
+    gltf_loader_flag_bindless = 1 << 5,
 
     gltf_loader_flag_max_enum = 0xFF
 } gltf_loader_flags;
@@ -118,6 +163,13 @@ typedef enum gltf_loader_flags {
 void load_scene_from_path(const char* path, gltf_loader_flags flags, mgfx_scene* scene);
 void scene_destroy(mgfx_scene* scene);
 
+// Computes world space bounds for every node primitive to cull on the cpu.
+void scene_bounds_create(mgfx_scene* scene, mx_mat4 transform);
+
+// Creates a cull set with one object per node primitive, batched by material.
+// Requires a scene loaded with gltf_loader_flag_merged.
+void scene_cull_create(mgfx_scene* scene, mx_mat4 transform, uint32_t view_count);
+
 #define LOAD_GLTF_MODEL(model_name, gltf_flags, gltf_ptr)                                          \
     load_scene_from_path(                                                                          \
         GLTF_MODELS_PATH model_name "/glTF/" model_name ".gltf", gltf_flags, gltf_ptr)
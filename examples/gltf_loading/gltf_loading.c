@@ -5,6 +5,7 @@
 #include <mx/mx_asserts.h>
 #include <mx/mx_math.h>
 #include <mx/mx_math_mtx.h>
+#include <mx/mx_memory.h>
 
 #include <GLFW/glfw3.h>
 
@@ -26,6 +27,11 @@ mgfx_th color_fba_texture;
 mgfx_dh u_color_fba;
 
 mgfx_scene gltf_scene;
+uint32_t* visible_objects;
+
+// Materials are read through the bindless arrays when the device supports them.
+mx_bool bindless;
+uint32_t materials_buffer_index;
 
 void mgfx_example_init() {
     struct mgfx_image_info color_attachment_info = {
@@ -55,8 +61,11 @@ void mgfx_example_init() {
     mgfx_set_view_target(0, fbh);
     mgfx_set_view_clear(0, (float[]){0.0f, 0.0f, 0.0f, 1.0f});
 
+    bindless = mgfx_bindless_enabled();
+
     fp_vs = mgfx_shader_create(MGFX_ASSET_PATH "shaders/lit.vert.glsl.spv");
-    fp_fs = mgfx_shader_create(MGFX_ASSET_PATH "shaders/lit.frag.glsl.spv");
+    fp_fs = mgfx_shader_create(bindless ? MGFX_ASSET_PATH "shaders/lit_bindless.frag.glsl.spv"
+                                        : MGFX_ASSET_PATH "shaders/lit.frag.glsl.spv");
     fp_program = mgfx_program_create_graphics(fp_vs, fp_fs);
 
     mgfx_vertex_layout vl;
@@ -71,7 +80,18 @@ void mgfx_example_init() {
 
     gltf_scene.vl = &vl;
 
-    LOAD_GLTF_MODEL("DamagedHelmet", gltf_loader_flag_default, &gltf_scene);
+    LOAD_GLTF_MODEL("DamagedHelmet",
+                    bindless ? gltf_loader_flag_default | gltf_loader_flag_bindless
+                             : gltf_loader_flag_default,
+                    &gltf_scene);
+
+    if (bindless) {
+        materials_buffer_index = mgfx_buffer_bindless_index(gltf_scene.materials_buffer);
+    }
+
+    scene_bounds_create(&gltf_scene, MX_MAT4_IDENTITY);
+    visible_objects =
+        mx_alloc(mx_default_allocator(), gltf_scene.bounds.count * sizeof(uint32_t));
 
     quad_vsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/blit.vert.glsl.spv");
     quad_fsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/blit.frag.glsl.spv");
@@ -104,42 +124,45 @@ void mgfx_example_update() {
         APP_WIDTH * 0.8f, APP_HEIGHT * 0.95f, "delta time: %.2f ms", last_value * 1000.0f);
     mgfx_debug_draw_text(APP_WIDTH * 0.8f, APP_HEIGHT * 0.9f, "fps time: %.2f", 1.0f / last_value);
 
-    for (uint32_t n = 0; n < gltf_scene.node_count; n++) {
-        if (gltf_scene.nodes[n].mesh == NULL) {
-            continue;
-        }
+    const uint32_t visible_count =
+        mgfx_frustum_cull(g_example_camera.view_proj.val, &gltf_scene.bounds, visible_objects);
 
-        MX_ASSERT(gltf_scene.nodes[n].mesh->primitive_count > 0);
+    mgfx_set_view_transform(0, g_example_camera.view.val, g_example_camera.proj.val);
 
-        for (uint32_t p = 0; p < gltf_scene.nodes[n].mesh->primitive_count; p++) {
-            const struct primitive* node_primitive = &gltf_scene.nodes[n].mesh->primitives[p];
+    for (uint32_t i = 0; i < visible_count; i++) {
+        const mgfx_scene_object* object = &gltf_scene.objects[visible_objects[i]];
+        const struct primitive* node_primitive = object->primitive;
 
-            if (node_primitive->index_count <= 0) {
-                continue;
-            }
+        mgfx_set_transform(object->node->matrix.val);
 
-            mgfx_set_proj(g_example_camera.proj.val);
-            mgfx_set_view(g_example_camera.view.val);
-
-            mgfx_set_transform(gltf_scene.nodes[n].matrix.val);
-
-            mgfx_bind_vertex_buffer(node_primitive->vbh);
-            mgfx_bind_index_buffer(node_primitive->ibh);
+        mgfx_bind_vertex_buffer(node_primitive->vbh);
+        mgfx_bind_index_buffer(node_primitive->ibh);
 
+        if (bindless) {
+            const uint32_t indices[MGFX_BINDLESS_INDEX_COUNT] = {
+                materials_buffer_index,
+                (uint32_t)(node_primitive->material - gltf_scene.materials),
+            };
+            mgfx_set_bindless_indices(indices);
+        } else {
             mgfx_bind_descriptor(0, node_primitive->material->u_properties_buffer);
             mgfx_bind_descriptor(0, node_primitive->material->u_albedo_texture);
             mgfx_bind_descriptor(0, node_primitive->material->u_metallic_roughness_texture);
             mgfx_bind_descriptor(0, node_primitive->material->u_normal_texture);
             mgfx_bind_descriptor(0, node_primitive->material->u_occlusion_texture);
             mgfx_bind_descriptor(0, node_primitive->material->u_emissive_texture);
-
-            mgfx_submit(0, fp_program);
         }
+
+        mgfx_submit(0, fp_program);
     }
 
+    mgfx_debug_draw_text(APP_WIDTH * 0.8f,
+                         APP_HEIGHT * 0.85f,
+                         "visible: %u/%u",
+                         visible_count,
+                         gltf_scene.bounds.count);
+
     // Blit to backbuffer
-    mgfx_set_proj(MX_MAT4_IDENTITY.val);
-    mgfx_set_view(MX_MAT4_IDENTITY.val);
     mgfx_set_transform(MX_MAT4_IDENTITY.val);
 
     mgfx_bind_vertex_buffer(quad_vbh);
@@ -155,6 +178,7 @@ void mgfx_example_shutdown() {
     mgfx_texture_destroy(color_fba_texture, MX_FALSE);
     mgfx_image_destroy(color_fba);
 
+    mx_free(mx_default_allocator(), visible_objects);
     scene_destroy(&gltf_scene);
 
     mgfx_program_destroy(fp_program);
@@ -0,0 +1,167 @@
+#include "ex_common.h"
+
+#include <GLFW/glfw3.h>
+
+#include <mx/mx.h>
+#include <mx/mx_hash.h>
+#include <mx/mx_log.h>
+#include <mx/mx_memory.h>
+
+#include <string.h>
+
+#include "handle_pool.h"
+
+// Measures the cpu cost of resolving a resource handle. Before: uthash tables keyed by pointer
+// handles with one allocation per entry. After: generational handle pools indexed by slot.
+
+typedef struct benchmark_value {
+    uint64_t pipeline;
+    uint64_t pipeline_layout;
+    uint64_t dsls[4];
+    uint16_t id;
+} benchmark_value;
+
+typedef struct benchmark_entry {
+    uint64_t key;
+    benchmark_value value;
+    UT_hash_handle hh;
+} benchmark_entry;
+
+typedef struct benchmark_stage {
+    uint32_t handle_count;
+
+    double hash_ns;
+    double pool_ns;
+} benchmark_stage;
+
+enum { BENCHMARK_LOOKUPS = 1 << 22 };
+
+static benchmark_stage s_stages[] = {
+    {.handle_count = 100},
+    {.handle_count = 1000},
+    {.handle_count = 10000},
+    {.handle_count = 60000},
+};
+static const uint32_t k_stage_count = sizeof(s_stages) / sizeof(benchmark_stage);
+
+// Lookups visit handles in a scrambled order, as draws reference resources in submit order.
+static uint32_t* s_order;
+
+static void benchmark_order_create(uint32_t handle_count) {
+    uint32_t state = 0x9E3779B9u;
+    for (uint32_t i = 0; i < BENCHMARK_LOOKUPS; i++) {
+        state = state * 1664525u + 1013904223u;
+        s_order[i] = (state >> 8) % handle_count;
+    }
+}
+
+static double benchmark_hash(uint32_t handle_count, uint64_t* checksum) {
+    mx_allocator_t allocator = mx_default_allocator();
+
+    benchmark_entry* table = NULL;
+    uint64_t* handles = mx_alloc(allocator, handle_count * sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < handle_count; i++) {
+        benchmark_entry* entry = mx_alloc(allocator, sizeof(benchmark_entry));
+        memset(entry, 0, sizeof(benchmark_entry));
+
+        entry->key = (uint64_t)entry;
+        entry->value.id = (uint16_t)i;
+        HASH_ADD(hh, table, key, sizeof(uint64_t), entry);
+
+        handles[i] = entry->key;
+    }
+
+    const double start = glfwGetTime();
+
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < BENCHMARK_LOOKUPS; i++) {
+        benchmark_entry* entry;
+        HASH_FIND(hh, table, &handles[s_order[i]], sizeof(uint64_t), entry);
+        sum += entry->value.id;
+    }
+
+    const double elapsed = glfwGetTime() - start;
+
+    benchmark_entry *entry, *tmp;
+    HASH_ITER(hh, table, entry, tmp) {
+        HASH_DEL(table, entry);
+        mx_free(allocator, entry);
+    }
+    mx_free(allocator, handles);
+
+    *checksum = sum;
+    return elapsed;
+}
+
+static double benchmark_pool(uint32_t handle_count, uint64_t* checksum) {
+    mx_allocator_t allocator = mx_default_allocator();
+
+    handle_pool pool;
+    handle_pool_init(&pool, sizeof(benchmark_value), handle_count);
+    uint64_t* handles = mx_alloc(allocator, handle_count * sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < handle_count; i++) {
+        benchmark_value* value;
+        handles[i] = handle_pool_alloc(&pool, (void**)&value);
+        value->id = (uint16_t)i;
+    }
+
+    const double start = glfwGetTime();
+
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < BENCHMARK_LOOKUPS; i++) {
+        const benchmark_value* value = handle_pool_get(&pool, handles[s_order[i]]);
+        sum += value->id;
+    }
+
+    const double elapsed = glfwGetTime() - start;
+
+    mx_free(allocator, handles);
+    handle_pool_destroy(&pool);
+
+    *checksum = sum;
+    return elapsed;
+}
+
+void mgfx_example_init() {
+    s_order = mx_alloc(mx_default_allocator(), BENCHMARK_LOOKUPS * sizeof(uint32_t));
+
+    for (uint32_t stage_idx = 0; stage_idx < k_stage_count; stage_idx++) {
+        benchmark_stage* stage = &s_stages[stage_idx];
+        benchmark_order_create(stage->handle_count);
+
+        uint64_t hash_checksum, pool_checksum;
+        stage->hash_ns = benchmark_hash(stage->handle_count, &hash_checksum) * 1e9 /
+                         BENCHMARK_LOOKUPS;
+        stage->pool_ns = benchmark_pool(stage->handle_count, &pool_checksum) * 1e9 /
+                         BENCHMARK_LOOKUPS;
+
+        if (hash_checksum != pool_checksum) {
+            MX_LOG_ERROR("[HandleBenchmark] Lookups resolved different values!");
+        }
+
+        MX_LOG_INFO("[HandleBenchmark] %6u handles | uthash %6.2f ns/lookup | pool %6.2f ns/lookup",
+                    stage->handle_count,
+                    stage->hash_ns,
+                    stage->pool_ns);
+    }
+
+    mx_free(mx_default_allocator(), s_order);
+}
+
+void mgfx_example_update() {
+    for (uint32_t stage_idx = 0; stage_idx < k_stage_count; stage_idx++) {
+        const benchmark_stage* stage = &s_stages[stage_idx];
+        mgfx_debug_draw_text(0,
+                             APP_HEIGHT * (0.95f - 0.05f * stage_idx),
+                             "%u handles: uthash %.2f ns pool %.2f ns",
+                             stage->handle_count,
+                             stage->hash_ns,
+                             stage->pool_ns);
+    }
+}
+
+void mgfx_example_shutdown() {}
+
+int main() { mgfx_example_app(); }
@@ -221,11 +221,10 @@ void mgfx_example_update() {
     mgfx_set_transform(mx_mat4_mul(translate, rot).val);
 
     /*mx_mat4 view = mx_look_at((mx_vec3){.z = 2.0f}, (mx_vec3){0}, MX_VEC3_UP);*/
-    /*mgfx_set_view(view.val);*/
     /*mx_mat4 proj = mx_perspective(MX_DEG_TO_RAD(60.0), 16.0 / 9.0, 0.1, 1000.0f);*/
-    /*mgfx_set_proj(proj.val);*/
-    mgfx_set_view(g_example_camera.view.val);
-    mgfx_set_proj(g_example_camera.proj.val);
+    /*mgfx_set_view_transform(MGFX_DEFAULT_VIEW_TARGET, view.val, proj.val);*/
+    mgfx_set_view_transform(
+        MGFX_DEFAULT_VIEW_TARGET, g_example_camera.view.val, g_example_camera.proj.val);
 
     mgfx_submit(MGFX_DEFAULT_VIEW_TARGET, panoramic_ph);
 }
@@ -121,6 +121,8 @@ mgfx_ibh quad_ibh;
 mgfx_th mesh_pass_cattachment_th;
 mgfx_dh u_mesh_pass_cattachment;
 
+enum { SHADOW_CULL_VIEW = 0, MESH_CULL_VIEW = 1, CULL_VIEW_COUNT = 2 };
+
 mgfx_scene sponza;
 mgfx_scene helmet;
 void mgfx_example_init() {
@@ -238,10 +240,22 @@ void mgfx_example_init() {
     vertex_layout_end(&vl);
 
     helmet.vl = &vl;
-    LOAD_GLTF_MODEL("DamagedHelmet", gltf_loader_flag_default, &helmet);
+    LOAD_GLTF_MODEL("DamagedHelmet", gltf_loader_flag_default | gltf_loader_flag_merged, &helmet);
 
     sponza.vl = &vl;
-    LOAD_GLTF_MODEL("Sponza", gltf_loader_flag_default, &sponza);
+    LOAD_GLTF_MODEL("Sponza", gltf_loader_flag_default | gltf_loader_flag_merged, &sponza);
+
+    // Static object transforms, nodes are culled and drawn on the gpu.
+    const mx_mat4 sponza_transform = mx_mat4_mul(mx_translate((mx_vec3){0.0f, 0.0f, 0.0f}),
+                                                 mx_scale((mx_vec3){1.0f, 1.0f, 1.0f}));
+
+    const mx_mat4 helmet_transform =
+        mx_mat4_mul(mx_mat4_mul(mx_translate((mx_vec3){0.0f, 1.5f, 0.0f}),
+                                mx_mat4_rotate_euler(MX_DEG_TO_RAD(-90), MX_VEC3_UP)),
+                    mx_scale((mx_vec3){1.0f, 1.0f, 1.0f}));
+
+    scene_cull_create(&sponza, sponza_transform, CULL_VIEW_COUNT);
+    scene_cull_create(&helmet, helmet_transform, CULL_VIEW_COUNT);
 
     // Blit pass
     blit_vs = mgfx_shader_create(MGFX_ASSET_PATH "shaders/blit.vert.glsl.spv");
@@ -315,46 +329,32 @@ void mgfx_example_init() {
     // ----- Post Processing -----
 }
 
-void draw_scene(mgfx_scene* scene,
-                uint32_t target,
-                mgfx_ph ph,
-                mx_mat4 parent_transform,
-                mx_bool is_shadow_pass) {
-    for (uint32_t n = 0; n < scene->node_count; n++) {
-        if (scene->nodes[n].mesh == NULL) {
-            continue;
-        }
-
-        MX_ASSERT(scene->nodes[n].mesh->primitive_count > 0);
-
-        for (uint32_t p = 0; p < scene->nodes[n].mesh->primitive_count; p++) {
-            const struct primitive* node_primitive = &scene->nodes[n].mesh->primitives[p];
-
-            if (node_primitive->index_count <= 0) {
-                continue;
-            }
-
-            mgfx_set_transform(mx_mat4_mul(parent_transform, scene->nodes[n].matrix).val);
+void draw_scene(mgfx_scene* scene, uint32_t target, mgfx_ph ph, uint32_t view) {
+    for (uint32_t m = 0; m < scene->material_count; m++) {
+        const mgfx_material* material = &scene->materials[m];
 
-            mgfx_bind_vertex_buffer(node_primitive->vbh);
-            mgfx_bind_index_buffer(node_primitive->ibh);
+        mgfx_bind_vertex_buffer(scene->vbh);
+        mgfx_bind_index_buffer(scene->ibh);
 
-            if (!is_shadow_pass) {
-                mgfx_bind_descriptor(0, u_scene_data);
-                mgfx_bind_descriptor(0, u_sun_light);
-                mgfx_bind_descriptor(0, u_point_lights);
-                mgfx_bind_descriptor(0, u_shadow_map);
-
-                mgfx_bind_descriptor(1, node_primitive->material->u_properties_buffer);
-                mgfx_bind_descriptor(1, node_primitive->material->u_albedo_texture);
-                mgfx_bind_descriptor(1, node_primitive->material->u_metallic_roughness_texture);
-                mgfx_bind_descriptor(1, node_primitive->material->u_normal_texture);
-                mgfx_bind_descriptor(1, node_primitive->material->u_occlusion_texture);
-                mgfx_bind_descriptor(1, node_primitive->material->u_emissive_texture);
-            }
-
-            mgfx_submit(target, ph);
+        if (view == SHADOW_CULL_VIEW) {
+            mgfx_bind_descriptor(0, scene->u_objects);
+        } else {
+            mgfx_bind_descriptor(0, u_scene_data);
+            mgfx_bind_descriptor(0, u_sun_light);
+            mgfx_bind_descriptor(0, u_point_lights);
+            mgfx_bind_descriptor(0, u_shadow_map);
+
+            mgfx_bind_descriptor(1, material->u_properties_buffer);
+            mgfx_bind_descriptor(1, material->u_albedo_texture);
+            mgfx_bind_descriptor(1, material->u_metallic_roughness_texture);
+            mgfx_bind_descriptor(1, material->u_normal_texture);
+            mgfx_bind_descriptor(1, material->u_occlusion_texture);
+            mgfx_bind_descriptor(1, material->u_emissive_texture);
+
+            mgfx_bind_descriptor(2, scene->u_objects);
         }
+
+        mgfx_submit_culled(target, ph, scene->cullh, view, m);
     }
 }
 
@@ -379,15 +379,6 @@ void mgfx_example_update() {
     sun_light.data.direction = mx_vec3_norm(sun_light.data.direction);
     mgfx_buffer_update(sun_light_buffer.idx, &sun_light.data, sizeof(sun_light.data), 0);
 
-    // Update object transforms
-    mx_mat4 sponza_transform = mx_mat4_mul(mx_translate((mx_vec3){0.0f, 0.0f, 0.0f}),
-                                           mx_scale((mx_vec3){1.0f, 1.0f, 1.0f}));
-
-    mx_mat4 helmet_transform =
-        mx_mat4_mul(mx_mat4_mul(mx_translate((mx_vec3){0.0f, 1.5f, 0.0f}),
-                                mx_mat4_rotate_euler(MX_DEG_TO_RAD(-90), MX_VEC3_UP)),
-                    mx_scale((mx_vec3){1.0f, 1.0f, 1.0f}));
-
     // Draw shadow pass
     mx_vec3 neg_dir = mx_vec3_scale(sun_light.data.direction, -1.0f);
 
@@ -401,18 +392,24 @@ void mgfx_example_update() {
 
     memcpy(sun_light.data.light_space_matrix, sun_light.camera.view_proj.val, sizeof(float) * 16);
 
-    mgfx_set_proj(sun_light.camera.proj.val);
-    mgfx_set_view(sun_light.camera.view.val);
+    mgfx_set_view_transform(
+        SHADOW_FRAME_TARGET, sun_light.camera.view.val, sun_light.camera.proj.val);
 
-    draw_scene(&sponza, SHADOW_FRAME_TARGET, shadow_pass_program, sponza_transform, MX_TRUE);
-    draw_scene(&helmet, SHADOW_FRAME_TARGET, shadow_pass_program, helmet_transform, MX_TRUE);
+    mgfx_cull_view(sponza.cullh, SHADOW_CULL_VIEW, sun_light.camera.view_proj.val);
+    mgfx_cull_view(helmet.cullh, SHADOW_CULL_VIEW, sun_light.camera.view_proj.val);
+
+    draw_scene(&sponza, SHADOW_FRAME_TARGET, shadow_pass_program, SHADOW_CULL_VIEW);
+    draw_scene(&helmet, SHADOW_FRAME_TARGET, shadow_pass_program, SHADOW_CULL_VIEW);
 
     // Draw mesh pass
-    mgfx_set_proj(g_example_camera.proj.val);
-    mgfx_set_view(g_example_camera.view.val);
+    mgfx_set_view_transform(
+        MESH_FRAME_TARGET, g_example_camera.view.val, g_example_camera.proj.val);
+
+    mgfx_cull_view(sponza.cullh, MESH_CULL_VIEW, g_example_camera.view_proj.val);
+    mgfx_cull_view(helmet.cullh, MESH_CULL_VIEW, g_example_camera.view_proj.val);
 
-    draw_scene(&sponza, MESH_FRAME_TARGET, mesh_pass_program, sponza_transform, MX_FALSE);
-    draw_scene(&helmet, MESH_FRAME_TARGET, mesh_pass_program, helmet_transform, MX_FALSE);
+    draw_scene(&sponza, MESH_FRAME_TARGET, mesh_pass_program, MESH_CULL_VIEW);
+    draw_scene(&helmet, MESH_FRAME_TARGET, mesh_pass_program, MESH_CULL_VIEW);
 
     // ----- Post Processing -----
 
@@ -0,0 +1,203 @@
+#include "ex_common.h"
+
+#include <GLFW/glfw3.h>
+
+#include <mx/mx_log.h>
+#include <mx/mx_math.h>
+#include <mx/mx_math_mtx.h>
+
+// Creates and destroys buffers and textures every frame while drawing with them. Destruction is
+// deferred to the frame's fence, so frame times should stay flat instead of spiking on every
+// destroy that used to idle the device.
+
+typedef struct stress_vertex {
+    float position[3];
+    float uv_x;
+    float normal[3];
+    float uv_y;
+    float color[4];
+} stress_vertex;
+
+static stress_vertex k_vertices[] = {
+    {{-0.5f, -0.5f, 0.5f}, 0.0f, {0.0f, 0.0f, 1.0f}, 0.0f, {1.0f, 0.0f, 0.0f, 1.0f}},
+    {{0.5f, -0.5f, 0.5f}, 1.0f, {0.0f, 0.0f, 1.0f}, 0.0f, {0.0f, 1.0f, 0.0f, 1.0f}},
+    {{0.5f, 0.5f, 0.5f}, 1.0f, {0.0f, 0.0f, 1.0f}, 1.0f, {0.0f, 0.0f, 1.0f, 1.0f}},
+    {{-0.5f, 0.5f, 0.5f}, 0.0f, {0.0f, 0.0f, 1.0f}, 1.0f, {1.0f, 1.0f, 0.0f, 1.0f}},
+};
+
+static uint32_t k_indices[] = {0, 1, 2, 2, 3, 0};
+
+// Batches live for a few frames so their uploads are recorded before they are released.
+enum { STRESS_BATCH_LIFETIME = 3 };
+enum { STRESS_BUFFERS_PER_FRAME = 32 };
+enum { STRESS_TEXTURES_PER_FRAME = 16 };
+enum { STRESS_TEXTURE_SIZE = 64 };
+
+typedef struct stress_batch {
+    mgfx_vbh vbhs[STRESS_BUFFERS_PER_FRAME];
+    mgfx_ibh ibhs[STRESS_BUFFERS_PER_FRAME];
+    mgfx_th ths[STRESS_TEXTURES_PER_FRAME];
+    mx_bool alive;
+} stress_batch;
+
+static stress_batch s_batches[STRESS_BATCH_LIFETIME];
+static uint32_t s_batch_idx = 0;
+
+static uint8_t s_texture_data[STRESS_TEXTURE_SIZE * STRESS_TEXTURE_SIZE * 4];
+
+static mgfx_sh vsh, fsh;
+static mgfx_ph ph;
+
+// Stats are accumulated over one second windows.
+static double s_window_start = 0.0;
+static double s_window_frame_max = 0.0;
+static uint32_t s_window_frames = 0;
+static uint32_t s_window_destroyed = 0;
+
+static double s_last_frame_time = 0.0;
+static double s_frame_max = 0.0;
+static double s_frame_avg = 0.0;
+static uint32_t s_destroyed_per_second = 0;
+
+static void stress_batch_create(stress_batch* batch, uint32_t frame) {
+    for (uint32_t i = 0; i < STRESS_BUFFERS_PER_FRAME; i++) {
+        batch->vbhs[i] = mgfx_vertex_buffer_create(k_vertices, sizeof(k_vertices));
+        batch->ibhs[i] = mgfx_index_buffer_create(k_indices, sizeof(k_indices));
+    }
+
+    for (uint32_t i = 0; i < sizeof(s_texture_data); i++) {
+        s_texture_data[i] = (uint8_t)(i + frame);
+    }
+
+    const mgfx_image_info texture_info = {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .width = STRESS_TEXTURE_SIZE,
+        .height = STRESS_TEXTURE_SIZE,
+        .layers = 1,
+        .cube_map = MX_FALSE,
+    };
+
+    for (uint32_t i = 0; i < STRESS_TEXTURES_PER_FRAME; i++) {
+        batch->ths[i] = mgfx_texture_create_from_memory(
+            &texture_info, VK_FILTER_NEAREST, s_texture_data, sizeof(s_texture_data));
+    }
+
+    batch->alive = MX_TRUE;
+}
+
+static uint32_t stress_batch_destroy(stress_batch* batch) {
+    if (!batch->alive) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < STRESS_BUFFERS_PER_FRAME; i++) {
+        mgfx_buffer_destroy(batch->vbhs[i].idx);
+        mgfx_buffer_destroy(batch->ibhs[i].idx);
+    }
+
+    for (uint32_t i = 0; i < STRESS_TEXTURES_PER_FRAME; i++) {
+        mgfx_texture_destroy(batch->ths[i], MX_TRUE);
+    }
+
+    batch->alive = MX_FALSE;
+
+    // Each texture releases an image, a view and a sampler.
+    return STRESS_BUFFERS_PER_FRAME * 2 + STRESS_TEXTURES_PER_FRAME * 3;
+}
+
+void mgfx_example_init() {
+    vsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/unlit.vert.glsl.spv");
+    fsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/unlit.frag.glsl.spv");
+    ph = mgfx_program_create_graphics(vsh, fsh);
+
+    g_example_camera.position = (mx_vec3){0.0f, 0.0f, 12.0f};
+
+    s_window_start = s_last_frame_time = glfwGetTime();
+}
+
+void mgfx_example_update() {
+    static uint32_t s_frame = 0;
+
+    const double now = glfwGetTime();
+    const double frame_time = now - s_last_frame_time;
+    s_last_frame_time = now;
+
+    s_window_frame_max = frame_time > s_window_frame_max ? frame_time : s_window_frame_max;
+    s_window_frames++;
+
+    // The oldest batch is released while frames still in flight may be drawing it.
+    stress_batch* batch = &s_batches[s_batch_idx];
+    s_window_destroyed += stress_batch_destroy(batch);
+    stress_batch_create(batch, s_frame++);
+    s_batch_idx = (s_batch_idx + 1) % STRESS_BATCH_LIFETIME;
+
+    if (now - s_window_start >= 1.0) {
+        s_frame_max = s_window_frame_max;
+        s_frame_avg = (now - s_window_start) / s_window_frames;
+        s_destroyed_per_second = (uint32_t)(s_window_destroyed / (now - s_window_start));
+
+        MX_LOG_INFO("[ResourceStress] %u objects destroyed/s | frame avg %.2f ms max %.2f ms",
+                    s_destroyed_per_second,
+                    s_frame_avg * 1000.0,
+                    s_frame_max * 1000.0);
+
+        s_window_start = now;
+        s_window_frame_max = 0.0;
+        s_window_frames = 0;
+        s_window_destroyed = 0;
+    }
+
+    mgfx_set_view_transform(
+        MGFX_DEFAULT_VIEW_TARGET, g_example_camera.view.val, g_example_camera.proj.val);
+
+    // Draw with every live batch, including buffers created this frame.
+    uint32_t draw_idx = 0;
+    for (uint32_t batch_idx = 0; batch_idx < STRESS_BATCH_LIFETIME; batch_idx++) {
+        const stress_batch* live = &s_batches[batch_idx];
+        if (!live->alive) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < STRESS_BUFFERS_PER_FRAME; i++, draw_idx++) {
+            const float x = (float)(draw_idx % 12) - 6.0f;
+            const float y = (float)(draw_idx / 12) - 4.0f;
+
+            mx_mat4 model = mx_mat4_mul(mx_translate((mx_vec3){x, y, 0.0f}),
+                                        mx_scale((mx_vec3){0.8f, 0.8f, 0.8f}));
+            mgfx_set_transform(model.val);
+
+            mgfx_bind_vertex_buffer(live->vbhs[i]);
+            mgfx_bind_index_buffer(live->ibhs[i]);
+
+            mgfx_submit(MGFX_DEFAULT_VIEW_TARGET, ph);
+        }
+    }
+
+    mgfx_debug_draw_text(0,
+                         APP_HEIGHT * 0.95f,
+                         "destroyed: %u/s frame avg: %.2f ms max: %.2f ms",
+                         s_destroyed_per_second,
+                         s_frame_avg * 1000.0,
+                         s_frame_max * 1000.0);
+
+    const mgfx_stats* stats = mgfx_get_stats();
+    mgfx_debug_draw_text(0,
+                         APP_HEIGHT * 0.90f,
+                         "staging: %.1f kb avg %.1f kb peak %.1f kb held %.1f kb deferred",
+                         stats->staging_bytes_average / MX_KB,
+                         (double)stats->staging_bytes_peak / MX_KB,
+                         (double)stats->staging_capacity / MX_KB,
+                         (double)stats->staging_deferred_bytes / MX_KB);
+}
+
+void mgfx_example_shutdown() {
+    for (uint32_t batch_idx = 0; batch_idx < STRESS_BATCH_LIFETIME; batch_idx++) {
+        stress_batch_destroy(&s_batches[batch_idx]);
+    }
+
+    mgfx_program_destroy(ph);
+    mgfx_shader_destroy(vsh);
+    mgfx_shader_destroy(fsh);
+}
+
+int main() { mgfx_example_app(); }
@@ -0,0 +1,178 @@
+#include "ex_common.h"
+
+#include <GLFW/glfw3.h>
+
+#include <mx/mx_log.h>
+#include <mx/mx_memory.h>
+
+// Loads a burst of large textures every few seconds, alternating between immediate and streaming
+// upload priority. Immediate bursts are staged in as few frames as the staging budget allows and
+// spike the frame time, streaming bursts are spread over frames by the per frame upload budget.
+// Streaming bursts also queue a streaming buffer update followed by an immediate one into the
+// same range, the immediate one must not complete before the older streaming one.
+
+enum { STREAMING_TEXTURE_COUNT = 16 };
+enum { STREAMING_TEXTURE_SIZE = 1024 };
+enum { STREAMING_TEXTURE_BYTES = STREAMING_TEXTURE_SIZE * STREAMING_TEXTURE_SIZE * 4 };
+
+static const double k_burst_interval = 3.0;
+
+typedef struct streaming_burst {
+    mgfx_th ths[STREAMING_TEXTURE_COUNT];
+    mgfx_uploadh uploads[STREAMING_TEXTURE_COUNT];
+    uint32_t priority;
+
+    mgfx_uploadh stale_upload;
+    mgfx_uploadh overwrite_upload;
+    mx_bool overwrite_early; // The immediate update completed before the streaming one.
+
+    double start;
+    double frame_max;
+    uint32_t frames; // Frames until every upload completed.
+    mx_bool complete;
+    mx_bool alive;
+} streaming_burst;
+
+static streaming_burst s_burst;
+static streaming_burst s_last_bursts[MGFX_UPLOAD_PRIORITY_COUNT];
+
+static uint8_t* s_texture_data;
+static mgfx_sbh s_overwrite_buffer;
+static double s_last_frame_time = 0.0;
+
+static const char* k_priority_names[MGFX_UPLOAD_PRIORITY_COUNT] = {"immediate", "streaming"};
+
+static void streaming_burst_destroy(streaming_burst* burst) {
+    if (!burst->alive) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < STREAMING_TEXTURE_COUNT; i++) {
+        mgfx_texture_destroy(burst->ths[i], MX_TRUE);
+    }
+
+    burst->alive = MX_FALSE;
+}
+
+static void streaming_burst_create(streaming_burst* burst, uint32_t priority, double now) {
+    const mgfx_image_info texture_info = {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .width = STREAMING_TEXTURE_SIZE,
+        .height = STREAMING_TEXTURE_SIZE,
+        .layers = 1,
+        .cube_map = MX_FALSE,
+    };
+
+    *burst = (streaming_burst){.priority = priority, .start = now, .alive = MX_TRUE};
+
+    for (uint32_t i = 0; i < STREAMING_TEXTURE_COUNT; i++) {
+        burst->ths[i] = mgfx_texture_create_from_memory_ex(&texture_info,
+                                                           VK_FILTER_LINEAR,
+                                                           s_texture_data,
+                                                           STREAMING_TEXTURE_BYTES,
+                                                           priority,
+                                                           &burst->uploads[i]);
+    }
+
+    if (priority == MGFX_UPLOAD_PRIORITY_STREAMING) {
+        burst->stale_upload = mgfx_buffer_update_ex(s_overwrite_buffer.idx,
+                                                    s_texture_data,
+                                                    STREAMING_TEXTURE_BYTES,
+                                                    0,
+                                                    MGFX_UPLOAD_PRIORITY_STREAMING);
+        burst->overwrite_upload = mgfx_buffer_update_ex(s_overwrite_buffer.idx,
+                                                        s_texture_data,
+                                                        STREAMING_TEXTURE_SIZE,
+                                                        0,
+                                                        MGFX_UPLOAD_PRIORITY_IMMEDIATE);
+    }
+}
+
+void mgfx_example_init() {
+    s_texture_data = mx_alloc(mx_default_allocator(), STREAMING_TEXTURE_BYTES);
+    for (uint32_t i = 0; i < STREAMING_TEXTURE_BYTES; i++) {
+        s_texture_data[i] = (uint8_t)(i * 7);
+    }
+
+    s_overwrite_buffer = mgfx_storage_buffer_create(NULL, STREAMING_TEXTURE_BYTES);
+
+    s_last_frame_time = glfwGetTime();
+    streaming_burst_create(&s_burst, MGFX_UPLOAD_PRIORITY_IMMEDIATE, s_last_frame_time);
+}
+
+void mgfx_example_update() {
+    const double now = glfwGetTime();
+    const double frame_time = now - s_last_frame_time;
+    s_last_frame_time = now;
+
+    if (!s_burst.complete) {
+        s_burst.frame_max = frame_time > s_burst.frame_max ? frame_time : s_burst.frame_max;
+        s_burst.frames++;
+
+        if (mgfx_upload_complete(s_burst.overwrite_upload) &&
+            !mgfx_upload_complete(s_burst.stale_upload) && !s_burst.overwrite_early) {
+            MX_LOG_ERROR("[TextureStreaming] Immediate update overtook an older streaming one!");
+            s_burst.overwrite_early = MX_TRUE;
+        }
+
+        s_burst.complete = mgfx_upload_complete(s_burst.stale_upload);
+        for (uint32_t i = 0; i < STREAMING_TEXTURE_COUNT; i++) {
+            s_burst.complete &= mgfx_upload_complete(s_burst.uploads[i]);
+        }
+
+        if (s_burst.complete) {
+            s_last_bursts[s_burst.priority] = s_burst;
+
+            MX_LOG_INFO("[TextureStreaming] %s: %u frames, max frame %.2f ms",
+                        k_priority_names[s_burst.priority],
+                        s_burst.frames,
+                        s_burst.frame_max * 1000.0);
+        }
+    }
+
+    if (s_burst.complete && now - s_burst.start >= k_burst_interval) {
+        const uint32_t priority = (s_burst.priority + 1) % MGFX_UPLOAD_PRIORITY_COUNT;
+
+        streaming_burst_destroy(&s_burst);
+        streaming_burst_create(&s_burst, priority, now);
+    }
+
+    const mgfx_stats* stats = mgfx_get_stats();
+    mgfx_debug_draw_text(0,
+                         APP_HEIGHT * 0.95f,
+                         "loading %u x %u kb (%s): %s",
+                         STREAMING_TEXTURE_COUNT,
+                         STREAMING_TEXTURE_BYTES / MX_KB,
+                         k_priority_names[s_burst.priority],
+                         s_burst.complete ? "complete" : "pending");
+
+    for (uint32_t priority = 0; priority < MGFX_UPLOAD_PRIORITY_COUNT; priority++) {
+        const streaming_burst* last = &s_last_bursts[priority];
+        mgfx_debug_draw_text(0,
+                             APP_HEIGHT * (0.90f - 0.05f * priority),
+                             "%s: %u frames max frame %.2f ms",
+                             k_priority_names[priority],
+                             last->frames,
+                             last->frame_max * 1000.0);
+    }
+
+    mgfx_debug_draw_text(0,
+                         APP_HEIGHT * 0.80f,
+                         "staging: %.1f kb deferred: %.1f kb",
+                         (double)stats->staging_bytes / MX_KB,
+                         (double)stats->staging_deferred_bytes / MX_KB);
+
+    mgfx_debug_draw_text(0,
+                         APP_HEIGHT * 0.75f,
+                         "overwrite order: %s",
+                         s_last_bursts[MGFX_UPLOAD_PRIORITY_STREAMING].overwrite_early ? "violated"
+                                                                                       : "ok");
+}
+
+void mgfx_example_shutdown() {
+    streaming_burst_destroy(&s_burst);
+    mgfx_buffer_destroy(s_overwrite_buffer.idx);
+    mx_free(mx_default_allocator(), s_texture_data);
+}
+
+int main() { mgfx_example_app(); }
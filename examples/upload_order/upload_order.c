@@ -0,0 +1,116 @@
+#include "ex_common.h"
+
+#include <mx/mx_asserts.h>
+#include <mx/mx_log.h>
+#include <mx/mx_memory.h>
+
+// Regression check for the order of uploads into one destination across upload priorities. Each
+// round queues a streaming update larger than the per frame upload budget, an immediate update
+// into the same range and an immediate update into another buffer. The immediate update into the
+// same range must not complete before the older streaming one, the one into the other buffer must
+// not wait for it. Violations are logged and assert in debug builds.
+
+enum { UPLOAD_ORDER_STREAMING_BYTES = MX_MB * 32 }; // Several frames of the default budget.
+enum { UPLOAD_ORDER_OVERWRITE_BYTES = MX_KB * 64 };
+
+typedef struct upload_round {
+    mgfx_uploadh stale_upload;
+    mgfx_uploadh overwrite_upload;
+    mgfx_uploadh unrelated_upload;
+    uint32_t frames;
+    mx_bool violated; // Reported once per round.
+} upload_round;
+
+static upload_round s_round;
+static uint32_t s_rounds = 0;
+static uint32_t s_violations = 0;
+
+static uint8_t* s_data;
+static mgfx_sbh s_buffer;
+static mgfx_sbh s_unrelated_buffer;
+
+static void upload_round_start(upload_round* round, uint32_t round_idx) {
+    // Odd rounds overwrite the middle of the streamed range instead of its start.
+    const size_t offset = (round_idx % 2) * (UPLOAD_ORDER_STREAMING_BYTES / 2);
+
+    *round = (upload_round){0};
+    round->stale_upload = mgfx_buffer_update_ex(
+        s_buffer.idx, s_data, UPLOAD_ORDER_STREAMING_BYTES, 0, MGFX_UPLOAD_PRIORITY_STREAMING);
+    round->overwrite_upload = mgfx_buffer_update_ex(s_buffer.idx,
+                                                    s_data,
+                                                    UPLOAD_ORDER_OVERWRITE_BYTES,
+                                                    offset,
+                                                    MGFX_UPLOAD_PRIORITY_IMMEDIATE);
+    round->unrelated_upload = mgfx_buffer_update_ex(s_unrelated_buffer.idx,
+                                                    s_data,
+                                                    UPLOAD_ORDER_OVERWRITE_BYTES,
+                                                    0,
+                                                    MGFX_UPLOAD_PRIORITY_IMMEDIATE);
+
+    MX_ASSERT(round->stale_upload.idx != 0 && round->overwrite_upload.idx != 0 &&
+                  round->unrelated_upload.idx != 0,
+              "[UploadOrder] Uploads must be tracked to check their order!");
+}
+
+static void upload_order_violation(upload_round* round, const char* message) {
+    if (round->violated) {
+        return;
+    }
+
+    MX_LOG_ERROR("[UploadOrder] %s", message);
+    round->violated = MX_TRUE;
+    s_violations++;
+
+    MX_ASSERT(0, "[UploadOrder] Upload order violated!");
+}
+
+void mgfx_example_init() {
+    s_data = mx_alloc(mx_default_allocator(), UPLOAD_ORDER_STREAMING_BYTES);
+    for (uint32_t i = 0; i < UPLOAD_ORDER_STREAMING_BYTES; i++) {
+        s_data[i] = (uint8_t)(i * 7);
+    }
+
+    s_buffer = mgfx_storage_buffer_create(NULL, UPLOAD_ORDER_STREAMING_BYTES);
+    s_unrelated_buffer = mgfx_storage_buffer_create(NULL, UPLOAD_ORDER_OVERWRITE_BYTES);
+
+    upload_round_start(&s_round, 0);
+}
+
+void mgfx_example_update() {
+    const mx_bool stale_complete = mgfx_upload_complete(s_round.stale_upload);
+    const mx_bool overwrite_complete = mgfx_upload_complete(s_round.overwrite_upload);
+    const mx_bool unrelated_complete = mgfx_upload_complete(s_round.unrelated_upload);
+    s_round.frames++;
+
+    if (overwrite_complete && !stale_complete) {
+        upload_order_violation(&s_round, "Immediate update overtook an older streaming one!");
+    }
+
+    if (stale_complete && !unrelated_complete) {
+        upload_order_violation(&s_round, "Immediate update waited on another buffer's upload!");
+    }
+
+    if (stale_complete && overwrite_complete && unrelated_complete) {
+        s_rounds++;
+        MX_LOG_INFO("[UploadOrder] Round %u complete in %u frames, %u violations",
+                    s_rounds,
+                    s_round.frames,
+                    s_violations);
+
+        upload_round_start(&s_round, s_rounds);
+    }
+
+    mgfx_debug_draw_text(0,
+                         APP_HEIGHT * 0.95f,
+                         "upload order: %u rounds, %u violations",
+                         s_rounds,
+                         s_violations);
+}
+
+void mgfx_example_shutdown() {
+    mgfx_buffer_destroy(s_buffer.idx);
+    mgfx_buffer_destroy(s_unrelated_buffer.idx);
+    mx_free(mx_default_allocator(), s_data);
+}
+
+int main() { mgfx_example_app(); }
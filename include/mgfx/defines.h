@@ -21,8 +21,15 @@ typedef enum mgfx_allocation_type {
 
 enum { MGFX_SHADER_MAX_DESCRIPTOR_SET = 4 };
 enum { MGFX_SHADER_MAX_DESCRIPTOR_BINDING = 8 };
+enum { MGFX_SHADER_VIEW_SET = MGFX_SHADER_MAX_DESCRIPTOR_SET - 1 }; // Built in `mgfx_view`.
+enum { MGFX_SHADER_BINDLESS_SET = MGFX_SHADER_VIEW_SET - 1 }; // Bindings prefixed with `b_`.
+enum { MGFX_BINDLESS_TEXTURE_BINDING = 0 };
+enum { MGFX_BINDLESS_BUFFER_BINDING = 1 };
+enum { MGFX_BINDLESS_INDEX_COUNT = 4 }; // Pushed after the model matrix, at offset 64.
+enum { MGFX_SHADER_MAX_DYNAMIC_OFFSETS = 8 }; // Uniform blocks prefixed with `t_`.
 enum { MGFX_SHADER_MAX_PUSH_CONSTANTS = 4 };
 enum { MGFX_SHADER_MAX_VERTEX_BINDING = 4 };
+enum { MGFX_SHADER_INSTANCE_BINDING = 1 }; // Vertex inputs prefixed with `i_`.
 enum { MGFX_SHADER_MAX_VERTEX_ATTRIBUTES = 16 };
 typedef enum MGFX_SHADER_STAGE {
     MGFX_SHADER_STAGE_VERTEX = 0,
@@ -60,6 +67,16 @@ void vertex_layout_add(mgfx_vertex_layout* vl, mgfx_vertex_attribute attribute,
 
 void vertex_layout_end(mgfx_vertex_layout* vl);
 
+typedef enum mgfx_upload_priority {
+    MGFX_UPLOAD_PRIORITY_IMMEDIATE = 0, // Staged for the next frame regardless of the budget.
+    MGFX_UPLOAD_PRIORITY_STREAMING,     // Staged within the per frame upload budget.
+
+    MGFX_UPLOAD_PRIORITY_COUNT
+} mgfx_upload_priority;
+
+// Mip level count of a full chain down to 1x1, generated on the gpu after upload.
+#define MGFX_MIP_LEVELS_AUTO ((uint32_t)0xFFFFFFFF)
+
 typedef MX_API struct mgfx_image_info {
     uint32_t format; // VkFormat
 
@@ -67,10 +84,19 @@ typedef MX_API struct mgfx_image_info {
     uint32_t height;
 
     uint32_t layers;
+    uint32_t mip_levels; // 0 is a single level, or MGFX_MIP_LEVELS_AUTO.
 
     mx_bool cube_map;
 } mgfx_image_info;
 
+// Sampler state of a texture. Textures with equal sampler infos share one VkSampler.
+typedef MX_API struct mgfx_sampler_info {
+    uint32_t filter;       // VkFilter, used for min and mag filtering.
+    uint32_t mipmap_mode;  // VkSamplerMipmapMode
+    uint32_t address_mode; // VkSamplerAddressMode, used for u, v and w.
+    uint32_t border_color; // VkBorderColor, used with the clamp to border address mode.
+} mgfx_sampler_info;
+
 enum { MGFX_DEFAULT_VIEW_TARGET = 0xFF - 1};
 
 typedef struct mgfx_transient_buffer {
@@ -85,6 +111,7 @@ typedef struct mgfx_graphics_ex_create_info {
     int32_t cull_mode;          // VkCullModeFlags
 
     mx_bool instanced;
+    mx_bool blend; // Alpha blended, drawn after opaque draws back to front.
 } mgfx_graphics_ex_create_info;
 
 #ifdef __cplusplus
@@ -39,6 +39,24 @@ extern "C" { // Ensure C++ linkage compatibility
 typedef MX_API struct {
     char name[256];
     void* nwh;
+
+    // Transient vertex and index data is allocated from chained blocks of these sizes in bytes,
+    // 0 selects the defaults. Larger allocations get a block of their own.
+    uint32_t transient_vertex_block_size;
+    uint32_t transient_index_block_size;
+
+    // Uploads to device local memory are staged through blocks of this size in bytes, growing up
+    // to the budget. Uploads that do not fit continue over the following frames. 0 selects the
+    // defaults.
+    uint32_t staging_block_size;
+    size_t staging_budget;
+
+    // Bytes of MGFX_UPLOAD_PRIORITY_STREAMING uploads staged per frame, 0 selects the default.
+    size_t upload_budget;
+
+    // Creates the global texture and storage buffer arrays read at MGFX_SHADER_BINDLESS_SET.
+    // Ignored when the device lacks descriptor indexing, see mgfx_bindless_enabled.
+    mx_bool bindless;
 } mgfx_init_info;
 
 /**
@@ -55,18 +73,56 @@ MX_API void mgfx_shutdown();
 
 MX_API void mgfx_reset(uint32_t width, uint32_t height);
 
+/** @brief Vulkan bind calls by kind. */
+typedef MX_API struct mgfx_bind_counts {
+    uint32_t pipelines;
+    uint32_t descriptor_sets;
+    uint32_t vertex_buffers;
+    uint32_t index_buffers;
+    uint32_t push_constants;
+} mgfx_bind_counts;
+
+/** @brief Renderer statistics of the last completed frame. */
+typedef MX_API struct mgfx_stats {
+    uint32_t draw_count;        // Draws submitted.
+    size_t draw_bytes;          // Bytes of draw keys, records and bind streams used.
+    size_t draw_arena_capacity; // Bytes reserved by the per-frame draw arena.
+
+    mgfx_bind_counts binds;         // Bind calls recorded.
+    mgfx_bind_counts binds_skipped; // Redundant bind calls filtered out.
+
+    uint32_t upload_copies;  // Copy commands recorded for uploads.
+    uint32_t upload_regions; // Copy regions recorded after merging adjacent ones.
+
+    size_t staging_bytes;          // Staging bytes written for the frame.
+    size_t staging_bytes_peak;     // Most staging bytes written for any frame.
+    double staging_bytes_average;  // Staging bytes written per frame on average.
+    size_t staging_capacity;       // Bytes held by staging blocks.
+    size_t staging_deferred_bytes; // Upload bytes waiting for staging memory.
+
+    uint32_t texture_loads; // Async texture loads still sampling their placeholder.
+    uint32_t samplers;      // Distinct samplers shared by textures.
+    uint32_t image_views;   // Distinct image views shared by textures and framebuffers.
+
+    uint32_t descriptor_sets;          // Descriptor sets held by the cache.
+    uint32_t descriptor_pools;         // Pools backing cached descriptor sets.
+    uint32_t descriptor_set_evictions; // Least recently used sets evicted so far.
+    uint32_t bindless_writes;          // Bindless array slots written for the frame.
+} mgfx_stats;
+
+MX_API const mgfx_stats* mgfx_get_stats();
+
 static const uint16_t mgfx_invalid_handle = UINT16_MAX;
 #define MGFX_INVALID_HANDLE ((uint16_t)mgfx_invalid_handle)
 
+// Buffers, shaders, programs, descriptors and framebuffers use generational handles: a 16 bit
+// slot index and the slot generation. Handles of destroyed resources are detected as stale.
 #define MGFX_HANDLE(name)                                                                                    \
     typedef MX_API struct name {                                                                             \
         uint64_t idx;                                                                                        \
     } name;
 
-/**
- * @brief Shader handle.
- * @note Equivalent to VkShaderModule.
- * */
+/** @brief Shader handle. */
 MGFX_HANDLE(mgfx_sh)
 
 /**
@@ -75,23 +131,36 @@ MGFX_HANDLE(mgfx_sh)
  * */
 MGFX_HANDLE(mgfx_ph)
 
-/**
- * @@brief Handle for Vertex buffer.
- * @note Equivalent to VKBuffer.
- */
+/** @brief Handle for Vertex buffer. */
 MGFX_HANDLE(mgfx_vbh)
 
-/**
- * @brief Handle for Index buffer.
- * @note Equivalent to VKBuffer. */
+/** @brief Handle for Index buffer. */
 MGFX_HANDLE(mgfx_ibh)
 
 /**
- * @@brief Handle for Unifrom buffer.
- * @note Equivalent to VkBuffer.
+ * @brief Handle for Instance buffer.
+ * @details Per instance vertex data, read by vertex inputs prefixed with `i_`.
  */
+MGFX_HANDLE(mgfx_instbh)
+
+/**
+ * @brief Handle for Indirect buffer.
+ * @details Holds VkDrawIndexedIndirectCommand arguments or draw counts, writable by compute.
+ */
+MGFX_HANDLE(mgfx_indbh)
+
+/** @brief Handle for Uniform buffer. */
 MGFX_HANDLE(mgfx_ubh)
 
+/** @brief Handle for Storage buffer. */
+MGFX_HANDLE(mgfx_sbh)
+
+/** @brief Handle for a gpu culling set, see mgfx_cull_create. */
+MGFX_HANDLE(mgfx_cullh)
+
+/** @brief Handle for a queued upload, see mgfx_upload_complete. */
+MGFX_HANDLE(mgfx_uploadh)
+
 /**
  * @@brief Handle for Transient buffer.
  */
@@ -120,6 +189,38 @@ MGFX_HANDLE(mgfx_fbh)
  */
 MGFX_HANDLE(mgfx_th)
 
+/**
+ * @brief Object culled on the gpu against a view frustum.
+ * @details Objects sharing a `batch` share bind state and are drawn with one mgfx_submit_culled.
+ * The vertex shader reads the object back with `gl_InstanceIndex` as its index.
+ * @note Matches the std430 layout of the objects storage buffer.
+ */
+typedef struct MX_API mgfx_cull_object {
+    float model[16];
+    float aabb_min[3]; // Local space.
+    uint32_t batch;
+    float aabb_max[3];
+    uint32_t batch_first; // Set by mgfx.
+
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t command; // Set by mgfx.
+} mgfx_cull_object;
+
+/**
+ * @brief World space boxes as separate center and half extent arrays of `count` floats.
+ */
+typedef struct MX_API mgfx_bounds {
+    float* center_x;
+    float* center_y;
+    float* center_z;
+    float* extent_x;
+    float* extent_y;
+    float* extent_z;
+    uint32_t count;
+} mgfx_bounds;
+
 // Built in textures
 extern mgfx_th MGFX_WHITE_TEXTURE;
 extern mgfx_th MGFX_BLACK_TEXTURE;
@@ -134,9 +235,54 @@ MX_API void mgfx_debug_draw_text(int32_t x, int32_t y, const char* fmt, ...);
 MX_API MX_NO_DISCARD mgfx_vbh mgfx_vertex_buffer_create(const void* data, size_t len);
 
 MX_API MX_NO_DISCARD mgfx_ibh mgfx_index_buffer_create(const void* data, size_t len);
+MX_API MX_NO_DISCARD mgfx_instbh mgfx_instance_buffer_create(const void* data, size_t len);
+MX_API MX_NO_DISCARD mgfx_indbh mgfx_indirect_buffer_create(const void* data, size_t len);
+/**
+ * @brief Copies vertex or index data into this frame's transient geometry blocks.
+ * @details Written directly into host visible memory and valid until the next mgfx_frame.
+ * Blocks are recycled once the frame's fence signals and chained when a frame needs more.
+ * @note Not thread safe, allocate before handing the data to encoders.
+ */
+MX_API void mgfx_transient_vertex_buffer_allocate(const void* data,
+                                                  size_t len,
+                                                  mgfx_transient_buffer* out);
+MX_API void mgfx_transient_index_buffer_allocate(const void* data,
+                                                 size_t len,
+                                                 mgfx_transient_buffer* out);
+MX_API void mgfx_transient_instance_buffer_allocate(const void* data,
+                                                    size_t len,
+                                                    mgfx_transient_buffer* out);
+
+/**
+ * @brief Copies `len` bytes of uniform data into this frame's transient uniform ring.
+ * @details One bump allocation, valid until the next mgfx_frame. Bind with
+ * mgfx_bind_transient_uniform_buffer to a uniform block whose name is prefixed with `t_`.
+ * `out` is zeroed if the frame's region is exhausted.
+ * @note Thread safe while encoders are recording.
+ */
+MX_API void mgfx_transient_uniform_buffer_allocate(const void* data,
+                                                   size_t len,
+                                                   mgfx_transient_buffer* out);
 MX_API MX_NO_DISCARD mgfx_ubh mgfx_uniform_buffer_create(const void* data, size_t len);
+MX_API MX_NO_DISCARD mgfx_sbh mgfx_storage_buffer_create(const void* data, size_t len);
 
 MX_API void mgfx_buffer_update(uint64_t buffer_idx, const void* data, size_t size, size_t offset);
+
+/**
+ * @brief Queues a buffer update with an upload priority.
+ * @details Streaming uploads are spread over frames by the per frame upload budget. The data is
+ * copied before returning.
+ * @return Handle to poll with mgfx_upload_complete, zero when too many uploads are in flight to
+ * track another one. The data is uploaded either way.
+ */
+MX_API mgfx_uploadh mgfx_buffer_update_ex(
+    uint64_t buffer_idx, const void* data, size_t size, size_t offset, uint32_t priority);
+
+/**
+ * @brief Returns MX_TRUE once the upload is visible to the gpu.
+ * @note Handles of completed uploads are stale, invalid handles are reported as complete.
+ */
+MX_API mx_bool mgfx_upload_complete(mgfx_uploadh uh);
 MX_API void mgfx_buffer_destroy(uint64_t buffer_idx);
 
 MX_API MX_NO_DISCARD mgfx_sh mgfx_shader_create(const char* path);
@@ -152,13 +298,56 @@ MX_API void mgfx_program_destroy(mgfx_ph ph);
 MX_API MX_NO_DISCARD mgfx_imgh mgfx_image_create(const mgfx_image_info* info, uint32_t usage);
 MX_API void mgfx_image_destroy(mgfx_imgh imgh);
 
+/**
+ * @brief Textures created from memory or loaded repeat, textures created from images clamp to a
+ * transparent black border. Mipmaps are linearly filtered when `filter` is VK_FILTER_LINEAR.
+ */
 MX_API MX_NO_DISCARD mgfx_th mgfx_texture_create_from_memory(const mgfx_image_info* info,
                                                              uint32_t filter,
                                                              void* data,
                                                              size_t len);
+/**
+ * @brief Creates a texture uploaded with a priority, `upload` may be NULL.
+ * @note Textures must not be sampled before their upload is complete. Data of block compressed
+ * formats is whole 4x4 blocks of level 0.
+ */
+MX_API MX_NO_DISCARD mgfx_th mgfx_texture_create_from_memory_ex(const mgfx_image_info* info,
+                                                                uint32_t filter,
+                                                                void* data,
+                                                                size_t len,
+                                                                uint32_t priority,
+                                                                mgfx_uploadh* upload);
 MX_API MX_NO_DISCARD mgfx_th mgfx_texture_create_from_image(mgfx_imgh img, const uint32_t filter);
+/**
+ * @brief Loads a texture on a background thread and streams it in with a full mip chain, returns
+ * immediately.
+ * @note The texture samples `placeholder` until loaded, a zero placeholder uses
+ * MGFX_WHITE_TEXTURE. Ktx2 files keep their own format and levels, which may be block compressed.
+ * Basis Universal ktx2 files are transcoded to bc7, or to bc1, bc4 or bc5 when `format` is one of
+ * them or has as many channels, and to rgba8 without block compression support. Transcoding needs
+ * mgfx configured with MGFX_BASISU, which is off by default.
+ */
+MX_API MX_NO_DISCARD mgfx_th mgfx_texture_load_async(const char* path,
+                                                     uint32_t format,
+                                                     uint32_t filter,
+                                                     mgfx_th placeholder);
+/** @brief Returns MX_TRUE once a load finished, failed loads keep their placeholder. */
+MX_API mx_bool mgfx_texture_ready(mgfx_th th);
+/** @brief Replaces the sampler of a texture, descriptors bound to it pick up the new one. */
+MX_API void mgfx_texture_set_sampler(mgfx_th th, const mgfx_sampler_info* info);
 MX_API void mgfx_texture_destroy(mgfx_th th, mx_bool release_image);
 
+/** @brief Returns MX_TRUE when the bindless arrays were requested and are supported. */
+MX_API mx_bool mgfx_bindless_enabled();
+/**
+ * @brief Returns the stable index of a texture in the bindless texture array.
+ * @note Indices are reused once a texture is destroyed. Render targets read through the array
+ * are not transitioned for sampling, bind them through a descriptor instead.
+ */
+MX_API uint32_t mgfx_texture_bindless_index(mgfx_th th);
+/** @brief Returns the stable index of a storage buffer in the bindless buffer array. */
+MX_API uint32_t mgfx_buffer_bindless_index(mgfx_sbh sbh);
+
 MX_API MX_NO_DISCARD mgfx_fbh mgfx_framebuffer_create(mgfx_imgh* color_attachments,
                                                       uint32_t color_attachment_count,
                                                       mgfx_imgh depth_attachment);
@@ -168,20 +357,178 @@ MX_API MX_NO_DISCARD mgfx_dh mgfx_descriptor_create(const char* name, uint32_t t
 MX_API void mgfx_descriptor_destroy(mgfx_dh dh);
 
 MX_API void mgfx_set_buffer(mgfx_dh dh, mgfx_ubh ubh);
+MX_API void mgfx_set_storage_buffer(mgfx_dh dh, mgfx_sbh sbh);
 MX_API void mgfx_set_texture(mgfx_dh dh, mgfx_th th);
 
 MX_API void mgfx_set_view_clear(uint8_t target, float* color_4);
 MX_API void mgfx_set_view_target(uint8_t target, mgfx_fbh fb);
 
-MX_API void mgfx_set_transform(const float* mtx);
+/**
+ * @brief Sets the view and projection of a target for the current frame.
+ *
+ * Uploaded once per frame into the `mgfx_view` block at set `MGFX_SHADER_VIEW_SET`, draws only
+ * push their model matrix.
+ */
+MX_API void mgfx_set_view_transform(uint8_t target, const float* view, const float* proj);
+
+/**
+ * @brief Sets the view or projection of MGFX_DEFAULT_VIEW_TARGET, keeping the other.
+ * @deprecated Use mgfx_set_view_transform, views are no longer set per encoder.
+ */
 MX_API void mgfx_set_view(const float* mtx);
 MX_API void mgfx_set_proj(const float* mtx);
 
+MX_API void mgfx_set_transform(const float* mtx);
+
+/**
+ * @brief Sets the indices pushed to programs reading MGFX_SHADER_BINDLESS_SET.
+ *
+ * Kept until changed, like the transform. Shaders read them as MGFX_BINDLESS_INDEX_COUNT uints
+ * at push constant offset 64.
+ */
+MX_API void mgfx_set_bindless_indices(const uint32_t* indices);
+
 MX_API void mgfx_bind_vertex_buffer(mgfx_vbh vbh);
 MX_API void mgfx_bind_index_buffer(mgfx_ibh ibh);
 MX_API void mgfx_bind_descriptor(uint32_t ds_idx, mgfx_dh dh);
 
+/** @brief Binds per instance data, must follow the vertex buffer bind. */
+MX_API void mgfx_bind_instance_buffer(mgfx_instbh instbh);
+MX_API void mgfx_bind_transient_vertex_buffer(mgfx_transient_buffer tb);
+MX_API void mgfx_bind_transient_index_buffer(mgfx_transient_buffer tib);
+MX_API void mgfx_bind_transient_instance_buffer(mgfx_transient_buffer tb);
+
+/**
+ * @brief Binds `dh` at the next binding of set `ds_idx`, reading the transient uniforms `tb`.
+ * @details `dh` must be created with VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC. Its descriptor
+ * set is shared by every allocation, draws only differ by their dynamic offset.
+ */
+MX_API void mgfx_bind_transient_uniform_buffer(uint32_t ds_idx,
+                                               mgfx_dh dh,
+                                               mgfx_transient_buffer tb);
+
 MX_API void mgfx_submit(uint8_t target, mgfx_ph ph);
+MX_API void mgfx_submit_instanced(uint8_t target, mgfx_ph ph, uint32_t instance_count);
+
+/**
+ * @brief Submits `draw_count` indexed draws whose arguments are read from `indbh`.
+ * @details Arguments are VkDrawIndexedIndirectCommand records `stride` bytes apart starting at
+ * `offset`. Bound state is shared by every draw.
+ */
+MX_API void mgfx_submit_indirect(uint8_t target,
+                                 mgfx_ph ph,
+                                 mgfx_indbh indbh,
+                                 uint32_t offset,
+                                 uint32_t draw_count,
+                                 uint32_t stride);
+
+/**
+ * @brief Like mgfx_submit_indirect with the draw count read as a uint32_t from `count_bh`.
+ * @note Requires the drawIndirectCount device feature.
+ */
+MX_API void mgfx_submit_indirect_count(uint8_t target,
+                                       mgfx_ph ph,
+                                       mgfx_indbh indbh,
+                                       uint32_t offset,
+                                       mgfx_indbh count_bh,
+                                       uint32_t count_offset,
+                                       uint32_t max_draw_count,
+                                       uint32_t stride);
+
+/**
+ * @brief Creates a gpu culling set of `object_count` objects drawn in `batch_count` batches.
+ * @details Every frame each view passed to mgfx_cull_view is culled by a compute pass before
+ * rendering, survivors are written as indirect draws. Requires drawIndirectFirstInstance.
+ */
+MX_API MX_NO_DISCARD mgfx_cullh mgfx_cull_create(const mgfx_cull_object* objects,
+                                                 uint32_t object_count,
+                                                 uint32_t batch_count,
+                                                 uint32_t view_count);
+MX_API void mgfx_cull_update(mgfx_cullh cullh,
+                             const mgfx_cull_object* objects,
+                             uint32_t first,
+                             uint32_t count);
+MX_API void mgfx_cull_destroy(mgfx_cullh cullh);
+
+/** @brief Objects storage buffer, bind it to read per object data from the vertex shader. */
+MX_API mgfx_sbh mgfx_cull_objects(mgfx_cullh cullh);
+
+/**
+ * @brief Culls `bounds` against the frustum of the column major `view_proj` on the cpu.
+ * @details Writes the indices of the visible boxes in order to `visible`, which must hold
+ * `bounds->count` entries, and returns how many were written. Uses AVX, SSE or NEON when
+ * enabled by the compiler.
+ */
+MX_API uint32_t mgfx_frustum_cull(const float* view_proj,
+                                  const mgfx_bounds* bounds,
+                                  uint32_t* visible);
+
+/** @brief Culls `view` against the column major `view_proj` this frame. */
+MX_API void mgfx_cull_view(mgfx_cullh cullh, uint32_t view, const float* view_proj);
+
+/** @brief Draws the objects of `batch` that survived culling of `view` with the bound state. */
+MX_API void mgfx_submit_culled(
+    uint8_t target, mgfx_ph ph, mgfx_cullh cullh, uint32_t view, uint32_t batch);
+
+/**
+ * @brief Records draws independently of other threads.
+ * @details Each encoder owns its bind state and draw buffer, the immediate mgfx_set_*,
+ * mgfx_bind_* and mgfx_submit calls use a built in main thread encoder. Encoders are valid
+ * for the current frame only and must be ended before mgfx_frame.
+ * @note Submissions compute their sort depth from the view of their target, so
+ * mgfx_set_view_transform must be called for a target before any encoder submits to it that
+ * frame. Resources must not be created or destroyed while encoders are recording.
+ */
+typedef struct mgfx_encoder mgfx_encoder;
+
+MX_API MX_NO_DISCARD mgfx_encoder* mgfx_encoder_begin();
+MX_API void mgfx_encoder_end(mgfx_encoder* enc);
+
+MX_API void mgfx_encoder_set_transform(mgfx_encoder* enc, const float* mtx);
+MX_API void mgfx_encoder_set_bindless_indices(mgfx_encoder* enc, const uint32_t* indices);
+
+MX_API void mgfx_encoder_bind_vertex_buffer(mgfx_encoder* enc, mgfx_vbh vbh);
+MX_API void mgfx_encoder_bind_index_buffer(mgfx_encoder* enc, mgfx_ibh ibh);
+MX_API void mgfx_encoder_bind_descriptor(mgfx_encoder* enc, uint32_t ds_idx, mgfx_dh dh);
+MX_API void mgfx_encoder_bind_instance_buffer(mgfx_encoder* enc, mgfx_instbh instbh);
+MX_API void mgfx_encoder_bind_transient_vertex_buffer(mgfx_encoder* enc,
+                                                      mgfx_transient_buffer tb);
+MX_API void mgfx_encoder_bind_transient_index_buffer(mgfx_encoder* enc,
+                                                     mgfx_transient_buffer tib);
+MX_API void mgfx_encoder_bind_transient_instance_buffer(mgfx_encoder* enc,
+                                                        mgfx_transient_buffer tb);
+MX_API void mgfx_encoder_bind_transient_uniform_buffer(mgfx_encoder* enc,
+                                                       uint32_t ds_idx,
+                                                       mgfx_dh dh,
+                                                       mgfx_transient_buffer tb);
+
+MX_API void mgfx_encoder_submit(mgfx_encoder* enc, uint8_t target, mgfx_ph ph);
+MX_API void mgfx_encoder_submit_instanced(mgfx_encoder* enc,
+                                          uint8_t target,
+                                          mgfx_ph ph,
+                                          uint32_t instance_count);
+MX_API void mgfx_encoder_submit_indirect(mgfx_encoder* enc,
+                                         uint8_t target,
+                                         mgfx_ph ph,
+                                         mgfx_indbh indbh,
+                                         uint32_t offset,
+                                         uint32_t draw_count,
+                                         uint32_t stride);
+MX_API void mgfx_encoder_submit_indirect_count(mgfx_encoder* enc,
+                                               uint8_t target,
+                                               mgfx_ph ph,
+                                               mgfx_indbh indbh,
+                                               uint32_t offset,
+                                               mgfx_indbh count_bh,
+                                               uint32_t count_offset,
+                                               uint32_t max_draw_count,
+                                               uint32_t stride);
+MX_API void mgfx_encoder_submit_culled(mgfx_encoder* enc,
+                                       uint8_t target,
+                                       mgfx_ph ph,
+                                       mgfx_cullh cullh,
+                                       uint32_t view,
+                                       uint32_t batch);
 
 #ifdef __cplusplus
 } // End extern "C"
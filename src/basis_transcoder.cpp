@@ -0,0 +1,55 @@
+#include "basis_transcoder.h"
+
+#include <transcoder/basisu_transcoder.h>
+
+#include <new>
+
+struct basis_ktx2 {
+    basist::ktx2_transcoder transcoder;
+};
+
+static const basist::transcoder_texture_format k_target_formats[] = {
+    basist::transcoder_texture_format::cTFBC1_RGB,
+    basist::transcoder_texture_format::cTFBC4_R,
+    basist::transcoder_texture_format::cTFBC5_RG,
+    basist::transcoder_texture_format::cTFBC7_RGBA,
+    basist::transcoder_texture_format::cTFRGBA32,
+};
+
+void basis_transcoder_init() { basist::basisu_transcoder_init(); }
+
+basis_ktx2* basis_ktx2_open(const uint8_t* data, size_t size, basis_ktx2_info* info) {
+    basis_ktx2* ktx2 = new (std::nothrow) basis_ktx2;
+    if (ktx2 == NULL) {
+        return NULL;
+    }
+
+    basist::ktx2_transcoder& transcoder = ktx2->transcoder;
+    if (!transcoder.init(data, (uint32_t)size) ||
+        (!transcoder.is_etc1s() && !transcoder.is_uastc()) || transcoder.get_faces() != 1 ||
+        transcoder.get_layers() > 1 || !transcoder.start_transcoding()) {
+        delete ktx2;
+        return NULL;
+    }
+
+    info->width = transcoder.get_width();
+    info->height = transcoder.get_height();
+    info->level_count = transcoder.get_levels();
+    info->has_alpha = transcoder.get_has_alpha() ? MX_TRUE : MX_FALSE;
+    info->srgb = transcoder.get_dfd_transfer_func() == basist::KTX2_KHR_DF_TRANSFER_SRGB;
+
+    return ktx2;
+}
+
+void basis_ktx2_close(basis_ktx2* ktx2) { delete ktx2; }
+
+mx_bool basis_ktx2_transcode(
+    basis_ktx2* ktx2, uint32_t level, uint32_t target, void* out, uint32_t out_units) {
+    // Two channel files store green in alpha when encoded with alpha, like basisu normal maps.
+    const int channel1 = ktx2->transcoder.get_has_alpha() ? 3 : 1;
+
+    return ktx2->transcoder.transcode_image_level(
+               level, 0, 0, out, out_units, k_target_formats[target], 0, 0, 0, 0, channel1)
+               ? MX_TRUE
+               : MX_FALSE;
+}
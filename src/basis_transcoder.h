@@ -0,0 +1,47 @@
+#ifndef MGFX_BASIS_TRANSCODER_H_
+#define MGFX_BASIS_TRANSCODER_H_
+
+#include <mx/mx.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// C interface to the Basis Universal ktx2 transcoder, built with MGFX_BASISU. Files hold etc1s
+// or uastc data that is transcoded to a format the device samples. Handles are independent and
+// may be used on any thread once basis_transcoder_init returned.
+enum {
+    BASIS_TARGET_BC1,
+    BASIS_TARGET_BC4,
+    BASIS_TARGET_BC5,
+    BASIS_TARGET_BC7,
+    BASIS_TARGET_RGBA8,
+};
+
+typedef struct basis_ktx2 basis_ktx2;
+
+typedef struct basis_ktx2_info {
+    uint32_t width;
+    uint32_t height;
+    uint32_t level_count;
+    mx_bool has_alpha;
+    mx_bool srgb;
+} basis_ktx2_info;
+
+void basis_transcoder_init();
+
+// Returns NULL unless `data` is a 2d ktx2 file with etc1s or uastc data. `data` must outlive the
+// returned handle.
+basis_ktx2* basis_ktx2_open(const uint8_t* data, size_t size, basis_ktx2_info* info);
+void basis_ktx2_close(basis_ktx2* ktx2);
+
+// Writes `level` as tightly packed rows of 4x4 blocks, or of texels for BASIS_TARGET_RGBA8.
+// `out_units` is the number of blocks or texels `out` holds.
+mx_bool basis_ktx2_transcode(
+    basis_ktx2* ktx2, uint32_t level, uint32_t target, void* out, uint32_t out_units);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,164 @@
+#include "cull.h"
+
+#include "mgfx/mgfx.h"
+
+#include <math.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MGFX_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MGFX_CULL_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MGFX_CULL_NEON
+#endif
+
+void cull_frustum_planes(const float* view_proj, float planes[6][4]) {
+    // Gribb-Hartmann, left/right, bottom/top and near/far from rows of the matrix.
+    const float* m = view_proj;
+    for (uint32_t i = 0; i < 6; i++) {
+        const uint32_t row = i / 2;
+        const float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+
+        for (uint32_t col = 0; col < 4; col++) {
+            planes[i][col] = m[col * 4 + 3] + sign * m[col * 4 + row];
+        }
+    }
+}
+
+static mx_bool cull_test(const float planes[6][4],
+                         const float abs_planes[6][3],
+                         const mgfx_bounds* bounds,
+                         uint32_t i) {
+    for (uint32_t p = 0; p < 6; p++) {
+        const float dist = planes[p][0] * bounds->center_x[i] +
+                           planes[p][1] * bounds->center_y[i] +
+                           planes[p][2] * bounds->center_z[i] + planes[p][3];
+        const float radius = abs_planes[p][0] * bounds->extent_x[i] +
+                             abs_planes[p][1] * bounds->extent_y[i] +
+                             abs_planes[p][2] * bounds->extent_z[i];
+
+        if (dist + radius < 0.0f) {
+            return MX_FALSE;
+        }
+    }
+
+    return MX_TRUE;
+}
+
+uint32_t mgfx_frustum_cull(const float* view_proj, const mgfx_bounds* bounds, uint32_t* visible) {
+    float planes[6][4];
+    cull_frustum_planes(view_proj, planes);
+
+    float abs_planes[6][3];
+    for (uint32_t p = 0; p < 6; p++) {
+        abs_planes[p][0] = fabsf(planes[p][0]);
+        abs_planes[p][1] = fabsf(planes[p][1]);
+        abs_planes[p][2] = fabsf(planes[p][2]);
+    }
+
+    uint32_t visible_count = 0;
+    uint32_t i = 0;
+
+    // Each lane tests one box against every plane, survivors are appended without branching.
+#if defined(MGFX_CULL_AVX)
+    for (; i + 8 <= bounds->count; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(bounds->center_x + i);
+        const __m256 cy = _mm256_loadu_ps(bounds->center_y + i);
+        const __m256 cz = _mm256_loadu_ps(bounds->center_z + i);
+        const __m256 ex = _mm256_loadu_ps(bounds->extent_x + i);
+        const __m256 ey = _mm256_loadu_ps(bounds->extent_y + i);
+        const __m256 ez = _mm256_loadu_ps(bounds->extent_z + i);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint32_t p = 0; p < 6; p++) {
+            __m256 dist = _mm256_set1_ps(planes[p][3]);
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(planes[p][0]), cx));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(planes[p][1]), cy));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(planes[p][2]), cz));
+
+            __m256 radius = _mm256_mul_ps(_mm256_set1_ps(abs_planes[p][0]), ex);
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(abs_planes[p][1]), ey));
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(abs_planes[p][2]), ez));
+
+            const __m256 test = _mm256_cmp_ps(
+                _mm256_add_ps(dist, radius), _mm256_setzero_ps(), _CMP_GE_OQ);
+            inside = _mm256_and_ps(inside, test);
+        }
+
+        const uint32_t mask = (uint32_t)_mm256_movemask_ps(inside);
+        for (uint32_t lane = 0; lane < 8; lane++) {
+            visible[visible_count] = i + lane;
+            visible_count += (mask >> lane) & 1;
+        }
+    }
+#elif defined(MGFX_CULL_SSE)
+    for (; i + 4 <= bounds->count; i += 4) {
+        const __m128 cx = _mm_loadu_ps(bounds->center_x + i);
+        const __m128 cy = _mm_loadu_ps(bounds->center_y + i);
+        const __m128 cz = _mm_loadu_ps(bounds->center_z + i);
+        const __m128 ex = _mm_loadu_ps(bounds->extent_x + i);
+        const __m128 ey = _mm_loadu_ps(bounds->extent_y + i);
+        const __m128 ez = _mm_loadu_ps(bounds->extent_z + i);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (uint32_t p = 0; p < 6; p++) {
+            __m128 dist = _mm_set1_ps(planes[p][3]);
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p][0]), cx));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p][1]), cy));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p][2]), cz));
+
+            __m128 radius = _mm_mul_ps(_mm_set1_ps(abs_planes[p][0]), ex);
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(abs_planes[p][1]), ey));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(abs_planes[p][2]), ez));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+
+        const uint32_t mask = (uint32_t)_mm_movemask_ps(inside);
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            visible[visible_count] = i + lane;
+            visible_count += (mask >> lane) & 1;
+        }
+    }
+#elif defined(MGFX_CULL_NEON)
+    for (; i + 4 <= bounds->count; i += 4) {
+        const float32x4_t cx = vld1q_f32(bounds->center_x + i);
+        const float32x4_t cy = vld1q_f32(bounds->center_y + i);
+        const float32x4_t cz = vld1q_f32(bounds->center_z + i);
+        const float32x4_t ex = vld1q_f32(bounds->extent_x + i);
+        const float32x4_t ey = vld1q_f32(bounds->extent_y + i);
+        const float32x4_t ez = vld1q_f32(bounds->extent_z + i);
+
+        uint32x4_t inside = vdupq_n_u32(0xFFFFFFFF);
+        for (uint32_t p = 0; p < 6; p++) {
+            float32x4_t dist = vdupq_n_f32(planes[p][3]);
+            dist = vmlaq_n_f32(dist, cx, planes[p][0]);
+            dist = vmlaq_n_f32(dist, cy, planes[p][1]);
+            dist = vmlaq_n_f32(dist, cz, planes[p][2]);
+
+            float32x4_t radius = vmulq_n_f32(ex, abs_planes[p][0]);
+            radius = vmlaq_n_f32(radius, ey, abs_planes[p][1]);
+            radius = vmlaq_n_f32(radius, ez, abs_planes[p][2]);
+
+            inside = vandq_u32(inside, vcgeq_f32(vaddq_f32(dist, radius), vdupq_n_f32(0.0f)));
+        }
+
+        uint32_t lanes[4];
+        vst1q_u32(lanes, inside);
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            visible[visible_count] = i + lane;
+            visible_count += lanes[lane] & 1;
+        }
+    }
+#endif
+
+    for (; i < bounds->count; i++) {
+        visible[visible_count] = i;
+        visible_count += cull_test(planes, abs_planes, bounds, i) ? 1 : 0;
+    }
+
+    return visible_count;
+}
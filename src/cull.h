@@ -0,0 +1,10 @@
+#ifndef MGFX_CULL_H_
+#define MGFX_CULL_H_
+
+#include <mx/mx.h>
+
+// Extracts the inward facing (a, b, c, d) frustum planes of a column major view projection.
+// Planes are not normalized, they are only used for sign tests.
+void cull_frustum_planes(const float* view_proj, float planes[6][4]);
+
+#endif
@@ -0,0 +1,94 @@
+#include "handle_pool.h"
+
+#include <mx/mx_asserts.h>
+#include <mx/mx_log.h>
+#include <mx/mx_memory.h>
+
+#include <string.h>
+
+static uint16_t handle_generation(uint64_t handle) {
+    return (uint16_t)(handle >> HANDLE_POOL_INDEX_BITS);
+}
+
+void handle_pool_init(handle_pool* pool, uint32_t stride, uint32_t capacity) {
+    MX_ASSERT(capacity > 0 && capacity <= HANDLE_POOL_MAX_SLOTS, "[Handle] Invalid capacity!");
+
+    mx_allocator_t allocator = mx_default_allocator();
+
+    *pool = (handle_pool){
+        .generations = mx_alloc(allocator, capacity * sizeof(uint16_t)),
+        .free_slots = mx_alloc(allocator, capacity * sizeof(uint16_t)),
+        .values = mx_alloc(allocator, (size_t)capacity * stride),
+        .stride = stride,
+        .capacity = capacity,
+    };
+
+    for (uint32_t slot = 0; slot < capacity; slot++) {
+        pool->generations[slot] = 1;
+    }
+}
+
+void handle_pool_destroy(handle_pool* pool) {
+    mx_allocator_t allocator = mx_default_allocator();
+
+    mx_free(allocator, pool->generations);
+    mx_free(allocator, pool->free_slots);
+    mx_free(allocator, pool->values);
+
+    memset(pool, 0, sizeof(handle_pool));
+}
+
+uint64_t handle_pool_alloc(handle_pool* pool, void** value) {
+    uint32_t slot;
+    if (pool->free_count > 0) {
+        slot = pool->free_slots[--pool->free_count];
+    } else if (pool->count < pool->capacity) {
+        slot = pool->count++;
+    } else {
+        MX_LOG_ERROR("[Handle] Pool capacity of %u reached!", pool->capacity);
+        if (value) {
+            *value = NULL;
+        }
+        return 0;
+    }
+
+    void* slot_value = &pool->values[(size_t)slot * pool->stride];
+    memset(slot_value, 0, pool->stride);
+
+    if (value) {
+        *value = slot_value;
+    }
+
+    return ((uint64_t)pool->generations[slot] << HANDLE_POOL_INDEX_BITS) | slot;
+}
+
+void handle_pool_free(handle_pool* pool, uint64_t handle) {
+    if (handle_pool_get(pool, handle) == NULL) {
+        MX_LOG_WARN("[Handle] Attempting to free invalid handle!");
+        return;
+    }
+
+    const uint32_t slot = handle_pool_index(handle);
+
+    // Generation 0 is reserved for invalid handles.
+    if (++pool->generations[slot] == 0) {
+        pool->generations[slot] = 1;
+    }
+
+    pool->free_slots[pool->free_count++] = (uint16_t)slot;
+}
+
+void* handle_pool_get(const handle_pool* pool, uint64_t handle) {
+    const uint32_t slot = handle_pool_index(handle);
+
+    if (slot >= pool->count || handle_generation(handle) != pool->generations[slot] ||
+        handle >> (HANDLE_POOL_INDEX_BITS * 2) != 0) {
+        return NULL;
+    }
+
+    return &pool->values[(size_t)slot * pool->stride];
+}
+
+uint32_t handle_pool_index(uint64_t handle) {
+    return (uint32_t)(handle & (HANDLE_POOL_MAX_SLOTS - 1));
+}
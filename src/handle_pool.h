@@ -0,0 +1,38 @@
+#ifndef MGFX_HANDLE_POOL_H_
+#define MGFX_HANDLE_POOL_H_
+
+#include <mx/mx.h>
+
+// Handles pack a 16 bit slot index in the low bits and the generation of the slot when it was
+// allocated above it. Generations start at 1 so a zero handle is never valid, freeing a slot
+// bumps its generation which invalidates every handle still pointing at it.
+enum { HANDLE_POOL_INDEX_BITS = 16 };
+enum { HANDLE_POOL_MAX_SLOTS = 1 << HANDLE_POOL_INDEX_BITS };
+
+// Values are stored densely by slot, apart from the generations that every lookup reads.
+// Storage is allocated up front and never moves, pointers to values stay valid until freed.
+typedef struct handle_pool {
+    uint16_t* generations;
+    uint16_t* free_slots;
+    uint8_t* values;
+
+    uint32_t stride;
+    uint32_t capacity;
+    uint32_t count; // Slots handed out at least once.
+    uint32_t free_count;
+} handle_pool;
+
+void handle_pool_init(handle_pool* pool, uint32_t stride, uint32_t capacity);
+void handle_pool_destroy(handle_pool* pool);
+
+// Returns the handle of a zeroed value, or 0 and a NULL value when the pool is full. Allocation
+// and free are not thread safe, lookups are.
+uint64_t handle_pool_alloc(handle_pool* pool, void** value);
+void handle_pool_free(handle_pool* pool, uint64_t handle);
+
+// Returns NULL for zero, stale or out of range handles.
+void* handle_pool_get(const handle_pool* pool, uint64_t handle);
+
+uint32_t handle_pool_index(uint64_t handle);
+
+#endif
@@ -0,0 +1,361 @@
+#include "jobs.h"
+
+#include <mx/mx_asserts.h>
+#include <mx/mx_log.h>
+
+#ifdef MX_WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef HANDLE thread_t;
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+
+#define mutex_init(m)      InitializeCriticalSection(m)
+#define mutex_destroy(m)   DeleteCriticalSection(m)
+#define mutex_lock(m)      EnterCriticalSection(m)
+#define mutex_unlock(m)    LeaveCriticalSection(m)
+#define cond_init(c)       InitializeConditionVariable(c)
+#define cond_destroy(c)    ((void)(c))
+#define cond_wait(c, m)    SleepConditionVariableCS(c, m, INFINITE)
+#define cond_broadcast(c)  WakeAllConditionVariable(c)
+#define cond_signal(c)     WakeConditionVariable(c)
+#else
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+
+#define mutex_init(m)      pthread_mutex_init(m, NULL)
+#define mutex_destroy(m)   pthread_mutex_destroy(m)
+#define mutex_lock(m)      pthread_mutex_lock(m)
+#define mutex_unlock(m)    pthread_mutex_unlock(m)
+#define cond_init(c)       pthread_cond_init(c, NULL)
+#define cond_destroy(c)    pthread_cond_destroy(c)
+#define cond_wait(c, m)    pthread_cond_wait(c, m)
+#define cond_broadcast(c)  pthread_cond_broadcast(c)
+#define cond_signal(c)     pthread_cond_signal(c)
+#endif
+
+typedef struct jobs_range {
+    jobs_range_fn fn;
+    void* ctx;
+    uint32_t count;
+    uint32_t range_count;
+} jobs_range;
+
+static thread_t s_threads[MGFX_JOBS_MAX_WORKERS];
+static uint32_t s_worker_count = 1;
+
+static mutex_t s_mutex;
+static cond_t s_start_cond;
+static cond_t s_done_cond;
+
+static jobs_range s_range;
+static uint64_t s_generation = 0;
+static uint32_t s_pending = 0;
+static mx_bool s_quit = MX_FALSE;
+
+typedef struct jobs_task {
+    jobs_task_fn fn;
+    void* ctx;
+} jobs_task;
+
+// Tasks are a fixed ring consumed by their own threads, guarded by a separate mutex.
+static thread_t s_task_threads[MGFX_JOBS_MAX_TASK_THREADS];
+static uint32_t s_task_thread_count = 0;
+
+static mutex_t s_task_mutex;
+static cond_t s_task_cond;
+static cond_t s_task_idle_cond;
+
+static jobs_task s_tasks[MGFX_JOBS_MAX_TASKS];
+static uint32_t s_task_head = 0;
+static uint32_t s_task_count = 0;
+static uint32_t s_tasks_running = 0;
+static mx_bool s_task_quit = MX_FALSE;
+
+static void jobs_run_range(const jobs_range* range, uint32_t worker) {
+    if (worker >= range->range_count) {
+        return;
+    }
+
+    const uint32_t begin = (uint32_t)((uint64_t)range->count * worker / range->range_count);
+    const uint32_t end = (uint32_t)((uint64_t)range->count * (worker + 1) / range->range_count);
+    range->fn(range->ctx, begin, end, worker);
+}
+
+static void jobs_worker_loop(uint32_t worker) {
+    uint64_t generation = 0;
+
+    for (;;) {
+        mutex_lock(&s_mutex);
+        while (s_generation == generation && !s_quit) {
+            cond_wait(&s_start_cond, &s_mutex);
+        }
+
+        if (s_quit) {
+            mutex_unlock(&s_mutex);
+            return;
+        }
+
+        generation = s_generation;
+        jobs_range range = s_range;
+        mutex_unlock(&s_mutex);
+
+        jobs_run_range(&range, worker);
+
+        mutex_lock(&s_mutex);
+        if (--s_pending == 0) {
+            cond_signal(&s_done_cond);
+        }
+        mutex_unlock(&s_mutex);
+    }
+}
+
+// Queued tasks are drained before the thread exits.
+static void jobs_task_loop() {
+    for (;;) {
+        mutex_lock(&s_task_mutex);
+        while (s_task_count == 0 && !s_task_quit) {
+            cond_wait(&s_task_cond, &s_task_mutex);
+        }
+
+        if (s_task_count == 0) {
+            mutex_unlock(&s_task_mutex);
+            return;
+        }
+
+        const jobs_task task = s_tasks[s_task_head];
+        s_task_head = (s_task_head + 1) % MGFX_JOBS_MAX_TASKS;
+        s_task_count--;
+        s_tasks_running++;
+        mutex_unlock(&s_task_mutex);
+
+        task.fn(task.ctx);
+
+        mutex_lock(&s_task_mutex);
+        if (--s_tasks_running == 0 && s_task_count == 0) {
+            cond_broadcast(&s_task_idle_cond);
+        }
+        mutex_unlock(&s_task_mutex);
+    }
+}
+
+#ifdef MX_WIN32
+static DWORD WINAPI jobs_worker_main(LPVOID arg) {
+    jobs_worker_loop((uint32_t)(uintptr_t)arg);
+    return 0;
+}
+
+static DWORD WINAPI jobs_task_main(LPVOID arg) {
+    jobs_task_loop();
+    return 0;
+}
+#else
+static void* jobs_worker_main(void* arg) {
+    jobs_worker_loop((uint32_t)(uintptr_t)arg);
+    return NULL;
+}
+
+static void* jobs_task_main(void* arg) {
+    jobs_task_loop();
+    return NULL;
+}
+#endif
+
+static uint32_t jobs_cpu_count() {
+#ifdef MX_WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint32_t)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+#endif
+}
+
+void jobs_init(uint32_t worker_count) {
+    const uint32_t cpu_count = jobs_cpu_count();
+    if (worker_count == 0) {
+        worker_count = cpu_count;
+    }
+
+    if (worker_count > MGFX_JOBS_MAX_WORKERS) {
+        worker_count = MGFX_JOBS_MAX_WORKERS;
+    }
+
+    mutex_init(&s_mutex);
+    cond_init(&s_start_cond);
+    cond_init(&s_done_cond);
+
+    s_quit = MX_FALSE;
+    s_generation = 0;
+    s_worker_count = 1;
+
+    for (uint32_t i = 1; i < worker_count; i++) {
+#ifdef MX_WIN32
+        s_threads[i] = CreateThread(NULL, 0, jobs_worker_main, (LPVOID)(uintptr_t)i, 0, NULL);
+        if (s_threads[i] == NULL) {
+            MX_LOG_WARN("[Jobs] Failed to create worker thread %u!", i);
+            break;
+        }
+#else
+        if (pthread_create(&s_threads[i], NULL, jobs_worker_main, (void*)(uintptr_t)i) != 0) {
+            MX_LOG_WARN("[Jobs] Failed to create worker thread %u!", i);
+            break;
+        }
+#endif
+        s_worker_count++;
+    }
+
+    mutex_init(&s_task_mutex);
+    cond_init(&s_task_cond);
+    cond_init(&s_task_idle_cond);
+
+    s_task_quit = MX_FALSE;
+    s_task_head = 0;
+    s_task_count = 0;
+    s_task_thread_count = 0;
+
+    // Tasks are mostly file io and decoding, half the cpus keep them off the parallel ranges.
+    uint32_t task_thread_count = cpu_count / 2;
+    if (task_thread_count < 1) {
+        task_thread_count = 1;
+    }
+
+    if (task_thread_count > MGFX_JOBS_MAX_TASK_THREADS) {
+        task_thread_count = MGFX_JOBS_MAX_TASK_THREADS;
+    }
+
+    for (uint32_t i = 0; i < task_thread_count; i++) {
+#ifdef MX_WIN32
+        s_task_threads[i] = CreateThread(NULL, 0, jobs_task_main, NULL, 0, NULL);
+        if (s_task_threads[i] == NULL) {
+            MX_LOG_WARN("[Jobs] Failed to create task thread %u!", i);
+            break;
+        }
+#else
+        if (pthread_create(&s_task_threads[i], NULL, jobs_task_main, NULL) != 0) {
+            MX_LOG_WARN("[Jobs] Failed to create task thread %u!", i);
+            break;
+        }
+#endif
+        s_task_thread_count++;
+    }
+
+    MX_LOG_INFO("[Jobs] %u worker(s), %u task thread(s).", s_worker_count, s_task_thread_count);
+}
+
+void jobs_shutdown() {
+    mutex_lock(&s_task_mutex);
+    s_task_quit = MX_TRUE;
+    cond_broadcast(&s_task_cond);
+    mutex_unlock(&s_task_mutex);
+
+    for (uint32_t i = 0; i < s_task_thread_count; i++) {
+#ifdef MX_WIN32
+        WaitForSingleObject(s_task_threads[i], INFINITE);
+        CloseHandle(s_task_threads[i]);
+#else
+        pthread_join(s_task_threads[i], NULL);
+#endif
+    }
+
+    s_task_thread_count = 0;
+
+    cond_destroy(&s_task_idle_cond);
+    cond_destroy(&s_task_cond);
+    mutex_destroy(&s_task_mutex);
+
+    mutex_lock(&s_mutex);
+    s_quit = MX_TRUE;
+    cond_broadcast(&s_start_cond);
+    mutex_unlock(&s_mutex);
+
+    for (uint32_t i = 1; i < s_worker_count; i++) {
+#ifdef MX_WIN32
+        WaitForSingleObject(s_threads[i], INFINITE);
+        CloseHandle(s_threads[i]);
+#else
+        pthread_join(s_threads[i], NULL);
+#endif
+    }
+
+    s_worker_count = 1;
+
+    cond_destroy(&s_done_cond);
+    cond_destroy(&s_start_cond);
+    mutex_destroy(&s_mutex);
+}
+
+uint32_t jobs_worker_count() { return s_worker_count; }
+
+void jobs_parallel_for(uint32_t count, uint32_t min_range, jobs_range_fn fn, void* ctx) {
+    MX_ASSERT(fn != NULL, "[Jobs] Range function is null!");
+
+    if (count == 0) {
+        return;
+    }
+
+    uint32_t range_count = min_range > 0 ? count / min_range : count;
+    if (range_count > s_worker_count) {
+        range_count = s_worker_count;
+    }
+
+    if (range_count <= 1) {
+        fn(ctx, 0, count, 0);
+        return;
+    }
+
+    jobs_range range = {.fn = fn, .ctx = ctx, .count = count, .range_count = range_count};
+
+    mutex_lock(&s_mutex);
+    s_range = range;
+    s_pending = s_worker_count - 1;
+    s_generation++;
+    cond_broadcast(&s_start_cond);
+    mutex_unlock(&s_mutex);
+
+    jobs_run_range(&range, 0);
+
+    mutex_lock(&s_mutex);
+    while (s_pending > 0) {
+        cond_wait(&s_done_cond, &s_mutex);
+    }
+    mutex_unlock(&s_mutex);
+}
+
+void jobs_submit(jobs_task_fn fn, void* ctx) {
+    MX_ASSERT(fn != NULL, "[Jobs] Task function is null!");
+
+    mutex_lock(&s_task_mutex);
+    if (s_task_thread_count == 0 || s_task_count == MGFX_JOBS_MAX_TASKS) {
+        mutex_unlock(&s_task_mutex);
+        fn(ctx);
+        return;
+    }
+
+    s_tasks[(s_task_head + s_task_count) % MGFX_JOBS_MAX_TASKS] = (jobs_task){fn, ctx};
+    s_task_count++;
+    cond_signal(&s_task_cond);
+    mutex_unlock(&s_task_mutex);
+}
+
+void jobs_wait() {
+    mutex_lock(&s_task_mutex);
+    while (s_task_count > 0 || s_tasks_running > 0) {
+        cond_wait(&s_task_idle_cond, &s_task_mutex);
+    }
+    mutex_unlock(&s_task_mutex);
+}
+
+uint32_t jobs_atomic_add(volatile uint32_t* target, uint32_t value) {
+#ifdef MX_WIN32
+    return (uint32_t)InterlockedExchangeAdd((volatile LONG*)target, (LONG)value);
+#else
+    return __atomic_fetch_add(target, value, __ATOMIC_ACQ_REL);
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef MGFX_JOBS_H_
+#define MGFX_JOBS_H_
+
+#include <mx/mx.h>
+
+enum { MGFX_JOBS_MAX_WORKERS = 16 };
+enum { MGFX_JOBS_MAX_TASK_THREADS = 4 };
+enum { MGFX_JOBS_MAX_TASKS = 1024 };
+
+// Processes [begin, end) of a parallel range. `worker` is in [0, jobs_worker_count()).
+typedef void (*jobs_range_fn)(void* ctx, uint32_t begin, uint32_t end, uint32_t worker);
+
+// Runs on a background task thread.
+typedef void (*jobs_task_fn)(void* ctx);
+
+// Starts `worker_count` - 1 background threads; the calling thread is always worker 0.
+// A worker count of 0 uses the number of online cpus. Task threads are started separately from
+// the workers so long tasks never stall a parallel range.
+void jobs_init(uint32_t worker_count);
+
+// Runs the queued tasks before joining the task threads.
+void jobs_shutdown();
+
+uint32_t jobs_worker_count();
+
+// Splits [0, count) into one contiguous range per worker and blocks until all ranges are done.
+// Range `i` always goes to worker `i`, so per-worker scratch indexed by `worker` is ordered.
+// Ranges smaller than `min_range` are merged and fewer workers are used.
+void jobs_parallel_for(uint32_t count, uint32_t min_range, jobs_range_fn fn, void* ctx);
+
+// Queues `fn` on the task threads and returns immediately. Tasks start in submit order, a task
+// submitted while the queue is full runs on the calling thread instead.
+void jobs_submit(jobs_task_fn fn, void* ctx);
+
+// Blocks until every submitted task has finished.
+void jobs_wait();
+
+// Atomically adds `value` and returns the previous value.
+uint32_t jobs_atomic_add(volatile uint32_t* target, uint32_t value);
+
+#endif
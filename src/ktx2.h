@@ -0,0 +1,37 @@
+#ifndef MGFX_KTX2_H_
+#define MGFX_KTX2_H_
+
+#include <mx/mx.h>
+
+// Ktx2 container layout shared by the texture loader and the offline baker. The header is
+// followed by one ktx2_level per mip level, level 0 first.
+enum { KTX2_IDENTIFIER_SIZE = 12 };
+#define KTX2_IDENTIFIER {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'}
+
+typedef struct ktx2_header {
+    uint8_t identifier[KTX2_IDENTIFIER_SIZE];
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+    uint64_t sgd_byte_offset;
+    uint64_t sgd_byte_length;
+} ktx2_header;
+
+typedef struct ktx2_level {
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+} ktx2_level;
+
+#endif
@@ -9,6 +9,7 @@
 #include <mx/mx_file.h>
 #include <mx/mx_hash.h>
 #include <mx/mx_memory.h>
+#include <stddef.h>
 #include <string.h>
 
 #ifdef MX_MACOS
@@ -24,6 +25,13 @@
 
 #include <vulkan/vulkan_core.h>
 
+#ifdef MGFX_BASISU
+#include "basis_transcoder.h"
+#endif
+#include "cull.h"
+#include "handle_pool.h"
+#include "jobs.h"
+#include "ktx2.h"
 #include "renderer_vk.h"
 
 #include <spirv_reflect/spirv_reflect.h>
@@ -34,10 +42,17 @@
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb/stb_truetype.h>
 
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
 typedef struct mgfx_texture {
-    mgfx_imgh imgh;        // VkImage
-    uint64_t address_mode; // VkSamplerAddressMode
-    uint64_t sampler;      // VkSampler
+    mgfx_imgh imgh;   // image_vk, from s_images.
+    uint64_t view;    // VkImageView, from s_image_views.
+    uint64_t sampler; // VkSampler, from s_samplers.
+
+    struct texture_load_vk* load; // Pending async load.
+    mx_bool placeholder;          // The image and view belong to the placeholder texture.
 } mgfx_texture;
 
 typedef struct mgfx_program {
@@ -50,9 +65,14 @@ typedef struct mgfx_program {
             int32_t primitive_topology; // VkPrimitiveTopology
             int32_t polygon_mode;       // VkPolygonMode
             int32_t cull_mode;          // VkPolygonMode
+            mx_bool blend;
         };
     };
 
+    uint16_t id; // Compact id used by draw sort keys.
+    mx_bool view_block; // Reads the built in per view uniform block at MGFX_SHADER_VIEW_SET.
+    mx_bool bindless;   // Reads the global bindless arrays at MGFX_SHADER_BINDLESS_SET.
+
     uint64_t pipeline;        // VkPipeline
     uint64_t pipeline_layout; // VkPipelineLayout
 } mgfx_program;
@@ -103,15 +123,6 @@ const VkFormat k_surface_fmt = VK_FORMAT_B8G8R8A8_SRGB;
 const VkColorSpaceKHR k_surface_color_space = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 const VkPresentModeKHR k_present_mode = VK_PRESENT_MODE_FIFO_KHR;
 
-const VkDescriptorPoolSize k_ds_pool_sizes[] = {
-    {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = 128},
-    {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = 32},
-
-    {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 128},
-};
-
-uint32_t k_ds_pool_sizes_count = 3;
-
 #ifdef MX_DEBUG
 VkResult create_debug_util_messenger_ext(VkInstance instance,
                                          const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
@@ -180,6 +191,12 @@ static VkInstance s_instance = VK_NULL_HANDLE;
 static VkPhysicalDevice s_phys_device = VK_NULL_HANDLE;
 static VkPhysicalDeviceProperties s_phys_device_props;
 
+// Optional device features, indirect draws fall back to one call per draw without them.
+static mx_bool s_multi_draw_indirect = MX_FALSE;
+static mx_bool s_texture_compression_bc = MX_FALSE;
+static mx_bool s_draw_indirect_count = MX_FALSE;
+static mx_bool s_draw_indirect_first_instance = MX_FALSE;
+
 static VkDevice s_device = VK_NULL_HANDLE;
 static VmaAllocator s_allocator;
 
@@ -193,21 +210,87 @@ static swapchain_vk s_swapchain;
 static frame_vk s_frames[MGFX_FRAME_COUNT];
 static uint32_t s_frame_idx = 0;
 
-static VkDescriptorPool s_ds_pool;
-
-enum { MGFX_MAX_FRAME_BUFFER_COPIES = 300 };
-static buffer_to_buffer_copy_vk s_buffer_to_buffer_copy_queue[MGFX_MAX_FRAME_BUFFER_COPIES];
-static uint32_t s_buffer_to_buffer_copy_count = 0;
-
-static buffer_to_image_copy_vk s_buffer_to_image_copy_queue[MGFX_MAX_FRAME_BUFFER_COPIES];
-static uint32_t s_buffer_to_image_copy_count = 0;
+// Per view transforms, matches `mgfx_view` in shaders. Every frame in flight owns a copy of all
+// views in one dynamic uniform buffer, draws select their view with a dynamic offset. Blocks are
+// 256 bytes which satisfies every minUniformBufferOffsetAlignment.
+typedef struct view_block_vk {
+    float view[16];
+    float proj[16];
+    float view_proj[16];
+    float view_inv[16];
+} view_block_vk;
+
+static view_block_vk s_view_blocks[0xFF];
+static uniform_buffer_vk s_view_buffer;
+static VkDescriptorSetLayout s_view_dsl;
+static VkDescriptorSet s_view_ds;
+
+// Global arrays of every texture and storage buffer indexed by handle slot, see
+// mgfx_init_info.bindless. Each frame in flight owns a set, writes are queued for all of them and
+// applied once a frame's fence signaled, so a set is never updated while the gpu reads it.
+static mx_bool s_bindless = MX_FALSE;
+static VkDescriptorSetLayout s_bindless_dsl;
+static VkDescriptorPool s_bindless_pool;
+static VkDescriptorSet s_bindless_ds[MGFX_FRAME_COUNT];
+
+// Transient uniforms are bump allocated from one region of a persistently mapped buffer per
+// submitted frame. There is one region more than frames in flight, the region being written was
+// last read by a frame whose fence has already been waited on. Every transient descriptor covers
+// a fixed range and selects its data with a dynamic offset, the tail padding keeps the range of
+// the last allocation inside the buffer.
+enum { MGFX_TRANSIENT_UNIFORM_REGION_SIZE = MX_MB * 4 };
+enum { MGFX_TRANSIENT_UNIFORM_REGIONS = MGFX_FRAME_COUNT + 1 };
+enum { MGFX_TRANSIENT_UNIFORM_RANGE = MX_KB * 16 };
+
+static uniform_buffer_vk s_tub_buffer;
+static uint8_t* s_tub_data;
+static uint32_t s_tub_region = 0;
+static volatile uint32_t s_tub_head = 0;
+
+// Uploads to device local memory are staged through chained host visible blocks, see the
+// staging section below.
+// Uploads return a handle that goes stale once the upload completed.
+static uint64_t staging_buffer_upload(
+    buffer_vk* buffer, size_t offset, size_t size, const void* data, uint32_t priority);
+static uint64_t staging_image_upload(image_vk* image,
+                                     uint32_t level,
+                                     size_t size,
+                                     const void* data,
+                                     uint32_t priority);
+static void staging_upload_cancel(const buffer_vk* buffer, const image_vk* image);
+
+// Objects released while frames may still reference them are destroyed once the frame that last
+// referenced them retires, instead of waiting for the whole device to idle.
+typedef enum deletion_type_vk {
+    DELETION_TYPE_BUFFER,
+    DELETION_TYPE_IMAGE,
+    DELETION_TYPE_IMAGE_VIEW,
+    DELETION_TYPE_SAMPLER,
+    DELETION_TYPE_PIPELINE,
+    DELETION_TYPE_PIPELINE_LAYOUT,
+    DELETION_TYPE_DESCRIPTOR_SET_LAYOUT,
+    DELETION_TYPE_DESCRIPTOR_SET,
+    DELETION_TYPE_SWAPCHAIN,
+} deletion_type_vk;
+
+static void deletion_queue_push(deletion_type_vk type, uint64_t handle, VmaAllocation allocation);
+static void deletion_queue_push_descriptor_set(VkDescriptorPool pool, VkDescriptorSet set);
+static void descriptor_sets_evict_layout(VkDescriptorSetLayout dsl);
+static VkDescriptorSet descriptor_set_allocate(VkDescriptorSetLayout dsl, VkDescriptorPool* pool);
+
+static uint32_t image_mip_levels(const mgfx_image_info* info) {
+    if (info->mip_levels != MGFX_MIP_LEVELS_AUTO) {
+        return info->mip_levels > 0 ? info->mip_levels : 1;
+    }
 
-static ring_buffer_vk s_tvb_pool; // Transient vertex buffer pool
-static ring_buffer_vk s_tib_pool; // Transient index buffer pool
+    uint32_t levels = 1;
+    const uint32_t extent = info->width > info->height ? info->width : info->height;
+    for (uint32_t size = extent; size > 1; size >>= 1) {
+        levels++;
+    }
 
-static mgfx_transient_buffer s_tsbs[MGFX_MAX_FRAME_BUFFER_COPIES];
-static uint32_t s_tsbs_count = 0;
-static ring_buffer_vk s_tsb_pool; // Transient staging buffer pool
+    return levels;
+}
 
 void image_create(const mgfx_image_info* info,
                   VkImageUsageFlags usage,
@@ -216,9 +299,41 @@ void image_create(const mgfx_image_info* info,
     image->format = info->format;
     image->layer_count = info->layers;
     image->extent = (VkExtent3D){info->width, info->height, 1};
+    image->mip_levels = image_mip_levels(info);
+    image->generate_mips = MX_FALSE;
+    memset(image->deferred_uploads, 0, sizeof(image->deferred_uploads));
 
     usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
+    const mx_bool compressed = vk_format_block_extent(image->format) > 1;
+    MX_ASSERT(!compressed || s_texture_compression_bc, "[Image] Block compression unsupported!");
+
+    // Block compressed chains are uploaded level by level, they can not be blitted.
+    if (image->mip_levels > 1 && compressed) {
+        if (info->mip_levels == MGFX_MIP_LEVELS_AUTO) {
+            MX_LOG_WARN("[Image] Compressed format %u can not generate mips, using a single level!",
+                        image->format);
+            image->mip_levels = 1;
+        }
+    } else if (image->mip_levels > 1) {
+        // Mip chains are blitted from level 0, which needs linear filtering of the format.
+        const VkFormatFeatureFlags blit_features =
+            VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+        VkFormatProperties format_props;
+        vkGetPhysicalDeviceFormatProperties(s_phys_device, image->format, &format_props);
+
+        if ((format_props.optimalTilingFeatures & blit_features) != blit_features) {
+            MX_LOG_WARN("[Image] Format %u can not generate mips, using a single level!",
+                        image->format);
+            image->mip_levels = 1;
+        } else {
+            usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            image->generate_mips = MX_TRUE;
+        }
+    }
+
     VkImageCreateInfo image_info = {
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .pNext = NULL,
@@ -226,7 +341,7 @@ void image_create(const mgfx_image_info* info,
         .imageType = VK_IMAGE_TYPE_2D,
         .format = image->format,
         .extent = image->extent,
-        .mipLevels = 1,
+        .mipLevels = image->mip_levels,
         .arrayLayers = info->layers,
         .samples = 1,
         .tiling = VK_IMAGE_TILING_OPTIMAL,
@@ -268,10 +383,42 @@ void image_create(const mgfx_image_info* info,
 #endif
 }
 
-void image_create_view(const image_vk* image,
-                       VkImageViewType type,
-                       VkImageAspectFlags aspect,
-                       VkImageView* view) {
+// Views are shared by every texture and framebuffer viewing an image the same way, keyed by
+// their create info and released once the last user is gone.
+typedef struct image_view_key_vk {
+    VkImage image;
+    uint32_t type;   // VkImageViewType
+    uint32_t aspect; // VkImageAspectFlags
+} image_view_key_vk;
+
+typedef struct image_view_entry_vk {
+    image_view_key_vk key;
+    VkImageView view;
+    uint32_t ref_count;
+
+    UT_hash_handle hh;      // s_image_views, by key.
+    UT_hash_handle hh_view; // s_image_views_by_view, by view.
+} image_view_entry_vk;
+
+static image_view_entry_vk* s_image_views;
+static image_view_entry_vk* s_image_views_by_view;
+
+VkImageView image_view_acquire(const image_vk* image,
+                               VkImageViewType type,
+                               VkImageAspectFlags aspect) {
+    image_view_key_vk key;
+    memset(&key, 0, sizeof(key));
+    key.image = image->handle;
+    key.type = type;
+    key.aspect = aspect;
+
+    image_view_entry_vk* cached;
+    HASH_FIND(hh, s_image_views, &key, sizeof(image_view_key_vk), cached);
+    if (cached) {
+        cached->ref_count++;
+        return cached->view;
+    }
+
     VkImageViewCreateInfo info = {
         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .pNext = NULL,
@@ -290,48 +437,67 @@ void image_create_view(const image_vk* image,
             {
                 .aspectMask = aspect,
                 .baseMipLevel = 0,
-                .levelCount = 1,
+                .levelCount = VK_REMAINING_MIP_LEVELS,
                 .baseArrayLayer = 0,
                 .layerCount = image->layer_count,
             },
     };
 
-    VK_CHECK(vkCreateImageView(s_device, &info, NULL, view));
+    image_view_entry_vk* entry = mx_alloc(mx_default_allocator(), sizeof(image_view_entry_vk));
+    *entry = (image_view_entry_vk){.key = key, .ref_count = 1};
+    VK_CHECK(vkCreateImageView(s_device, &info, NULL, &entry->view));
+
+    HASH_ADD(hh, s_image_views, key, sizeof(image_view_key_vk), entry);
+    HASH_ADD(hh_view, s_image_views_by_view, view, sizeof(VkImageView), entry);
+
+    return entry->view;
 }
 
-void transient_buffer_allocate(ring_buffer_vk* pool,
-                               const void* data,
-                               size_t len,
-                               mgfx_transient_buffer* out);
-void image_update(const void* data, size_t size, image_vk* image) {
-    MX_ASSERT(s_tsbs_count < MGFX_MAX_FRAME_BUFFER_COPIES);
-    mgfx_transient_buffer* staging_buffer = &s_tsbs[s_tsbs_count++];
-    transient_buffer_allocate(&s_tsb_pool, data, size, staging_buffer);
+void image_view_retain(VkImageView view) {
+    image_view_entry_vk* entry;
+    HASH_FIND(hh_view, s_image_views_by_view, &view, sizeof(VkImageView), entry);
+    MX_ASSERT(entry != NULL, "[ImageView] Retaining an unknown view!");
 
-    MX_ASSERT(s_buffer_to_image_copy_count < MGFX_MAX_FRAME_BUFFER_COPIES);
-    s_buffer_to_image_copy_queue[s_buffer_to_image_copy_count++] = (buffer_to_image_copy_vk){
-        .copy =
-            {
-                .bufferOffset = staging_buffer->offset,
-                .bufferRowLength = 0,
-                .bufferImageHeight = 0,
-                .imageSubresource =
-                    {
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .mipLevel = 0,
-                        .baseArrayLayer = 0,
-                        .layerCount = 1,
-                    },
-                .imageOffset = 0,
-                .imageExtent = image->extent,
-            },
-        .src = &s_tsb_pool.buffer,
-        .dst = image,
-    };
-};
+    entry->ref_count++;
+}
+
+static void image_view_entry_destroy(image_view_entry_vk* entry) {
+    deletion_queue_push(DELETION_TYPE_IMAGE_VIEW, (uint64_t)entry->view, VK_NULL_HANDLE);
+
+    HASH_DELETE(hh, s_image_views, entry);
+    HASH_DELETE(hh_view, s_image_views_by_view, entry);
+    mx_free(mx_default_allocator(), entry);
+}
+
+// Views evicted with their image are ignored.
+void image_view_release(VkImageView view) {
+    image_view_entry_vk* entry;
+    HASH_FIND(hh_view, s_image_views_by_view, &view, sizeof(VkImageView), entry);
+
+    if (entry && --entry->ref_count == 0) {
+        image_view_entry_destroy(entry);
+    }
+}
+
+// A destroyed image handle can be reused by the driver, its views must not outlive it.
+static void image_views_evict(VkImage image) {
+    image_view_entry_vk *entry, *tmp;
+    HASH_ITER(hh, s_image_views, entry, tmp) {
+        if (entry->key.image == image) {
+            image_view_entry_destroy(entry);
+        }
+    }
+}
+
+uint64_t image_update(
+    const void* data, size_t size, image_vk* image, uint32_t level, uint32_t priority) {
+    return staging_image_upload(image, level, size, data, priority);
+}
 
 void image_destroy(image_vk* image) {
-    vmaDestroyImage(s_allocator, image->handle, image->allocation);
+    staging_upload_cancel(NULL, image);
+    image_views_evict(image->handle);
+    deletion_queue_push(DELETION_TYPE_IMAGE, (uint64_t)image->handle, image->allocation);
 
     image->handle = VK_NULL_HANDLE;
     image->layout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -378,7 +544,7 @@ int swapchain_create(
     swapchain_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchain_info.presentMode = k_present_mode;
     swapchain_info.clipped = VK_TRUE;
-    swapchain_info.oldSwapchain = NULL;
+    swapchain_info.oldSwapchain = sc->handle;
 
     VK_CHECK(vkCreateSwapchainKHR(s_device, &swapchain_info, NULL, &sc->handle));
 
@@ -450,6 +616,7 @@ void buffer_create(size_t size,
                    VmaAllocationCreateFlags flags,
                    buffer_vk* buffer) {
     buffer->usage = usage;
+    memset(buffer->deferred_uploads, 0, sizeof(buffer->deferred_uploads));
 
     VkBufferCreateInfo info = {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -496,8 +663,9 @@ void buffer_create(size_t size,
 #endif
 };
 
-// Forward declare transient for staging buffers
-void buffer_update(buffer_vk* buffer, size_t buffer_offset, size_t size, const void* data) {
+// Host visible buffers are written directly, their upload completes immediately.
+uint64_t buffer_upload(
+    buffer_vk* buffer, size_t buffer_offset, size_t size, const void* data, uint32_t priority) {
     size_t dst_offset = buffer_offset;
 
     VmaAllocationInfo alloc_info;
@@ -513,25 +681,14 @@ void buffer_update(buffer_vk* buffer, size_t buffer_offset, size_t size, const v
 
     if ((memory_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
         memcpy((uint8_t*)alloc_info.pMappedData + dst_offset, data, size);
-        return;
+        return 0;
     }
 
-    // TODO: Recover and resize
-    MX_ASSERT(s_tsbs_count < MGFX_MAX_FRAME_BUFFER_COPIES);
-    mgfx_transient_buffer* staging_buffer = &s_tsbs[s_tsbs_count++];
-    transient_buffer_allocate(&s_tsb_pool, data, size, staging_buffer);
+    return staging_buffer_upload(buffer, dst_offset, size, data, priority);
+}
 
-    MX_ASSERT(s_buffer_to_buffer_copy_count < MGFX_MAX_FRAME_BUFFER_COPIES);
-    s_buffer_to_buffer_copy_queue[s_buffer_to_buffer_copy_count++] = (buffer_to_buffer_copy_vk){
-        .copy =
-            {
-                .srcOffset = staging_buffer->offset,
-                .dstOffset = dst_offset,
-                .size = size,
-            },
-        .src = &s_tsb_pool.buffer,
-        .dst = buffer,
-    };
+void buffer_update(buffer_vk* buffer, size_t buffer_offset, size_t size, const void* data) {
+    buffer_upload(buffer, buffer_offset, size, data, MGFX_UPLOAD_PRIORITY_IMMEDIATE);
 }
 
 void buffer_resize(buffer_vk* buffer, size_t size) {
@@ -551,7 +708,8 @@ void buffer_resize(buffer_vk* buffer, size_t size) {
 }
 
 void buffer_destroy(buffer_vk* buffer) {
-    vmaDestroyBuffer(s_allocator, (VkBuffer)buffer->handle, buffer->allocation);
+    staging_upload_cancel(buffer, NULL);
+    deletion_queue_push(DELETION_TYPE_BUFFER, (uint64_t)buffer->handle, buffer->allocation);
 
     buffer->handle = VK_NULL_HANDLE;
     buffer->allocation = VK_NULL_HANDLE;
@@ -575,10 +733,12 @@ void index_buffer_create(const void* data, size_t len, index_buffer_vk* buffer)
     }
 };
 
-void uniform_buffer_create(const void* data, size_t len, uniform_buffer_vk* buffer) {
+void indirect_buffer_create(const void* data, size_t len, indirect_buffer_vk* buffer) {
+    // Storage usage lets compute shaders write draw arguments.
     buffer_create(len,
-                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                  VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                  VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                  0,
                   buffer);
 
     if (data) {
@@ -586,64 +746,25 @@ void uniform_buffer_create(const void* data, size_t len, uniform_buffer_vk* buff
     }
 };
 
-void ring_buffer_create(size_t size,
-                        VkBufferUsageFlags usage,
-                        VmaAllocationCreateFlags allocation_flags,
-                        ring_buffer_vk* out) {
-    memset(out, 0, sizeof(ring_buffer_vk));
-
-    buffer_create(size, usage, allocation_flags, &out->buffer);
-    out->size = size;
-}
-
-void transient_buffer_allocate(ring_buffer_vk* pool,
-                               const void* data,
-                               size_t len,
-                               mgfx_transient_buffer* out) {
-    size_t free_size = pool->size - pool->head;
-
-    // Pad to prevent wrap around
-    uint32_t padding = 0;
-    uint32_t offset = 0;
-
-    if (len > free_size) {
-        padding = free_size;
-
-        uint32_t overflow = len - free_size;
-        if (overflow > pool->tail) {
-            // TODO:Resize
-            MX_ASSERT(
-                MX_FALSE,
-                "[TransientBuffer] allocation failed. Must consume allocated transient buffers!");
-        }
+void storage_buffer_create(const void* data, size_t len, storage_buffer_vk* buffer) {
+    buffer_create(
+        len, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, buffer);
 
-        offset = 0;
-    } else {
-        offset = pool->head;
+    if (data) {
+        buffer_update(buffer, 0, len, data);
     }
+};
 
-    buffer_update(&pool->buffer, offset, len, data);
-
-    *out = (mgfx_transient_buffer){
-        .size = (uint32_t)len + padding,
-        .offset = offset,
-        .buffer_handle = (mx_ptr_t)pool->buffer.handle,
-    };
-
-    pool->head = (uint32_t)((pool->head + len + padding) % pool->size);
-}
-
-void transient_vertex_buffer_free(mgfx_transient_buffer* tvb) {
-    s_tvb_pool.tail = (s_tvb_pool.tail + tvb->size) % s_tvb_pool.size;
-}
-
-void transient_index_buffer_free(mgfx_transient_buffer* tib) {
-    s_tib_pool.tail = (s_tib_pool.tail + tib->size) % s_tib_pool.size;
-}
+void uniform_buffer_create(const void* data, size_t len, uniform_buffer_vk* buffer) {
+    buffer_create(len,
+                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                  VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                  buffer);
 
-void transient_staging_buffer_free(mgfx_transient_buffer* tsb) {
-    s_tsb_pool.tail = (s_tsb_pool.tail + tsb->size) % s_tsb_pool.size;
-}
+    if (data) {
+        buffer_update(buffer, 0, len, data);
+    }
+};
 
 void framebuffer_create(uint32_t color_attachment_count,
                         image_vk* color_attachments,
@@ -652,18 +773,14 @@ void framebuffer_create(uint32_t color_attachment_count,
     framebuffer->color_attachment_count = color_attachment_count;
     for (uint32_t i = 0; i < color_attachment_count; i++) {
         framebuffer->color_attachments[i] = &color_attachments[i];
-        image_create_view(framebuffer->color_attachments[i],
-                          VK_IMAGE_VIEW_TYPE_2D,
-                          VK_IMAGE_ASPECT_COLOR_BIT,
-                          &framebuffer->color_attachment_views[i]);
+        framebuffer->color_attachment_views[i] = image_view_acquire(
+            framebuffer->color_attachments[i], VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
     }
 
     if (depth_attachment) {
         framebuffer->depth_attachment = depth_attachment;
-        image_create_view(framebuffer->depth_attachment,
-                          VK_IMAGE_VIEW_TYPE_2D,
-                          VK_IMAGE_ASPECT_DEPTH_BIT,
-                          &framebuffer->depth_attachment_view);
+        framebuffer->depth_attachment_view = image_view_acquire(
+            framebuffer->depth_attachment, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_DEPTH_BIT);
     }
 }
 
@@ -671,12 +788,12 @@ void framebuffer_destroy(framebuffer_vk* fb) {
     // TODO: Should be api agonstic level
     for (uint32_t i = 0; i < fb->color_attachment_count; i++) {
         fb->color_attachments[i] = NULL;
-        vkDestroyImageView(s_device, fb->color_attachment_views[i], NULL);
+        image_view_release(fb->color_attachment_views[i]);
     }
 
     if (fb->depth_attachment) {
         fb->depth_attachment = NULL;
-        vkDestroyImageView(s_device, fb->depth_attachment_view, NULL);
+        image_view_release(fb->depth_attachment_view);
     }
 }
 
@@ -717,7 +834,8 @@ void shader_create(size_t length, const char* code, shader_vk* shader) {
             }
             shader->vertex_attribute_count = sorted_iv_count;
 
-            uint32_t input_offset = 0;
+            // Inputs prefixed with `i_` are per instance and read from the instance binding.
+            uint32_t binding_strides[MGFX_SHADER_INSTANCE_BINDING + 1] = {0};
             for (uint32_t i = 0; i < MGFX_SHADER_MAX_VERTEX_ATTRIBUTES; i++) {
                 const SpvReflectInterfaceVariable* input_variable = sorted_iv[i];
 
@@ -725,14 +843,19 @@ void shader_create(size_t length, const char* code, shader_vk* shader) {
                     continue;
                 }
 
+                const uint32_t binding =
+                    input_variable->name && strncmp(input_variable->name, "i_", 2) == 0
+                        ? MGFX_SHADER_INSTANCE_BINDING
+                        : 0;
+
                 shader->vertex_attributes[i] = (VkVertexInputAttributeDescription){
                     .location = input_variable->location,
-                    .binding = 0,
+                    .binding = binding,
                     .format = (VkFormat)input_variable->format,
-                    .offset = input_offset,
+                    .offset = binding_strides[binding],
                 };
 
-                input_offset += vk_format_size((VkFormat)input_variable->format);
+                binding_strides[binding] += vk_format_size((VkFormat)input_variable->format);
 
                 MX_LOG_TRACE("input variable: %s", input_variable->name);
                 MX_LOG_TRACE("\tlocation: %u", input_variable->location);
@@ -747,19 +870,27 @@ void shader_create(size_t length, const char* code, shader_vk* shader) {
                 };
             }
 
-            if (shader->vertex_attribute_count > 0) {
-                shader->vertex_binding_count = 1;
-                shader->vertex_bindings[0] = (VkVertexInputBindingDescription){
-                    .binding = 0,
-                    .stride = input_offset,
-                    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-                };
+            shader->vertex_binding_count = 0;
+            for (uint32_t binding = 0; binding <= MGFX_SHADER_INSTANCE_BINDING; binding++) {
+                if (binding_strides[binding] == 0) {
+                    continue;
+                }
+
+                shader->vertex_bindings[shader->vertex_binding_count++] =
+                    (VkVertexInputBindingDescription){
+                        .binding = binding,
+                        .stride = binding_strides[binding],
+                        .inputRate = binding == MGFX_SHADER_INSTANCE_BINDING
+                                         ? VK_VERTEX_INPUT_RATE_INSTANCE
+                                         : VK_VERTEX_INPUT_RATE_VERTEX,
+                    };
             }
         }
     }
 
     uint32_t binding_count = 0;
-    shader->ds_count = module.descriptor_set_count;
+    // Sets are indexed by number, unused lower sets still take a slot.
+    shader->ds_count = 0;
     result = spvReflectEnumerateDescriptorBindings(&module, &binding_count, NULL);
     if (binding_count > 0) {
         MX_ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
@@ -768,11 +899,42 @@ void shader_create(size_t length, const char* code, shader_vk* shader) {
         spvReflectEnumerateDescriptorBindings(&module, &binding_count, bindings);
 
         for (uint32_t i = 0; i < binding_count; i++) {
+            MX_ASSERT(bindings[i]->set < MGFX_SHADER_MAX_DESCRIPTOR_SET);
             descriptor_set_info_vk* ds = &shader->ds_infos[bindings[i]->set];
 
+            if ((int)bindings[i]->set >= shader->ds_count) {
+                shader->ds_count = (int)bindings[i]->set + 1;
+            }
+
+            // Uniform blocks prefixed with `t_` read transient uniforms at a dynamic offset.
+            VkDescriptorType descriptor_type = (VkDescriptorType)bindings[i]->descriptor_type;
+            if (descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && bindings[i]->name &&
+                strncmp(bindings[i]->name, "t_", 2) == 0) {
+                descriptor_type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            }
+
+            // The view set is owned by mgfx and only holds the built in `mgfx_view` block.
+            if (bindings[i]->set == MGFX_SHADER_VIEW_SET) {
+                const char* type_name = bindings[i]->type_description
+                                            ? bindings[i]->type_description->type_name
+                                            : NULL;
+                MX_ASSERT(bindings[i]->binding == 0 &&
+                              descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER &&
+                              type_name && strcmp(type_name, "mgfx_view") == 0 &&
+                              bindings[i]->block.size == sizeof(view_block_vk),
+                          "Set MGFX_SHADER_VIEW_SET is reserved for the mgfx_view block!");
+            }
+
+            // Bindings prefixed with `b_` read the global bindless arrays.
+            if (bindings[i]->name && strncmp(bindings[i]->name, "b_", 2) == 0) {
+                MX_ASSERT(bindings[i]->set == MGFX_SHADER_BINDLESS_SET,
+                          "Bindless arrays must be declared at MGFX_SHADER_BINDLESS_SET!");
+                ds->bindless = MX_TRUE;
+            }
+
             ds->bindings[bindings[i]->binding] = (VkDescriptorSetLayoutBinding){
                 .binding = bindings[i]->binding,
-                .descriptorType = (VkDescriptorType)bindings[i]->descriptor_type,
+                .descriptorType = descriptor_type,
                 .descriptorCount = 1,
                 .stageFlags = module.shader_stage,
                 .pImmutableSamplers = NULL,
@@ -981,12 +1143,15 @@ void pipeline_create_graphics(const shader_vk* vs,
     for (uint32_t color_attachment_idx = 0; color_attachment_idx < fb->color_attachment_count;
          color_attachment_idx++) {
         color_blend_attachments[color_attachment_idx] = (VkPipelineColorBlendAttachmentState){
-            .blendEnable = VK_FALSE,
-            .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
-            .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO,
+            .blendEnable = program->blend ? VK_TRUE : VK_FALSE,
+            .srcColorBlendFactor =
+                program->blend ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE,
+            .dstColorBlendFactor =
+                program->blend ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO,
             .colorBlendOp = VK_BLEND_OP_ADD,
             .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+            .dstAlphaBlendFactor =
+                program->blend ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO,
             .alphaBlendOp = VK_BLEND_OP_ADD,
             .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
                               VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
@@ -1082,6 +1247,20 @@ void pipeline_create_graphics(const shader_vk* vs,
     }
 
     for (int ds_idx = 0; ds_idx < ds_count; ds_idx++) {
+        // The view block layout is shared by every program and owned by mgfx.
+        if (ds_idx == MGFX_SHADER_VIEW_SET &&
+            flat_bindings[ds_idx * MGFX_SHADER_MAX_DESCRIPTOR_BINDING].stageFlags != 0) {
+            ds_layouts[ds_idx] = s_view_dsl;
+            program->view_block = MX_TRUE;
+            continue;
+        }
+
+        // So are the bindless arrays.
+        if (ds_idx == MGFX_SHADER_BINDLESS_SET && program->bindless) {
+            ds_layouts[ds_idx] = s_bindless_dsl;
+            continue;
+        }
+
         VkDescriptorSetLayoutCreateInfo dsl_info = {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
             .pNext = NULL,
@@ -1095,6 +1274,21 @@ void pipeline_create_graphics(const shader_vk* vs,
         ds_layouts[ds_idx] = (VkDescriptorSetLayout)program->dsls[ds_idx];
     }
 
+    // Bindless indices follow the model matrix and are read by both stages.
+    if (program->bindless) {
+        flat_pc_ranges[0] = (VkPushConstantRange){
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .offset = 0,
+            .size = sizeof(float) * 16,
+        };
+        flat_pc_ranges[1] = (VkPushConstantRange){
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            .offset = sizeof(float) * 16,
+            .size = sizeof(uint32_t) * MGFX_BINDLESS_INDEX_COUNT,
+        };
+        flat_pc_range_count = 2;
+    }
+
     VkPipelineLayoutCreateInfo pipeline_layout_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pNext = NULL,
@@ -1133,6 +1327,69 @@ void pipeline_create_graphics(const shader_vk* vs,
         vkCreateGraphicsPipelines(s_device, NULL, 1, &info, NULL, (VkPipeline*)&program->pipeline));
 }
 
+void pipeline_create_compute(const shader_vk* cs, mgfx_program* program) {
+    MX_ASSERT(cs != NULL, "Compute program requires a valid compute shader!");
+    MX_ASSERT(!cs->ds_infos[MGFX_SHADER_BINDLESS_SET].bindless,
+              "Bindless arrays are only bound for graphics programs!");
+
+    VkDescriptorSetLayout ds_layouts[MGFX_SHADER_MAX_DESCRIPTOR_SET] = {0};
+    for (int ds_idx = 0; ds_idx < cs->ds_count; ds_idx++) {
+        const descriptor_set_info_vk* ds = &cs->ds_infos[ds_idx];
+
+        uint32_t binding_count = 0;
+        for (uint32_t binding = 0; binding < MGFX_SHADER_MAX_DESCRIPTOR_BINDING; binding++) {
+            if (ds->bindings[binding].stageFlags != 0) {
+                binding_count = binding + 1;
+            }
+        }
+
+        VkDescriptorSetLayoutCreateInfo dsl_info = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .bindingCount = binding_count,
+            .pBindings = ds->bindings,
+        };
+
+        VK_CHECK(vkCreateDescriptorSetLayout(
+            s_device, &dsl_info, NULL, (VkDescriptorSetLayout*)&program->dsls[ds_idx]));
+        ds_layouts[ds_idx] = (VkDescriptorSetLayout)program->dsls[ds_idx];
+    }
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .setLayoutCount = cs->ds_count,
+        .pSetLayouts = ds_layouts,
+        .pushConstantRangeCount = cs->pc_count,
+        .pPushConstantRanges = cs->pc_ranges,
+    };
+
+    VK_CHECK(vkCreatePipelineLayout(
+        s_device, &pipeline_layout_info, NULL, (VkPipelineLayout*)&program->pipeline_layout));
+
+    VkComputePipelineCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .stage =
+            {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext = NULL,
+                .flags = 0,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = cs->module,
+                .pName = "main",
+                .pSpecializationInfo = NULL,
+            },
+        .layout = (VkPipelineLayout)program->pipeline_layout,
+    };
+
+    VK_CHECK(
+        vkCreateComputePipelines(s_device, NULL, 1, &info, NULL, (VkPipeline*)&program->pipeline));
+}
+
 void pipeline_destroy(mgfx_program* program) {
     for (uint32_t descriptor_idx = 0; descriptor_idx < MGFX_SHADER_MAX_DESCRIPTOR_SET;
          descriptor_idx++) {
@@ -1140,19 +1397,25 @@ void pipeline_destroy(mgfx_program* program) {
             continue;
         }
 
-        vkDestroyDescriptorSetLayout(
-            s_device, (VkDescriptorSetLayout)program->dsls[descriptor_idx], NULL);
+        // The layout handle can be reused, sets cached against it must go with it.
+        descriptor_sets_evict_layout((VkDescriptorSetLayout)program->dsls[descriptor_idx]);
+        deletion_queue_push(
+            DELETION_TYPE_DESCRIPTOR_SET_LAYOUT, program->dsls[descriptor_idx], VK_NULL_HANDLE);
     }
 
-    vkDestroyPipelineLayout(s_device, (VkPipelineLayout)program->pipeline_layout, NULL);
-    vkDestroyPipeline(s_device, (VkPipeline)program->pipeline, NULL);
+    deletion_queue_push(
+        DELETION_TYPE_PIPELINE_LAYOUT, (uint64_t)program->pipeline_layout, VK_NULL_HANDLE);
+    deletion_queue_push(DELETION_TYPE_PIPELINE, (uint64_t)program->pipeline, VK_NULL_HANDLE);
 }
 
 mx_bool swapchain_update(const frame_vk* frame, int width, int height, swapchain_vk* sc) {
     if (sc->resize == MX_TRUE) {
-        vkDeviceWaitIdle(s_device);
-
-        swapchain_destroy(&s_swapchain);
+        // The old swapchain is retired by the new one and released with the frames using it.
+        for (uint32_t i = 0; i < sc->image_count; i++) {
+            deletion_queue_push(
+                DELETION_TYPE_IMAGE_VIEW, (uint64_t)sc->image_views[i], VK_NULL_HANDLE);
+        }
+        deletion_queue_push(DELETION_TYPE_SWAPCHAIN, (uint64_t)sc->handle, VK_NULL_HANDLE);
 
         if (s_surface_caps.currentExtent.width == UINT32_MAX) {
             width = (int)mx_clamp((float)width,
@@ -1229,1027 +1492,4615 @@ const mgfx_built_in_vertex MGFX_FS_QUAD_VERTICES[4] = {
 
 const uint32_t MGFX_FS_QUAD_INDICES[6] = {0, 1, 2, 2, 3, 0};
 
-typedef struct mgfx_draw {
-    struct descriptor_sets {
-        mgfx_dh dhs[MGFX_SHADER_MAX_DESCRIPTOR_BINDING];
-        uint32_t dh_count;
-    } desc_sets[MGFX_SHADER_MAX_DESCRIPTOR_SET];
+// Draws are recorded into a per-frame linear arena. Sort keys (hot) are kept apart from the
+// compact draw records (cold) so ordering never touches bind data. Variable sized bind data is
+// appended to side streams and referenced by offset. Streams grow by doubling, are never shrunk
+// and are rewound in O(1) at the end of the frame.
+typedef struct draw_stream {
+    uint8_t* data;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t stride;
+} draw_stream;
+
+static void draw_stream_reserve(draw_stream* stream, uint32_t count) {
+    if (stream->count + count <= stream->capacity) {
+        return;
+    }
 
-    struct {
-        float model[16];
-        float view[16];
-        float proj[16];
-        float view_inv[16];
-    } draw_pc;
+    uint32_t capacity = stream->capacity > 0 ? stream->capacity : 256;
+    while (capacity < stream->count + count) {
+        capacity *= 2;
+    }
 
-    mgfx_vbh vbhs[4];
-    uint32_t vbh_count;
+    uint8_t* data = mx_alloc(mx_default_allocator(), (size_t)capacity * stream->stride);
+    MX_ASSERT(data != NULL, "[DrawArena] Failed to grow draw stream!");
 
-    mgfx_ibh ibh;
+    if (stream->data) {
+        memcpy(data, stream->data, (size_t)stream->count * stream->stride);
+        mx_free(mx_default_allocator(), stream->data);
+    }
 
-    // Transient draw
-    mgfx_transient_buffer tvbs[4];
-    uint32_t tvbh_count;
+    stream->data = data;
+    stream->capacity = capacity;
+}
 
-    mgfx_transient_buffer tib;
+static uint32_t draw_stream_push(draw_stream* stream, const void* src, uint32_t count) {
+    draw_stream_reserve(stream, count);
 
-    mgfx_ph ph;
-    uint8_t view_target;
+    uint32_t offset = stream->count;
+    memcpy(stream->data + (size_t)offset * stream->stride, src, (size_t)count * stream->stride);
+    stream->count += count;
 
-    uint64_t sort_key;
-} mgfx_draw;
+    return offset;
+}
 
-static int draw_compare_fn(const void* a, const void* b) {
-    const mgfx_draw* draw_a = (mgfx_draw*)a;
-    const mgfx_draw* draw_b = (mgfx_draw*)b;
+static void draw_stream_destroy(draw_stream* stream) {
+    if (stream->data) {
+        mx_free(mx_default_allocator(), stream->data);
+    }
 
-    return draw_a->sort_key > draw_b->sort_key ? 1 : -1;
+    stream->data = NULL;
+    stream->count = 0;
+    stream->capacity = 0;
 }
 
-typedef struct buffer_entry {
-    VkBuffer key;
-    buffer_vk value;
-    UT_hash_handle hh;
-} buffer_entry;
-static buffer_entry* s_buffer_table;
+typedef struct deletion_vk {
+    uint32_t type; // deletion_type_vk
+    uint64_t handle;
 
-typedef struct image_entry {
-    VkImage key;
-    image_vk value;
-    UT_hash_handle hh;
-} image_entry;
-static image_entry* s_image_table;
+    union {
+        VmaAllocation allocation;
+        VkDescriptorPool pool; // Descriptor sets are freed to the pool they came from.
+    };
+} deletion_vk;
 
-typedef struct shader_entry {
-    VkShaderModule key;
-    shader_vk value;
-    UT_hash_handle hh;
-} shader_entry;
-static shader_entry* s_shader_table;
+// Deletions are collected until the next submit, which is the last frame that can reference them,
+// and handed to that frame's queue. A frame's queue is flushed once its render fence signals.
+static draw_stream s_deletions_pending = {.stride = sizeof(deletion_vk)};
+static draw_stream s_deletions[MGFX_FRAME_COUNT];
 
-typedef struct texture_entry {
-    mgfx_th key;
-    mgfx_texture value;
-    UT_hash_handle hh;
-} texture_entry;
-static texture_entry* s_texture_table;
+static void deletion_queue_push(deletion_type_vk type, uint64_t handle, VmaAllocation allocation) {
+    if (handle == 0) {
+        return;
+    }
 
-typedef struct program_entry {
-    mgfx_ph key;
-    mgfx_program value;
-    UT_hash_handle hh;
-} program_entry;
-static program_entry* s_program_table;
+    const deletion_vk deletion = {.type = type, .handle = handle, .allocation = allocation};
+    draw_stream_push(&s_deletions_pending, &deletion, 1);
+}
 
-typedef struct descriptor_entry {
-    mgfx_dh key;
-    descriptor_info_vk value;
-    UT_hash_handle hh;
-} descriptor_entry;
-static descriptor_entry* s_descriptor_table;
+static void deletion_queue_push_descriptor_set(VkDescriptorPool pool, VkDescriptorSet set) {
+    const deletion_vk deletion = {
+        .type = DELETION_TYPE_DESCRIPTOR_SET,
+        .handle = (uint64_t)set,
+        .pool = pool,
+    };
+    draw_stream_push(&s_deletions_pending, &deletion, 1);
+}
 
-typedef struct descriptor_set_entry {
-    uint32_t key;
-    VkDescriptorSet value;
-    UT_hash_handle hh;
-} descriptor_set_entry;
-static descriptor_set_entry* s_descriptor_set_table;
+static void deletion_queue_flush(draw_stream* queue) {
+    const deletion_vk* deletions = (const deletion_vk*)queue->data;
 
-typedef struct framebuffer_entry {
-    mgfx_fbh key;
-    framebuffer_vk value;
-    UT_hash_handle hh;
-} framebuffer_entry;
-static framebuffer_entry* s_framebuffer_table;
+    for (uint32_t i = 0; i < queue->count; i++) {
+        const deletion_vk* deletion = &deletions[i];
 
-mgfx_fbh s_view_targets[0xFF];
-VkClearColorValue s_view_clears[0XFF] = {0};
+        switch (deletion->type) {
+        case DELETION_TYPE_BUFFER:
+            vmaDestroyBuffer(s_allocator, (VkBuffer)deletion->handle, deletion->allocation);
+            break;
+        case DELETION_TYPE_IMAGE:
+            vmaDestroyImage(s_allocator, (VkImage)deletion->handle, deletion->allocation);
+            break;
+        case DELETION_TYPE_IMAGE_VIEW:
+            vkDestroyImageView(s_device, (VkImageView)deletion->handle, NULL);
+            break;
+        case DELETION_TYPE_SAMPLER:
+            vkDestroySampler(s_device, (VkSampler)deletion->handle, NULL);
+            break;
+        case DELETION_TYPE_PIPELINE:
+            vkDestroyPipeline(s_device, (VkPipeline)deletion->handle, NULL);
+            break;
+        case DELETION_TYPE_PIPELINE_LAYOUT:
+            vkDestroyPipelineLayout(s_device, (VkPipelineLayout)deletion->handle, NULL);
+            break;
+        case DELETION_TYPE_DESCRIPTOR_SET_LAYOUT:
+            vkDestroyDescriptorSetLayout(s_device, (VkDescriptorSetLayout)deletion->handle, NULL);
+            break;
+        case DELETION_TYPE_DESCRIPTOR_SET: {
+            const VkDescriptorSet ds = (VkDescriptorSet)deletion->handle;
+            VK_CHECK(vkFreeDescriptorSets(s_device, deletion->pool, 1, &ds));
+        } break;
+        case DELETION_TYPE_SWAPCHAIN:
+            vkDestroySwapchainKHR(s_device, (VkSwapchainKHR)deletion->handle, NULL);
+            break;
+        default:
+            MX_LOG_ERROR("[Deletion] Unknown deletion type %u!", deletion->type);
+            break;
+        }
+    }
 
-uint32_t s_width;
-uint32_t s_height;
+    queue->count = 0;
+}
 
-static float s_current_transform[16];
-static float s_current_view[16];
-static float s_current_proj[16];
+// The frame's queue was flushed when its fence was waited on, so it is empty and takes over the
+// pending deletions in O(1).
+static void deletion_queue_submit(uint32_t frame_idx) {
+    draw_stream* queue = &s_deletions[frame_idx];
+    MX_ASSERT(queue->count == 0, "[Deletion] Frame queue submitted before it was flushed!");
 
-enum { MGFX_MAX_DRAW_COUNT = 256 };
-static mgfx_draw s_draws[MGFX_MAX_DRAW_COUNT];
-static uint32_t s_draw_count = 0;
+    const draw_stream retired = *queue;
+    *queue = s_deletions_pending;
+    s_deletions_pending = retired;
+}
 
-// Built in assets
-mgfx_th MGFX_WHITE_TEXTURE;
-mgfx_th MGFX_BLACK_TEXTURE;
-mgfx_th MGFX_LOCAL_NORMAL_TEXTURE;
+// Transient geometry is written straight into persistently mapped blocks. Blocks written since
+// the last submit are handed to the submitted frame and return to the free list once its fence
+// signals, the same way deletions are. A full block chains another one instead of failing and
+// allocations larger than a block get a block of their own.
+typedef struct transient_block_vk {
+    buffer_vk buffer;
+    uint8_t* data;
+    uint32_t size;
+    uint32_t head;
+} transient_block_vk;
+
+typedef struct transient_ring_vk {
+    VkBufferUsageFlags usage;
+    uint32_t block_size;
+    size_t budget;   // Bytes all blocks may hold, 0 is unbounded.
+    size_t capacity; // Bytes held by all blocks.
+
+    draw_stream free;                        // transient_block_vk
+    draw_stream pending;                     // transient_block_vk, the last one is written.
+    draw_stream in_flight[MGFX_FRAME_COUNT]; // transient_block_vk
+} transient_ring_vk;
+
+static transient_ring_vk s_tvb_pool; // Transient vertex buffer pool
+static transient_ring_vk s_tib_pool; // Transient index buffer pool
+
+enum { MGFX_TRANSIENT_VERTEX_BLOCK_SIZE = MX_MB * 4 };
+enum { MGFX_TRANSIENT_INDEX_BLOCK_SIZE = MX_MB };
+enum { MGFX_TRANSIENT_ALIGNMENT = 16 };
+
+static void transient_ring_init(transient_ring_vk* ring,
+                                VkBufferUsageFlags usage,
+                                uint32_t block_size,
+                                size_t budget) {
+    *ring = (transient_ring_vk){
+        .usage = usage,
+        .block_size = block_size,
+        .budget = budget,
+        .free = {.stride = sizeof(transient_block_vk)},
+        .pending = {.stride = sizeof(transient_block_vk)},
+    };
 
-// Debug Text
-enum { MGFX_DEBUG_MAX_TEXT = 64 };
-static const uint32_t atlas_w = 512;
-static const uint32_t atlas_h = 512;
+    for (uint32_t i = 0; i < MGFX_FRAME_COUNT; i++) {
+        ring->in_flight[i] = (draw_stream){.stride = sizeof(transient_block_vk)};
+    }
+}
 
-static const char* font_path = MGFX_ASSET_PATH "fonts/Roboto-Regular.ttf";
-stbtt_packedchar chars[96]; // For ASCII 32..127
+// Returns NULL when a new block would exceed the ring's budget.
+static transient_block_vk* transient_ring_block(transient_ring_vk* ring, uint32_t size) {
+    if (ring->pending.count > 0) {
+        transient_block_vk* current =
+            &((transient_block_vk*)ring->pending.data)[ring->pending.count - 1];
 
-mgfx_sh dbg_ui_vsh;
-mgfx_sh dbg_ui_fsh;
-mgfx_ph dbg_ui_ph;
+        if (current->head + size <= current->size) {
+            return current;
+        }
+    }
 
-mgfx_th dbg_ui_font_atlas_th;
-mgfx_dh dbg_ui_font_atlas_dh;
+    transient_block_vk block = {0};
 
-// Debug Gizmos
-mgfx_vbh dbg_quad_vbh;
-mgfx_ibh dbg_quad_ibh;
+    transient_block_vk* free_blocks = (transient_block_vk*)ring->free.data;
+    for (uint32_t i = 0; i < ring->free.count; i++) {
+        if (free_blocks[i].size >= size) {
+            block = free_blocks[i];
+            free_blocks[i] = free_blocks[--ring->free.count];
+            break;
+        }
+    }
 
-static mx_allocator_t mgfx_allocator;
+    if (block.data == NULL) {
+        block.size = size > ring->block_size ? size : ring->block_size;
 
-int mgfx_init(const mgfx_init_info* info) {
-    mx_scoped_allocator(MX_MB) tmp = mx_scoped_allocator_create();
+        if (ring->budget > 0) {
+            // Free blocks too small for this allocation make room for one that fits.
+            while (ring->capacity + block.size > ring->budget && ring->free.count > 0) {
+                transient_block_vk* released = &free_blocks[--ring->free.count];
+                ring->capacity -= released->size;
+                buffer_destroy(&released->buffer);
+            }
 
-    VkApplicationInfo app_info = {0};
-    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-    app_info.pNext = NULL;
-    app_info.pApplicationName = info->name;
-    app_info.applicationVersion = VK_MAKE_VERSION(0, 0, 1);
-    app_info.pEngineName = "MGFX";
-    app_info.engineVersion = VK_MAKE_VERSION(0, 0, 1);
+            // An empty ring may exceed its budget so a block larger than the budget still fits.
+            if (ring->capacity + block.size > ring->budget && ring->capacity > 0) {
+                return NULL;
+            }
+        }
 
-    uint32_t api_version;
-    vkEnumerateInstanceVersion(&api_version);
-    app_info.apiVersion = VK_API_VERSION_1_2;
+        ring->capacity += block.size;
+        buffer_create(block.size,
+                      ring->usage,
+                      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                      &block.buffer);
 
-    VkInstanceCreateInfo instance_info = {0};
-    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-    instance_info.pNext = NULL;
-    instance_info.pApplicationInfo = &app_info;
-#ifdef MX_MACOS
-    instance_info.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
-#endif
+        VmaAllocationInfo alloc_info;
+        vmaGetAllocationInfo(s_allocator, block.buffer.allocation, &alloc_info);
+        block.data = (uint8_t*)alloc_info.pMappedData;
+        MX_ASSERT(block.data != NULL, "[TransientBuffer] Block is not host visible!");
 
-    // Check if required extensions are available.
-    uint32_t avail_prop_count = 0;
-    VK_CHECK(vkEnumerateInstanceExtensionProperties(NULL, &avail_prop_count, NULL));
-    VkExtensionProperties* avail_props =
-        mx_alloc(tmp, avail_prop_count * sizeof(VkExtensionProperties));
-    VK_CHECK(vkEnumerateInstanceExtensionProperties(NULL, &avail_prop_count, avail_props));
+        MX_LOG_TRACE("[TransientBuffer] Chained a %u byte block.", block.size);
+    }
 
-    for (int req_index = 0; req_index < k_req_ext_count; req_index++) {
-        int validated = -1;
-        for (uint32_t avail_index = 0; avail_index < avail_prop_count; avail_index++) {
-            if (strcmp(k_req_exts[req_index], avail_props[avail_index].extensionName) == 0) {
-                validated = MX_SUCCESS;
+    block.head = 0;
+    const uint32_t block_idx = draw_stream_push(&ring->pending, &block, 1);
+    return &((transient_block_vk*)ring->pending.data)[block_idx];
+}
+
+static void transient_ring_allocate(transient_ring_vk* ring,
+                                    const void* data,
+                                    size_t len,
+                                    mgfx_transient_buffer* out) {
+    const uint32_t size =
+        ((uint32_t)len + MGFX_TRANSIENT_ALIGNMENT - 1) & ~(uint32_t)(MGFX_TRANSIENT_ALIGNMENT - 1);
+
+    transient_block_vk* block = transient_ring_block(ring, size);
+    MX_ASSERT(block != NULL, "[TransientBuffer] Ring budget exceeded!");
+
+    if (data) {
+        memcpy(block->data + block->head, data, len);
+    }
+
+    *out = (mgfx_transient_buffer){
+        .size = (uint32_t)len,
+        .offset = block->head,
+        .buffer_handle = (mx_ptr_t)block->buffer.handle,
+    };
+
+    block->head += size;
+}
+
+// The frame's fence has signalled, its blocks can be written again.
+static void transient_ring_reclaim(transient_ring_vk* ring, uint32_t frame_idx) {
+    draw_stream* in_flight = &ring->in_flight[frame_idx];
+
+    if (in_flight->count > 0) {
+        draw_stream_push(&ring->free, in_flight->data, in_flight->count);
+        in_flight->count = 0;
+    }
+}
+
+static void transient_ring_submit(transient_ring_vk* ring, uint32_t frame_idx) {
+    draw_stream* in_flight = &ring->in_flight[frame_idx];
+    MX_ASSERT(in_flight->count == 0, "[TransientBuffer] Frame blocks submitted before reclaim!");
+
+    const draw_stream retired = *in_flight;
+    *in_flight = ring->pending;
+    ring->pending = retired;
+}
+
+// Nothing was submitted since the last submit, blocks written since then were never read.
+static void transient_ring_discard(transient_ring_vk* ring) {
+    if (ring->pending.count > 0) {
+        draw_stream_push(&ring->free, ring->pending.data, ring->pending.count);
+        ring->pending.count = 0;
+    }
+}
+
+static void transient_ring_destroy(transient_ring_vk* ring) {
+    draw_stream* streams[MGFX_FRAME_COUNT + 2] = {&ring->free, &ring->pending};
+    for (uint32_t i = 0; i < MGFX_FRAME_COUNT; i++) {
+        streams[i + 2] = &ring->in_flight[i];
+    }
+
+    for (uint32_t stream_idx = 0; stream_idx < MGFX_FRAME_COUNT + 2; stream_idx++) {
+        transient_block_vk* blocks = (transient_block_vk*)streams[stream_idx]->data;
+        for (uint32_t i = 0; i < streams[stream_idx]->count; i++) {
+            buffer_destroy(&blocks[i].buffer);
+        }
+
+        draw_stream_destroy(streams[stream_idx]);
+    }
+
+    ring->capacity = 0;
+}
+
+// Staging memory is a transient ring of copy sources that grows a block at a time up to its
+// budget. Uploads are split into pieces of at most a block, pieces that find no room once the
+// budget is reached are deferred with a copy of their data and staged by the following frames as
+// their blocks retire. Streaming uploads are additionally limited to the per frame upload budget
+// and only staged after immediate ones.
+enum { MGFX_STAGING_BLOCK_SIZE = MX_MB * 4 };
+enum { MGFX_STAGING_BUDGET = MX_MB * 64 };
+enum { MGFX_UPLOAD_BUDGET = MX_MB * 8 };
+enum { MGFX_MAX_UPLOADS = 1 << 14 };
+
+typedef struct staging_upload_vk {
+    buffer_vk* buffer;  // Destination buffer, or
+    image_vk* image;    // destination image.
+    size_t offset;      // Destination offset of buffer uploads.
+    uint32_t mip_level; // Destination level of image uploads.
+    size_t size;
+    size_t staged; // Bytes already written to staging blocks.
+
+    uint32_t priority; // mgfx_upload_priority
+    uint64_t handle;   // s_uploads
+
+    uint8_t* data;      // Owned copy of a deferred upload,
+    size_t data_offset; // starting at this byte of the upload.
+} staging_upload_vk;
+
+static transient_ring_vk s_tsb_pool; // Transient staging buffer pool
+
+static draw_stream s_staging_deferred[MGFX_UPLOAD_PRIORITY_COUNT] = {
+    {.stride = sizeof(staging_upload_vk)},
+    {.stride = sizeof(staging_upload_vk)},
+};
+
+static size_t s_staging_frame_bytes = 0; // Staged since the last submit.
+static size_t s_staging_peak_bytes = 0;
+static uint64_t s_staging_total_bytes = 0;
+
+static size_t s_upload_budget = MGFX_UPLOAD_BUDGET;
+static size_t s_upload_streamed_bytes = 0; // Streaming bytes staged since the last submit.
+
+// Upload handles stay valid until the frame that copies the last piece retires. Fully staged
+// uploads are handed to the next submit the same way deletions are.
+typedef struct upload_vk {
+    uint32_t priority;
+} upload_vk;
+
+static handle_pool s_uploads; // upload_vk
+static draw_stream s_uploads_staged = {.stride = sizeof(uint64_t)};
+static draw_stream s_uploads_in_flight[MGFX_FRAME_COUNT];
+
+// Copies staged this frame, recorded at submit.
+static draw_stream s_buffer_copies = {.stride = sizeof(buffer_to_buffer_copy_vk)};
+static draw_stream s_image_copies = {.stride = sizeof(buffer_to_image_copy_vk)};
+
+static VkExtent3D image_level_extent(const image_vk* image, uint32_t level) {
+    const uint32_t width = image->extent.width >> level;
+    const uint32_t height = image->extent.height >> level;
+    const uint32_t depth = image->extent.depth >> level;
+
+    return (VkExtent3D){width > 0 ? width : 1, height > 0 ? height : 1, depth > 0 ? depth : 1};
+}
+
+// Images are split along whole rows of texels or blocks, or whole slices of 3d images.
+static uint32_t staging_image_units(const image_vk* image, uint32_t level) {
+    const VkExtent3D extent = image_level_extent(image, level);
+    const uint32_t block = vk_format_block_extent(image->format);
+
+    return extent.depth > 1 ? extent.depth : (extent.height + block - 1) / block;
+}
+
+// Stages as much of the upload as the budgets and staging ring allow, src points at its first
+// unstaged byte. Returns MX_TRUE once the whole upload is staged.
+static mx_bool staging_upload_process(staging_upload_vk* upload, const uint8_t* src) {
+    const size_t unit_size =
+        upload->image ? upload->size / staging_image_units(upload->image, upload->mip_level) : 1;
+
+    size_t piece_max = s_tsb_pool.block_size - s_tsb_pool.block_size % unit_size;
+    if (piece_max < unit_size) {
+        piece_max = unit_size;
+    }
+
+    while (upload->staged < upload->size) {
+        size_t piece = upload->size - upload->staged;
+        if (piece > piece_max) {
+            piece = piece_max;
+        }
+
+        if (upload->priority == MGFX_UPLOAD_PRIORITY_STREAMING) {
+            const size_t budget = s_upload_budget > s_upload_streamed_bytes
+                                      ? s_upload_budget - s_upload_streamed_bytes
+                                      : 0;
+
+            // A frame streams at least one unit so units larger than the budget still progress.
+            size_t piece_budget = budget - budget % unit_size;
+            if (piece_budget == 0 && s_upload_streamed_bytes == 0) {
+                piece_budget = unit_size;
+            }
+
+            if (piece_budget == 0) {
+                return MX_FALSE;
+            }
+
+            if (piece > piece_budget) {
+                piece = piece_budget;
+            }
+        }
+
+        const uint32_t size = ((uint32_t)piece + MGFX_TRANSIENT_ALIGNMENT - 1) &
+                              ~(uint32_t)(MGFX_TRANSIENT_ALIGNMENT - 1);
+
+        transient_block_vk* block = transient_ring_block(&s_tsb_pool, size);
+        if (block == NULL) {
+            return MX_FALSE;
+        }
+
+        memcpy(block->data + block->head, src, piece);
+
+        if (upload->image) {
+            const image_vk* image = upload->image;
+            const VkExtent3D extent = image_level_extent(image, upload->mip_level);
+            const uint32_t block_extent = vk_format_block_extent(image->format);
+            const uint32_t first = (uint32_t)(upload->staged / unit_size);
+            const uint32_t count = (uint32_t)(piece / unit_size);
+
+            // The last row of blocks may overhang the level, its copy ends at the level's edge.
+            const uint32_t row = first * block_extent;
+            const uint32_t rows = count * block_extent < extent.height - row
+                                      ? count * block_extent
+                                      : extent.height - row;
+
+            VkOffset3D image_offset = {0, (int32_t)row, 0};
+            VkExtent3D image_extent = {extent.width, rows, 1};
+            if (extent.depth > 1) {
+                image_offset = (VkOffset3D){0, 0, (int32_t)first};
+                image_extent = (VkExtent3D){extent.width, extent.height, count};
+            }
+
+            const buffer_to_image_copy_vk copy = {
+                .copy =
+                    {
+                        .bufferOffset = block->head,
+                        .bufferRowLength = 0,
+                        .bufferImageHeight = 0,
+                        .imageSubresource =
+                            {
+                                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                .mipLevel = upload->mip_level,
+                                .baseArrayLayer = 0,
+                                .layerCount = 1,
+                            },
+                        .imageOffset = image_offset,
+                        .imageExtent = image_extent,
+                    },
+                .src = block->buffer.handle,
+                .dst = upload->image,
+            };
+            draw_stream_push(&s_image_copies, &copy, 1);
+        } else {
+            const buffer_to_buffer_copy_vk copy = {
+                .copy =
+                    {
+                        .srcOffset = block->head,
+                        .dstOffset = upload->offset + upload->staged,
+                        .size = piece,
+                    },
+                .src = block->buffer.handle,
+                .dst = upload->buffer,
+            };
+            draw_stream_push(&s_buffer_copies, &copy, 1);
+        }
+
+        block->head += size;
+        upload->staged += piece;
+        src += piece;
+
+        s_staging_frame_bytes += size;
+        if (upload->priority == MGFX_UPLOAD_PRIORITY_STREAMING) {
+            s_upload_streamed_bytes += piece;
+        }
+
+        // The chain is generated once, after the copy of the last piece of level 0.
+        if (upload->image && upload->image->generate_mips && upload->mip_level == 0 &&
+            upload->staged == upload->size) {
+            buffer_to_image_copy_vk* copies = (buffer_to_image_copy_vk*)s_image_copies.data;
+            copies[s_image_copies.count - 1].generate_mips = MX_TRUE;
+        }
+    }
+
+    if (upload->handle != 0) {
+        draw_stream_push(&s_uploads_staged, &upload->handle, 1);
+    }
+    return MX_TRUE;
+}
+
+// Destinations count their deferred uploads per queue, so ordering checks never scan the queues.
+static uint32_t* staging_deferred_counts(const staging_upload_vk* upload) {
+    return upload->buffer ? upload->buffer->deferred_uploads : upload->image->deferred_uploads;
+}
+
+// Returns the last of the queues before `priority_end` holding a deferred upload into the
+// destination of `upload`, or MGFX_UPLOAD_PRIORITY_COUNT if there is none.
+static uint32_t staging_deferred_queue(const staging_upload_vk* upload, uint32_t priority_end) {
+    const uint32_t* counts = staging_deferred_counts(upload);
+
+    for (uint32_t priority = priority_end; priority-- > 0;) {
+        if (counts[priority] > 0) {
+            return priority;
+        }
+    }
+
+    return MGFX_UPLOAD_PRIORITY_COUNT;
+}
+
+static uint64_t staging_upload_submit(staging_upload_vk* upload, const uint8_t* data) {
+    MX_ASSERT(upload->priority < MGFX_UPLOAD_PRIORITY_COUNT, "[Staging] Invalid upload priority!");
+
+    // Without a free handle the data is still uploaded, it just cannot be polled.
+    upload_vk* value;
+    upload->handle = handle_pool_alloc(&s_uploads, (void**)&value);
+    if (value) {
+        value->priority = upload->priority;
+    }
+
+    // Deferred uploads are staged first so a later write to the same range still lands last. An
+    // upload into a destination with a deferred upload of a lower priority queues behind it.
+    uint32_t queue = staging_deferred_queue(upload, MGFX_UPLOAD_PRIORITY_COUNT);
+    if (queue == MGFX_UPLOAD_PRIORITY_COUNT || queue < upload->priority) {
+        queue = upload->priority;
+    }
+
+    draw_stream* deferred = &s_staging_deferred[queue];
+    if (deferred->count == 0 && staging_upload_process(upload, data)) {
+        return upload->handle;
+    }
+
+    const size_t remaining = upload->size - upload->staged;
+    upload->data = mx_alloc(mx_default_allocator(), remaining);
+    MX_ASSERT(upload->data != NULL, "[Staging] Failed to defer upload!");
+
+    memcpy(upload->data, data + upload->staged, remaining);
+    upload->data_offset = upload->staged;
+
+    draw_stream_push(deferred, upload, 1);
+    staging_deferred_counts(upload)[queue]++;
+    return upload->handle;
+}
+
+static uint64_t staging_buffer_upload(
+    buffer_vk* buffer, size_t offset, size_t size, const void* data, uint32_t priority) {
+    staging_upload_vk upload = {
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+        .priority = priority,
+    };
+
+    return staging_upload_submit(&upload, data);
+}
+
+static uint64_t staging_image_upload(image_vk* image,
+                                     uint32_t level,
+                                     size_t size,
+                                     const void* data,
+                                     uint32_t priority) {
+    MX_ASSERT(level < image->mip_levels, "[Staging] Invalid mip level!");
+    MX_ASSERT(size % staging_image_units(image, level) == 0,
+              "[Staging] Image size is not whole rows!");
+
+    staging_upload_vk upload = {
+        .image = image, .mip_level = level, .size = size, .priority = priority};
+    return staging_upload_submit(&upload, data);
+}
+
+// Continues deferred uploads in order once the frame's blocks were reclaimed, immediate uploads
+// before streaming ones.
+static void staging_deferred_process() {
+    for (uint32_t priority = 0; priority < MGFX_UPLOAD_PRIORITY_COUNT; priority++) {
+        draw_stream* deferred = &s_staging_deferred[priority];
+        staging_upload_vk* uploads = (staging_upload_vk*)deferred->data;
+
+        uint32_t done = 0;
+        while (done < deferred->count) {
+            // Waits for older uploads into the same destination still deferred in earlier queues.
+            staging_upload_vk* upload = &uploads[done];
+            if (staging_deferred_queue(upload, priority) != MGFX_UPLOAD_PRIORITY_COUNT ||
+                !staging_upload_process(upload,
+                                        upload->data + (upload->staged - upload->data_offset))) {
+                break;
+            }
+
+            staging_deferred_counts(upload)[priority]--;
+            mx_free(mx_default_allocator(), upload->data);
+            done++;
+        }
+
+        if (done > 0) {
+            deferred->count -= done;
+            memmove(uploads, uploads + done, (size_t)deferred->count * sizeof(*uploads));
+        }
+    }
+}
+
+static size_t staging_deferred_size() {
+    size_t size = 0;
+
+    for (uint32_t priority = 0; priority < MGFX_UPLOAD_PRIORITY_COUNT; priority++) {
+        const staging_upload_vk* uploads =
+            (const staging_upload_vk*)s_staging_deferred[priority].data;
+
+        for (uint32_t i = 0; i < s_staging_deferred[priority].count; i++) {
+            size += uploads[i].size - uploads[i].staged;
+        }
+    }
+
+    return size;
+}
+
+// Drops queued copies and deferred uploads into a destination that is being destroyed, their
+// uploads complete immediately.
+static void staging_upload_cancel(const buffer_vk* buffer, const image_vk* image) {
+    buffer_to_buffer_copy_vk* buffer_copies = (buffer_to_buffer_copy_vk*)s_buffer_copies.data;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < s_buffer_copies.count; i++) {
+        if (buffer == NULL || buffer_copies[i].dst != buffer) {
+            buffer_copies[count++] = buffer_copies[i];
+        }
+    }
+    s_buffer_copies.count = count;
+
+    buffer_to_image_copy_vk* image_copies = (buffer_to_image_copy_vk*)s_image_copies.data;
+    count = 0;
+    for (uint32_t i = 0; i < s_image_copies.count; i++) {
+        if (image == NULL || image_copies[i].dst != image) {
+            image_copies[count++] = image_copies[i];
+        }
+    }
+    s_image_copies.count = count;
+
+    const uint32_t* deferred_counts = buffer ? buffer->deferred_uploads : image->deferred_uploads;
+
+    for (uint32_t priority = 0; priority < MGFX_UPLOAD_PRIORITY_COUNT; priority++) {
+        draw_stream* deferred = &s_staging_deferred[priority];
+        staging_upload_vk* uploads = (staging_upload_vk*)deferred->data;
+
+        if (deferred_counts[priority] == 0) {
+            continue;
+        }
+
+        count = 0;
+        for (uint32_t i = 0; i < deferred->count; i++) {
+            if ((buffer != NULL && uploads[i].buffer == buffer) ||
+                (image != NULL && uploads[i].image == image)) {
+                if (uploads[i].handle != 0) {
+                    handle_pool_free(&s_uploads, uploads[i].handle);
+                }
+                mx_free(mx_default_allocator(), uploads[i].data);
                 continue;
             }
+
+            uploads[count++] = uploads[i];
         }
+        deferred->count = count;
+    }
+}
 
-        if (validated != MX_SUCCESS) {
-            MX_LOG_ERROR("Extension required not supported: %s!\n", k_req_exts[req_index]);
-            return -1;
+// The frame's fence has signalled, uploads it copied are complete.
+static void staging_uploads_reclaim(uint32_t frame_idx) {
+    draw_stream* in_flight = &s_uploads_in_flight[frame_idx];
+    const uint64_t* handles = (const uint64_t*)in_flight->data;
+
+    for (uint32_t i = 0; i < in_flight->count; i++) {
+        handle_pool_free(&s_uploads, handles[i]);
+    }
+
+    in_flight->count = 0;
+}
+
+static void staging_uploads_submit(uint32_t frame_idx) {
+    draw_stream* in_flight = &s_uploads_in_flight[frame_idx];
+    MX_ASSERT(in_flight->count == 0, "[Staging] Frame uploads submitted before reclaim!");
+
+    const draw_stream retired = *in_flight;
+    *in_flight = s_uploads_staged;
+    s_uploads_staged = retired;
+}
+
+typedef struct mgfx_draw_key {
+    uint64_t sort_key;
+    uint32_t draw_idx;
+    uint32_t encoder; // Encoder owning the draw record.
+} mgfx_draw_key;
+
+// Sort key layout, most significant bits first:
+//   opaque:  [view 8][layer 1][program 11][descriptors 20][depth 24]
+//   blended: [view 8][layer 1][depth 24][program 11][descriptors 20]
+// Opaque draws are grouped by pipeline then descriptor sets and go front to back within a
+// group for early depth rejection. Blended draws are layered after opaque ones and go back to
+// front, depth being stored inverted.
+enum { MGFX_SORT_KEY_VIEW_SHIFT = 56 };
+enum { MGFX_SORT_KEY_LAYER_SHIFT = 55 };
+enum { MGFX_SORT_KEY_PROGRAM_BITS = 11 };
+enum { MGFX_SORT_KEY_DESCRIPTOR_BITS = 20 };
+enum { MGFX_SORT_KEY_DEPTH_BITS = 24 };
+
+static uint64_t draw_sort_key(
+    uint8_t target, mx_bool blend, uint16_t program_id, uint32_t descriptor_hash, uint32_t depth) {
+    const uint64_t program = program_id & ((1u << MGFX_SORT_KEY_PROGRAM_BITS) - 1);
+    const uint64_t descriptors = descriptor_hash & ((1u << MGFX_SORT_KEY_DESCRIPTOR_BITS) - 1);
+    const uint64_t depth_mask = (1u << MGFX_SORT_KEY_DEPTH_BITS) - 1;
+
+    uint64_t key = (uint64_t)target << MGFX_SORT_KEY_VIEW_SHIFT;
+
+    if (!blend) {
+        return key | (program << (MGFX_SORT_KEY_DESCRIPTOR_BITS + MGFX_SORT_KEY_DEPTH_BITS)) |
+               (descriptors << MGFX_SORT_KEY_DEPTH_BITS) | (depth & depth_mask);
+    }
+
+    return key | (1ull << MGFX_SORT_KEY_LAYER_SHIFT) |
+           ((depth_mask - (depth & depth_mask))
+            << (MGFX_SORT_KEY_PROGRAM_BITS + MGFX_SORT_KEY_DESCRIPTOR_BITS)) |
+           (program << MGFX_SORT_KEY_DESCRIPTOR_BITS) | descriptors;
+}
+
+// Positive floats order the same as their bit patterns, keeping the top 24 of the 31 bits
+// gives a logarithmic quantization with more precision near the camera.
+static uint32_t draw_depth_quantize(float depth) {
+    if (!(depth > 0.0f)) {
+        return 0;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return bits >> (31 - MGFX_SORT_KEY_DEPTH_BITS);
+}
+
+typedef struct mgfx_draw {
+    mgfx_ph ph;
+
+    // Persistent index buffers are recorded with a size of 0 and their handle.
+    mgfx_transient_buffer ib;
+
+    // Offsets into the arena streams.
+    uint32_t transform;
+    uint32_t descriptors;
+    uint32_t dynamic_offsets;
+    uint32_t vertex_buffers;
+    uint32_t bindless_indices; // Only recorded for bindless programs.
+
+    union {
+        uint32_t instance_count;
+        uint32_t indirect; // Offset into the indirect stream when `indirect_draw` is set.
+    };
+
+    uint32_t descriptor_hashes[MGFX_SHADER_MAX_DESCRIPTOR_SET]; // Bind time set hashes.
+    uint8_t descriptor_counts[MGFX_SHADER_MAX_DESCRIPTOR_SET];
+    uint8_t dynamic_offset_counts[MGFX_SHADER_MAX_DESCRIPTOR_SET];
+    uint8_t vertex_buffer_count;
+    uint8_t view_target;
+    uint8_t indirect_draw;
+} mgfx_draw;
+
+// Draw arguments sourced from an indirect buffer.
+typedef struct mgfx_draw_indirect {
+    mgfx_indbh buffer;
+    mgfx_indbh count_buffer; // Optional, the draw count is read from it when set.
+
+    uint32_t offset;
+    uint32_t count_offset;
+    uint32_t max_draw_count;
+    uint32_t stride;
+} mgfx_draw_indirect;
+
+// View transforms are read from the per view uniform block.
+typedef struct mgfx_draw_pc {
+    float model[16];
+} mgfx_draw_pc;
+
+typedef struct mgfx_draw_arena {
+    draw_stream keys;             // mgfx_draw_key
+    draw_stream draws;            // mgfx_draw
+    draw_stream descriptors;      // mgfx_dh
+    draw_stream dynamic_offsets;  // uint32_t
+    draw_stream vertex_buffers;   // mgfx_transient_buffer
+    draw_stream matrices;         // float[16]
+    draw_stream indirects;        // mgfx_draw_indirect
+    draw_stream bindless_indices; // uint32_t[MGFX_BINDLESS_INDEX_COUNT]
+} mgfx_draw_arena;
+
+static void draw_arena_init(mgfx_draw_arena* arena) {
+    *arena = (mgfx_draw_arena){
+        .keys = {.stride = sizeof(mgfx_draw_key)},
+        .draws = {.stride = sizeof(mgfx_draw)},
+        .descriptors = {.stride = sizeof(mgfx_dh)},
+        .dynamic_offsets = {.stride = sizeof(uint32_t)},
+        .vertex_buffers = {.stride = sizeof(mgfx_transient_buffer)},
+        .matrices = {.stride = sizeof(float) * 16},
+        .indirects = {.stride = sizeof(mgfx_draw_indirect)},
+        .bindless_indices = {.stride = sizeof(uint32_t) * MGFX_BINDLESS_INDEX_COUNT},
+    };
+}
+
+static size_t draw_arena_size(const mgfx_draw_arena* arena) {
+    return (size_t)arena->keys.count * arena->keys.stride +
+           (size_t)arena->draws.count * arena->draws.stride +
+           (size_t)arena->descriptors.count * arena->descriptors.stride +
+           (size_t)arena->dynamic_offsets.count * arena->dynamic_offsets.stride +
+           (size_t)arena->vertex_buffers.count * arena->vertex_buffers.stride +
+           (size_t)arena->matrices.count * arena->matrices.stride +
+           (size_t)arena->indirects.count * arena->indirects.stride +
+           (size_t)arena->bindless_indices.count * arena->bindless_indices.stride;
+}
+
+static size_t draw_arena_capacity(const mgfx_draw_arena* arena) {
+    return (size_t)arena->keys.capacity * arena->keys.stride +
+           (size_t)arena->draws.capacity * arena->draws.stride +
+           (size_t)arena->descriptors.capacity * arena->descriptors.stride +
+           (size_t)arena->dynamic_offsets.capacity * arena->dynamic_offsets.stride +
+           (size_t)arena->vertex_buffers.capacity * arena->vertex_buffers.stride +
+           (size_t)arena->matrices.capacity * arena->matrices.stride +
+           (size_t)arena->indirects.capacity * arena->indirects.stride +
+           (size_t)arena->bindless_indices.capacity * arena->bindless_indices.stride;
+}
+
+static void draw_arena_reset(mgfx_draw_arena* arena) {
+    arena->keys.count = 0;
+    arena->draws.count = 0;
+    arena->descriptors.count = 0;
+    arena->dynamic_offsets.count = 0;
+    arena->vertex_buffers.count = 0;
+    arena->matrices.count = 0;
+    arena->indirects.count = 0;
+    arena->bindless_indices.count = 0;
+}
+
+static void draw_arena_destroy(mgfx_draw_arena* arena) {
+    draw_stream_destroy(&arena->keys);
+    draw_stream_destroy(&arena->draws);
+    draw_stream_destroy(&arena->descriptors);
+    draw_stream_destroy(&arena->dynamic_offsets);
+    draw_stream_destroy(&arena->vertex_buffers);
+    draw_stream_destroy(&arena->matrices);
+    draw_stream_destroy(&arena->indirects);
+    draw_stream_destroy(&arena->bindless_indices);
+}
+
+// Bind state of the draw currently being recorded. Cleared by every submit.
+typedef struct mgfx_draw_state {
+    mgfx_dh dhs[MGFX_SHADER_MAX_DESCRIPTOR_SET][MGFX_SHADER_MAX_DESCRIPTOR_BINDING];
+    uint32_t dh_hashes[MGFX_SHADER_MAX_DESCRIPTOR_SET]; // Folded as descriptors are bound.
+    uint8_t dh_counts[MGFX_SHADER_MAX_DESCRIPTOR_SET];
+
+    // Transient uniform offsets of the bindings set in `dh_dynamic_masks`.
+    uint32_t dh_dynamic_offsets[MGFX_SHADER_MAX_DESCRIPTOR_SET][MGFX_SHADER_MAX_DESCRIPTOR_BINDING];
+    uint8_t dh_dynamic_masks[MGFX_SHADER_MAX_DESCRIPTOR_SET];
+    uint8_t dynamic_offset_count;
+
+    mgfx_transient_buffer vbs[MGFX_SHADER_MAX_VERTEX_BINDING];
+    uint8_t vb_count;
+
+    mgfx_transient_buffer ib;
+} mgfx_draw_state;
+
+// Draws are recorded through encoders. Each owns its bind state and draw arena so recording
+// threads never share writes, keys are merged once all encoders have ended. Encoder 0 backs the
+// immediate mgfx_set_*, mgfx_bind_* and mgfx_submit calls.
+struct mgfx_encoder {
+    mgfx_draw_state state;
+    mgfx_draw_arena arena;
+
+    float transform[16];
+    uint32_t bindless_indices[MGFX_BINDLESS_INDEX_COUNT];
+
+    uint32_t idx;
+    mx_bool recording;
+};
+
+static void encoder_reset(mgfx_encoder* enc) {
+    memset(&enc->state, 0, sizeof(enc->state));
+}
+
+// Draw keys are ordered with a stable LSD radix sort over 8 bit digits of the sort key. Digits
+// shared by every key are skipped, so passes scale with the bits that actually vary. Large
+// draw counts split histogram and scatter across the job workers; each worker owns a
+// contiguous slice and its own offsets so the result stays stable.
+enum { MGFX_DRAW_SORT_RADIX = 256 };
+enum { MGFX_DRAW_SORT_PASSES = sizeof(uint64_t) };
+enum { MGFX_DRAW_SORT_MIN_RANGE = 16384 };
+
+typedef struct draw_sort_job {
+    const mgfx_draw_key* src;
+    mgfx_draw_key* dst;
+    uint32_t shift;
+} draw_sort_job;
+
+static uint32_t s_sort_counts[MGFX_JOBS_MAX_WORKERS][MGFX_DRAW_SORT_PASSES][MGFX_DRAW_SORT_RADIX];
+static uint32_t s_sort_offsets[MGFX_JOBS_MAX_WORKERS][MGFX_DRAW_SORT_RADIX];
+
+static void draw_sort_count_all_fn(void* ctx, uint32_t begin, uint32_t end, uint32_t worker) {
+    const draw_sort_job* job = (const draw_sort_job*)ctx;
+    uint32_t(*counts)[MGFX_DRAW_SORT_RADIX] = s_sort_counts[worker];
+
+    for (uint32_t i = begin; i < end; i++) {
+        const uint64_t key = job->src[i].sort_key;
+        for (uint32_t pass = 0; pass < MGFX_DRAW_SORT_PASSES; pass++) {
+            counts[pass][(key >> (pass * 8)) & 0xFF]++;
         }
     }
+}
 
-    instance_info.enabledExtensionCount = k_req_ext_count;
-    instance_info.ppEnabledExtensionNames = k_req_exts;
+static void draw_sort_count_fn(void* ctx, uint32_t begin, uint32_t end, uint32_t worker) {
+    const draw_sort_job* job = (const draw_sort_job*)ctx;
+    uint32_t* counts = s_sort_offsets[worker];
 
-#ifdef MX_DEBUG
-    // Check and enable validation layers.
-    uint32_t layer_prop_count;
-    vkEnumerateInstanceLayerProperties(&layer_prop_count, NULL);
-    VkLayerProperties* layer_props = mx_alloc(tmp, sizeof(VkLayerProperties) * layer_prop_count);
-    vkEnumerateInstanceLayerProperties(&layer_prop_count, layer_props);
+    for (uint32_t i = begin; i < end; i++) {
+        counts[(job->src[i].sort_key >> job->shift) & 0xFF]++;
+    }
+}
+
+static void draw_sort_scatter_fn(void* ctx, uint32_t begin, uint32_t end, uint32_t worker) {
+    const draw_sort_job* job = (const draw_sort_job*)ctx;
+    uint32_t* offsets = s_sort_offsets[worker];
+
+    for (uint32_t i = begin; i < end; i++) {
+        const mgfx_draw_key key = job->src[i];
+        job->dst[offsets[(key.sort_key >> job->shift) & 0xFF]++] = key;
+    }
+}
+
+// Sorts `count` keys using `scratch` as the ping-pong buffer. Returns whichever holds the result.
+static mgfx_draw_key* draw_sort_keys(mgfx_draw_key* keys, mgfx_draw_key* scratch, uint32_t count) {
+    if (count < 2) {
+        return keys;
+    }
+
+    uint32_t range_count = count / MGFX_DRAW_SORT_MIN_RANGE;
+    if (range_count > jobs_worker_count()) {
+        range_count = jobs_worker_count();
+    }
+    if (range_count == 0) {
+        range_count = 1;
+    }
+
+    draw_sort_job job = {.src = keys, .dst = scratch};
+
+    memset(s_sort_counts, 0, sizeof(s_sort_counts[0]) * range_count);
+    jobs_parallel_for(count, MGFX_DRAW_SORT_MIN_RANGE, draw_sort_count_all_fn, &job);
+
+    for (uint32_t worker = 1; worker < range_count; worker++) {
+        for (uint32_t pass = 0; pass < MGFX_DRAW_SORT_PASSES; pass++) {
+            for (uint32_t digit = 0; digit < MGFX_DRAW_SORT_RADIX; digit++) {
+                s_sort_counts[0][pass][digit] += s_sort_counts[worker][pass][digit];
+            }
+        }
+    }
+
+    for (uint32_t pass = 0; pass < MGFX_DRAW_SORT_PASSES; pass++) {
+        const uint32_t* totals = s_sort_counts[0][pass];
+        job.shift = pass * 8;
+
+        // Every key shares this digit.
+        if (totals[(job.src[0].sort_key >> job.shift) & 0xFF] == count) {
+            continue;
+        }
+
+        if (range_count > 1) {
+            memset(s_sort_offsets, 0, sizeof(s_sort_offsets[0]) * range_count);
+            jobs_parallel_for(count, MGFX_DRAW_SORT_MIN_RANGE, draw_sort_count_fn, &job);
+        } else {
+            memcpy(s_sort_offsets[0], totals, sizeof(s_sort_offsets[0]));
+        }
+
+        // Exclusive prefix sum, digit major and worker minor to keep slices in order.
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < MGFX_DRAW_SORT_RADIX; digit++) {
+            for (uint32_t worker = 0; worker < range_count; worker++) {
+                const uint32_t digit_count = s_sort_offsets[worker][digit];
+                s_sort_offsets[worker][digit] = offset;
+                offset += digit_count;
+            }
+        }
+
+        jobs_parallel_for(count, MGFX_DRAW_SORT_MIN_RANGE, draw_sort_scatter_fn, &job);
+
+        mgfx_draw_key* sorted = job.dst;
+        job.dst = (mgfx_draw_key*)job.src;
+        job.src = sorted;
+    }
+
+    return (mgfx_draw_key*)job.src;
+}
+
+// Draws are prepared serially in sorted order, resolving pipelines, descriptor sets and buffers,
+// then recorded into secondary command buffers by the job workers. Each view target becomes a
+// segment rendered in one dynamic rendering scope, split into chunks of at most
+// MGFX_DRAW_CHUNK_SIZE draws so large views also record in parallel.
+enum { MGFX_DRAW_CHUNK_SIZE = 1024 };
+
+typedef struct draw_cmd_vk {
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+
+    VkDescriptorSet sets[MGFX_SHADER_MAX_DESCRIPTOR_SET];
+    uint32_t set_count;
+
+    // Offsets of set `i` are dynamic_offsets[set_dynamic_offsets[i]..set_dynamic_offsets[i + 1]].
+    uint32_t dynamic_offsets[MGFX_SHADER_MAX_DYNAMIC_OFFSETS];
+    uint8_t set_dynamic_offsets[MGFX_SHADER_MAX_DESCRIPTOR_SET + 1];
+
+    VkBuffer vbs[MGFX_SHADER_MAX_VERTEX_BINDING];
+    VkDeviceSize vb_offsets[MGFX_SHADER_MAX_VERTEX_BINDING];
+    uint32_t vb_count;
+
+    VkBuffer ib;
+    uint32_t ib_offset;
+    uint32_t index_count;
+    uint32_t instance_count;
+
+    // Indirect draws read up to `indirect_draw_count` commands from `indirect`.
+    VkBuffer indirect;
+    VkDeviceSize indirect_offset;
+    uint32_t indirect_draw_count;
+    uint32_t indirect_stride;
+    VkBuffer indirect_count_buffer;
+    VkDeviceSize indirect_count_offset;
+
+    const float* model;
+    const uint32_t* bindless_indices; // Set for programs reading MGFX_SHADER_BINDLESS_SET.
+    mx_bool view_block;
+} draw_cmd_vk;
+
+typedef struct draw_segment_vk {
+    framebuffer_vk* fb;
+    uint8_t target;
+
+    uint32_t first_key;
+    uint32_t key_count;
+
+    uint32_t first_chunk;
+    uint32_t chunk_count;
+} draw_segment_vk;
+
+typedef struct draw_chunk_vk {
+    uint32_t segment;
+    uint32_t first_cmd;
+    uint32_t cmd_count;
+
+    VkCommandBuffer cmd;
+} draw_chunk_vk;
+
+static draw_stream s_draw_cmds = {.stride = sizeof(draw_cmd_vk)};
+static draw_stream s_draw_segments = {.stride = sizeof(draw_segment_vk)};
+static draw_stream s_draw_chunks = {.stride = sizeof(draw_chunk_vk)};
+
+// Resources on the submit and frame paths live in generational handle pools, handles index
+// their slot directly. Program slots double as the compact program id of draw sort keys.
+enum { MGFX_MAX_BUFFERS = 4096 };
+enum { MGFX_MAX_SHADERS = 256 };
+enum { MGFX_MAX_PROGRAMS = 1 << MGFX_SORT_KEY_PROGRAM_BITS };
+enum { MGFX_MAX_DESCRIPTORS = 4096 };
+enum { MGFX_MAX_FRAMEBUFFERS = 64 };
+enum { MGFX_MAX_TEXTURES = 4096 };
+enum { MGFX_MAX_IMAGES = MGFX_MAX_TEXTURES * 2 }; // Textures and render targets.
+enum { MGFX_MAX_CULLS = 256 };
+
+static handle_pool s_buffers;      // buffer_vk
+static handle_pool s_shaders;      // shader_vk
+static handle_pool s_programs;     // mgfx_program
+static handle_pool s_descriptors;  // descriptor_info_vk
+static handle_pool s_framebuffers; // framebuffer_vk
+static handle_pool s_textures;     // mgfx_texture
+static handle_pool s_images;       // image_vk
+static handle_pool s_culls;        // cull_vk
+
+// Cached descriptor sets are keyed by everything they were written with: the layout, and the
+// identity and version of each bound descriptor. Writing a descriptor bumps its version, so a set
+// is never reused after the resources behind it changed. Least recently used sets are evicted
+// once the cache is full and freed through the deletion queue.
+enum { MGFX_DESCRIPTOR_SET_CACHE_SIZE = 2048 };
+enum { MGFX_DESCRIPTOR_POOL_SETS = 256 };
+
+typedef struct descriptor_set_key_vk {
+    uint64_t dsl; // VkDescriptorSetLayout
+    uint64_t dhs[MGFX_SHADER_MAX_DESCRIPTOR_BINDING];
+    uint32_t versions[MGFX_SHADER_MAX_DESCRIPTOR_BINDING];
+    uint32_t dh_count;
+} descriptor_set_key_vk;
+
+typedef struct descriptor_set_entry {
+    descriptor_set_key_vk key;
+    VkDescriptorSet value;
+    VkDescriptorPool pool;
+
+    // Most recently used first.
+    struct descriptor_set_entry* lru_prev;
+    struct descriptor_set_entry* lru_next;
+
+    UT_hash_handle hh;
+} descriptor_set_entry;
+
+static descriptor_set_entry* s_descriptor_set_table;
+static descriptor_set_entry* s_descriptor_set_lru_head;
+static descriptor_set_entry* s_descriptor_set_lru_tail;
+static uint32_t s_descriptor_set_count;
+
+// Pools are chained, a new one is created once none of them can fit a set.
+static draw_stream s_ds_pools = {.stride = sizeof(VkDescriptorPool)};
+static uint32_t s_ds_pool_current;
+
+// Folds one value into a running set hash. Bind calls fold each descriptor as it is bound, so
+// draws carry their set hashes and nothing is rehashed when the frame is recorded.
+static uint32_t descriptor_hash_step(uint32_t hash, uint64_t value) {
+    const uint64_t mixed = (value ^ ((uint64_t)hash << 32 | hash)) * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(mixed >> 32) ^ (uint32_t)mixed;
+}
+
+// Array slots waiting to be written to a frame's bindless set.
+typedef struct bindless_write_vk {
+    uint64_t handle; // mgfx_th or mgfx_sbh
+    uint32_t binding;
+} bindless_write_vk;
+
+enum { MGFX_BINDLESS_WRITE_BATCH = 64 };
+static draw_stream s_bindless_writes[MGFX_FRAME_COUNT];
+
+// Built in gpu culling. Each cull owns its objects and, per view, the compacted indirect
+// commands and per batch draw counts written by the cull compute program.
+typedef struct cull_vk {
+    mgfx_sbh objects;
+    mgfx_indbh commands; // view_count * object_count VkDrawIndexedIndirectCommand
+    mgfx_indbh counts;   // view_count * batch_count uint32_t
+
+    uint32_t object_count;
+    uint32_t batch_count;
+    uint32_t view_count;
+
+    uint32_t* batch_firsts;
+    uint32_t* batch_sizes;
+    uint32_t* object_batches;
+    uint32_t* object_commands;
+
+    VkDescriptorSet ds;
+    VkDescriptorPool ds_pool; // Pool of the chain `ds` was allocated from.
+} cull_vk;
+
+static cull_vk* cull_get(mgfx_cullh cullh) {
+    cull_vk* cull = handle_pool_get(&s_culls, cullh.idx);
+    MX_ASSERT(cull != NULL, "Cull invalid handle!");
+
+    return cull;
+}
+
+// Matches the push constants of cull.comp.glsl.
+typedef struct cull_pc_vk {
+    float planes[6][4];
+    uint32_t object_count;
+    uint32_t command_offset;
+    uint32_t count_offset;
+    uint32_t compact;
+} cull_pc_vk;
+
+typedef struct cull_dispatch_vk {
+    cull_vk* cull;
+    cull_pc_vk pc;
+} cull_dispatch_vk;
+
+enum { MGFX_CULL_GROUP_SIZE = 64 };
+
+static mgfx_sh s_cull_csh;
+static mgfx_ph s_cull_ph;
+static draw_stream s_cull_dispatches = {.stride = sizeof(cull_dispatch_vk)};
+
+mgfx_fbh s_view_targets[0xFF];
+VkClearColorValue s_view_clears[0XFF] = {0};
+
+uint32_t s_width;
+uint32_t s_height;
+
+enum { MGFX_MAX_ENCODERS = 16 };
+static mgfx_encoder s_encoders[MGFX_MAX_ENCODERS];
+static volatile uint32_t s_encoder_count = 1;
+
+// Keys of every encoder, merged and sorted in mgfx_frame.
+static draw_stream s_frame_keys = {.stride = sizeof(mgfx_draw_key)};
+static draw_stream s_frame_keys_scratch = {.stride = sizeof(mgfx_draw_key)};
+
+static mgfx_stats s_stats;
+
+// Built in assets
+mgfx_th MGFX_WHITE_TEXTURE;
+mgfx_th MGFX_BLACK_TEXTURE;
+mgfx_th MGFX_LOCAL_NORMAL_TEXTURE;
+
+// Debug Text
+enum { MGFX_DEBUG_MAX_TEXT = 64 };
+static const uint32_t atlas_w = 512;
+static const uint32_t atlas_h = 512;
+
+static const char* font_path = MGFX_ASSET_PATH "fonts/Roboto-Regular.ttf";
+stbtt_packedchar chars[96]; // For ASCII 32..127
+
+mgfx_sh dbg_ui_vsh;
+mgfx_sh dbg_ui_fsh;
+mgfx_ph dbg_ui_ph;
+
+mgfx_th dbg_ui_font_atlas_th;
+mgfx_dh dbg_ui_font_atlas_dh;
+
+// Debug Gizmos
+mgfx_vbh dbg_quad_vbh;
+mgfx_ibh dbg_quad_ibh;
+
+static mx_allocator_t mgfx_allocator;
+
+// The arrays cover every texture and buffer slot and are read by both graphics stages.
+static mx_bool bindless_supported(const VkPhysicalDeviceFeatures* features,
+                                  const VkPhysicalDeviceVulkan12Features* vk12_features) {
+    if (!features->shaderSampledImageArrayDynamicIndexing ||
+        !features->shaderStorageBufferArrayDynamicIndexing ||
+        !vk12_features->runtimeDescriptorArray || !vk12_features->descriptorBindingPartiallyBound ||
+        !vk12_features->descriptorBindingSampledImageUpdateAfterBind ||
+        !vk12_features->descriptorBindingStorageBufferUpdateAfterBind) {
+        return MX_FALSE;
+    }
+
+    VkPhysicalDeviceVulkan12Properties vk12_props = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+    };
+    VkPhysicalDeviceProperties2 props = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &vk12_props,
+    };
+    vkGetPhysicalDeviceProperties2(s_phys_device, &props);
+
+    return vk12_props.maxPerStageDescriptorUpdateAfterBindSamplers >= MGFX_MAX_TEXTURES &&
+           vk12_props.maxPerStageDescriptorUpdateAfterBindSampledImages >= MGFX_MAX_TEXTURES &&
+           vk12_props.maxPerStageDescriptorUpdateAfterBindStorageBuffers >= MGFX_MAX_BUFFERS &&
+           vk12_props.maxDescriptorSetUpdateAfterBindSamplers >= MGFX_MAX_TEXTURES &&
+           vk12_props.maxDescriptorSetUpdateAfterBindSampledImages >= MGFX_MAX_TEXTURES &&
+           vk12_props.maxDescriptorSetUpdateAfterBindStorageBuffers >= MGFX_MAX_BUFFERS &&
+           vk12_props.maxPerStageUpdateAfterBindResources >= MGFX_MAX_TEXTURES + MGFX_MAX_BUFFERS;
+}
+
+static void bindless_init() {
+    const VkDescriptorSetLayoutBinding bindings[] = {
+        {
+            .binding = MGFX_BINDLESS_TEXTURE_BINDING,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = MGFX_MAX_TEXTURES,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        },
+        {
+            .binding = MGFX_BINDLESS_BUFFER_BINDING,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = MGFX_MAX_BUFFERS,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        },
+    };
+
+    // Slots of destroyed or never created resources stay unwritten.
+    const VkDescriptorBindingFlags binding_flags[] = {
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
+    };
+
+    const VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .pNext = NULL,
+        .bindingCount = sizeof(binding_flags) / sizeof(VkDescriptorBindingFlags),
+        .pBindingFlags = binding_flags,
+    };
+
+    const VkDescriptorSetLayoutCreateInfo dsl_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &binding_flags_info,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = sizeof(bindings) / sizeof(VkDescriptorSetLayoutBinding),
+        .pBindings = bindings,
+    };
+    VK_CHECK(vkCreateDescriptorSetLayout(s_device, &dsl_info, NULL, &s_bindless_dsl));
+
+    const VkDescriptorPoolSize pool_sizes[] = {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MGFX_MAX_TEXTURES * MGFX_FRAME_COUNT},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MGFX_MAX_BUFFERS * MGFX_FRAME_COUNT},
+    };
+
+    const VkDescriptorPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = NULL,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = MGFX_FRAME_COUNT,
+        .poolSizeCount = sizeof(pool_sizes) / sizeof(VkDescriptorPoolSize),
+        .pPoolSizes = pool_sizes,
+    };
+    VK_CHECK(vkCreateDescriptorPool(s_device, &pool_info, NULL, &s_bindless_pool));
+
+    VkDescriptorSetLayout dsls[MGFX_FRAME_COUNT];
+    for (uint32_t i = 0; i < MGFX_FRAME_COUNT; i++) {
+        dsls[i] = s_bindless_dsl;
+        s_bindless_writes[i] = (draw_stream){.stride = sizeof(bindless_write_vk)};
+    }
+
+    const VkDescriptorSetAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = NULL,
+        .descriptorPool = s_bindless_pool,
+        .descriptorSetCount = MGFX_FRAME_COUNT,
+        .pSetLayouts = dsls,
+    };
+    VK_CHECK(vkAllocateDescriptorSets(s_device, &alloc_info, s_bindless_ds));
+}
+
+// Queues a slot for every frame's set, the resource is read again when the write is applied.
+static void bindless_write_push(uint64_t handle, uint32_t binding) {
+    if (!s_bindless) {
+        return;
+    }
+
+    const bindless_write_vk write = {.handle = handle, .binding = binding};
+    for (uint32_t i = 0; i < MGFX_FRAME_COUNT; i++) {
+        draw_stream_push(&s_bindless_writes[i], &write, 1);
+    }
+}
+
+static void bindless_writes_flush(uint32_t frame_idx) {
+    draw_stream* queue = &s_bindless_writes[frame_idx];
+    const bindless_write_vk* writes = (const bindless_write_vk*)queue->data;
+
+    VkWriteDescriptorSet batch[MGFX_BINDLESS_WRITE_BATCH];
+    VkDescriptorImageInfo image_infos[MGFX_BINDLESS_WRITE_BATCH];
+    VkDescriptorBufferInfo buffer_infos[MGFX_BINDLESS_WRITE_BATCH];
+    uint32_t batch_count = 0;
+
+    for (uint32_t write_idx = 0; write_idx < queue->count; write_idx++) {
+        const bindless_write_vk* write = &writes[write_idx];
+
+        VkWriteDescriptorSet* ds_write = &batch[batch_count];
+        *ds_write = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = NULL,
+            .dstSet = s_bindless_ds[frame_idx],
+            .dstBinding = write->binding,
+            .dstArrayElement = handle_pool_index(write->handle),
+            .descriptorCount = 1,
+        };
+
+        // Resources destroyed since are skipped, a newer one may already own the slot.
+        if (write->binding == MGFX_BINDLESS_TEXTURE_BINDING) {
+            const mgfx_texture* texture = handle_pool_get(&s_textures, write->handle);
+            if (!texture) {
+                continue;
+            }
+
+            image_infos[batch_count] = (VkDescriptorImageInfo){
+                .sampler = (VkSampler)texture->sampler,
+                .imageView = (VkImageView)texture->view,
+                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            };
+            ds_write->descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            ds_write->pImageInfo = &image_infos[batch_count];
+        } else {
+            const buffer_vk* buffer = handle_pool_get(&s_buffers, write->handle);
+            if (!buffer) {
+                continue;
+            }
+
+            buffer_infos[batch_count] = (VkDescriptorBufferInfo){
+                .buffer = buffer->handle,
+                .offset = 0,
+                .range = VK_WHOLE_SIZE,
+            };
+            ds_write->descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            ds_write->pBufferInfo = &buffer_infos[batch_count];
+        }
+
+        if (++batch_count == MGFX_BINDLESS_WRITE_BATCH) {
+            vkUpdateDescriptorSets(s_device, batch_count, batch, 0, NULL);
+            batch_count = 0;
+        }
+    }
+
+    if (batch_count > 0) {
+        vkUpdateDescriptorSets(s_device, batch_count, batch, 0, NULL);
+    }
+
+    s_stats.bindless_writes = queue->count;
+    queue->count = 0;
+}
+
+mx_bool mgfx_bindless_enabled() { return s_bindless; }
+
+int mgfx_init(const mgfx_init_info* info) {
+    mx_scoped_allocator(MX_MB) tmp = mx_scoped_allocator_create();
+
+    jobs_init(0);
+
+#ifdef MGFX_BASISU
+    basis_transcoder_init();
+#endif
+
+    for (uint32_t enc_idx = 0; enc_idx < MGFX_MAX_ENCODERS; enc_idx++) {
+        draw_arena_init(&s_encoders[enc_idx].arena);
+        encoder_reset(&s_encoders[enc_idx]);
+        s_encoders[enc_idx].idx = enc_idx;
+    }
+
+    handle_pool_init(&s_buffers, sizeof(buffer_vk), MGFX_MAX_BUFFERS);
+    handle_pool_init(&s_shaders, sizeof(shader_vk), MGFX_MAX_SHADERS);
+    handle_pool_init(&s_programs, sizeof(mgfx_program), MGFX_MAX_PROGRAMS);
+    handle_pool_init(&s_descriptors, sizeof(descriptor_info_vk), MGFX_MAX_DESCRIPTORS);
+    handle_pool_init(&s_framebuffers, sizeof(framebuffer_vk), MGFX_MAX_FRAMEBUFFERS);
+    handle_pool_init(&s_uploads, sizeof(upload_vk), MGFX_MAX_UPLOADS);
+    handle_pool_init(&s_textures, sizeof(mgfx_texture), MGFX_MAX_TEXTURES);
+    handle_pool_init(&s_images, sizeof(image_vk), MGFX_MAX_IMAGES);
+    handle_pool_init(&s_culls, sizeof(cull_vk), MGFX_MAX_CULLS);
+
+    VkApplicationInfo app_info = {0};
+    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_info.pNext = NULL;
+    app_info.pApplicationName = info->name;
+    app_info.applicationVersion = VK_MAKE_VERSION(0, 0, 1);
+    app_info.pEngineName = "MGFX";
+    app_info.engineVersion = VK_MAKE_VERSION(0, 0, 1);
+
+    uint32_t api_version;
+    vkEnumerateInstanceVersion(&api_version);
+    app_info.apiVersion = VK_API_VERSION_1_2;
+
+    VkInstanceCreateInfo instance_info = {0};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_info.pNext = NULL;
+    instance_info.pApplicationInfo = &app_info;
+#ifdef MX_MACOS
+    instance_info.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+#endif
+
+    // Check if required extensions are available.
+    uint32_t avail_prop_count = 0;
+    VK_CHECK(vkEnumerateInstanceExtensionProperties(NULL, &avail_prop_count, NULL));
+    VkExtensionProperties* avail_props =
+        mx_alloc(tmp, avail_prop_count * sizeof(VkExtensionProperties));
+    VK_CHECK(vkEnumerateInstanceExtensionProperties(NULL, &avail_prop_count, avail_props));
+
+    for (int req_index = 0; req_index < k_req_ext_count; req_index++) {
+        int validated = -1;
+        for (uint32_t avail_index = 0; avail_index < avail_prop_count; avail_index++) {
+            if (strcmp(k_req_exts[req_index], avail_props[avail_index].extensionName) == 0) {
+                validated = MX_SUCCESS;
+                continue;
+            }
+        }
+
+        if (validated != MX_SUCCESS) {
+            MX_LOG_ERROR("Extension required not supported: %s!\n", k_req_exts[req_index]);
+            return -1;
+        }
+    }
+
+    instance_info.enabledExtensionCount = k_req_ext_count;
+    instance_info.ppEnabledExtensionNames = k_req_exts;
+
+#ifdef MX_DEBUG
+    // Check and enable validation layers.
+    uint32_t layer_prop_count;
+    vkEnumerateInstanceLayerProperties(&layer_prop_count, NULL);
+    VkLayerProperties* layer_props = mx_alloc(tmp, sizeof(VkLayerProperties) * layer_prop_count);
+    vkEnumerateInstanceLayerProperties(&layer_prop_count, layer_props);
+
+    const char* validationLayers = {"VK_LAYER_KHRONOS_validation"};
+
+    for (uint32_t i = 0; i < layer_prop_count; i++) {
+        if (strcmp(validationLayers, layer_props[i].layerName) == 0) {
+            MX_LOG_WARN("Validation layers enabled");
+            instance_info.enabledLayerCount = 1;
+            instance_info.ppEnabledLayerNames = &validationLayers;
+            break;
+        }
+    }
+#endif
+
+    VK_CHECK(vkCreateInstance(&instance_info, NULL, &s_instance));
+
+    // Extension functions.
+    vk_cmd_begin_rendering_khr =
+        (PFN_vkCmdBeginRenderingKHR)vkGetInstanceProcAddr(s_instance, "vkCmdBeginRenderingKHR");
+    vk_cmd_end_rendering_khr =
+        (PFN_vkCmdEndRenderingKHR)vkGetInstanceProcAddr(s_instance, "vkCmdEndRenderingKHR");
+
+#ifdef MX_DEBUG
+    VkDebugUtilsMessengerCreateInfoEXT debug_messenger_info = {0};
+    debug_messenger_info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+    debug_messenger_info.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
+                                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+                                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    debug_messenger_info.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+                                       VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+                                       VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+    debug_messenger_info.pfnUserCallback = vk_debug_callback;
+    debug_messenger_info.pUserData = NULL;
+
+    create_debug_util_messenger_ext(s_instance, &debug_messenger_info, NULL, &s_debug_messenger);
+#endif
+    if (choose_physical_device_vk(s_instance,
+                                  k_req_device_ext_count,
+                                  k_req_device_ext_names,
+                                  &s_phys_device_props,
+                                  &s_phys_device,
+                                  tmp) != VK_SUCCESS) {
+        MX_LOG_ERROR("Failed to find suitable physical device!");
+        return -1;
+    }
+
+    VK_CHECK(get_window_surface_vk(s_instance, info->nwh, &s_surface));
+
+    uint32_t queue_family_props_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(s_phys_device, &queue_family_props_count, NULL);
+    VkQueueFamilyProperties* queue_family_props =
+        mx_alloc(tmp, sizeof(VkQueueFamilyProperties) * queue_family_props_count);
+
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        s_phys_device, &queue_family_props_count, queue_family_props);
+
+    int unique_queue_count = 0;
+    for (uint32_t i = 0; i < queue_family_props_count; i++) {
+        if ((queue_family_props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) == VK_QUEUE_GRAPHICS_BIT) {
+            s_queue_indices[MGFX_QUEUE_GRAPHICS] = i;
+        }
+
+        VkBool32 present_supported = VK_FALSE;
+        vkGetPhysicalDeviceSurfaceSupportKHR(s_phys_device, i, s_surface, &present_supported);
+        if (present_supported == VK_TRUE) {
+            s_queue_indices[MGFX_QUEUE_PRESENT] = i;
+        }
+
+        ++unique_queue_count;
+
+        // Check if complete.
+        int complete = MGFX_SUCCESS;
+        for (uint16_t j = 0; j < unique_queue_count; j++) {
+            if (s_queue_indices[MGFX_QUEUE_PRESENT] == -1) {
+                complete = !MGFX_SUCCESS;
+            }
+        }
+
+        if (complete == MGFX_SUCCESS) {
+            break;
+        }
+    }
+
+    for (uint16_t i = 0; i < MGFX_QUEUE_COUNT; i++) {
+        if (s_queue_indices[MGFX_QUEUE_PRESENT] == -1) {
+            MX_LOG_ERROR("Failed to find graphics queue!");
+            break;
+        }
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_infos[MGFX_QUEUE_COUNT] = {0};
+    for (uint16_t i = 0; i < unique_queue_count; i++) {
+        queue_infos[i].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queue_infos[i].pNext = NULL;
+        queue_infos[i].flags = 0;
+        queue_infos[i].queueFamilyIndex = s_queue_indices[i];
+        queue_infos[i].queueCount = 1;
+        queue_infos[i].pQueuePriorities = &queue_priority;
+    }
+
+    VkPhysicalDeviceVulkan12Features supported_vk12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+    };
+    VkPhysicalDeviceFeatures2 supported_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &supported_vk12_features,
+    };
+    vkGetPhysicalDeviceFeatures2(s_phys_device, &supported_features);
+
+    s_multi_draw_indirect = supported_features.features.multiDrawIndirect == VK_TRUE;
+    s_texture_compression_bc = supported_features.features.textureCompressionBC == VK_TRUE;
+    s_draw_indirect_count = supported_vk12_features.drawIndirectCount == VK_TRUE;
+    s_draw_indirect_first_instance =
+        supported_features.features.drawIndirectFirstInstance == VK_TRUE;
+
+    if (info->bindless) {
+        s_bindless = bindless_supported(&supported_features.features, &supported_vk12_features);
+        if (!s_bindless) {
+            MX_LOG_WARN("Device lacks descriptor indexing, bindless arrays are disabled!");
+        }
+    }
+
+    VkPhysicalDeviceFeatures phys_device_features = {0};
+    phys_device_features.fillModeNonSolid = VK_TRUE;
+    phys_device_features.multiDrawIndirect = s_multi_draw_indirect;
+    phys_device_features.textureCompressionBC = s_texture_compression_bc;
+    phys_device_features.drawIndirectFirstInstance = s_draw_indirect_first_instance;
+    phys_device_features.shaderSampledImageArrayDynamicIndexing = s_bindless;
+    phys_device_features.shaderStorageBufferArrayDynamicIndexing = s_bindless;
+
+    // Non uniform indexing is optional, shaders indexing by dynamically uniform values work
+    // without it.
+    VkPhysicalDeviceVulkan12Features vk12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .drawIndirectCount = s_draw_indirect_count,
+        .runtimeDescriptorArray = s_bindless,
+        .descriptorBindingPartiallyBound = s_bindless,
+        .descriptorBindingSampledImageUpdateAfterBind = s_bindless,
+        .descriptorBindingStorageBufferUpdateAfterBind = s_bindless,
+        .shaderSampledImageArrayNonUniformIndexing =
+            s_bindless && supported_vk12_features.shaderSampledImageArrayNonUniformIndexing,
+        .shaderStorageBufferArrayNonUniformIndexing =
+            s_bindless && supported_vk12_features.shaderStorageBufferArrayNonUniformIndexing,
+    };
+
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+        .pNext = &vk12_features,
+        .dynamicRendering = VK_TRUE,
+    };
+
+    VkDeviceCreateInfo device_info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = &dynamic_rendering_features,
+        .flags = 0,
+        .queueCreateInfoCount = unique_queue_count,
+        .pQueueCreateInfos = queue_infos,
+        .enabledExtensionCount = k_req_device_ext_count,
+        .ppEnabledExtensionNames = k_req_device_ext_names,
+        .pEnabledFeatures = &phys_device_features,
+    };
+    VK_CHECK(vkCreateDevice(s_phys_device, &device_info, NULL, &s_device));
+
+    for (uint16_t i = 0; i < unique_queue_count; i++) {
+        vkGetDeviceQueue(s_device, s_queue_indices[i], 0, &s_queues[i]);
+    }
+
+#ifdef MX_MACOS
+    PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR;
+#endif
+
+    VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(s_phys_device, s_surface, &s_surface_caps));
+
+    uint32_t surface_fmt_count = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(s_phys_device, s_surface, &surface_fmt_count, NULL);
+    VkSurfaceFormatKHR* surface_fmts =
+        mx_alloc(tmp, surface_fmt_count * sizeof(VkSurfaceFormatKHR));
+    vkGetPhysicalDeviceSurfaceFormatsKHR(
+        s_phys_device, s_surface, &surface_fmt_count, surface_fmts);
+
+    int surface_format_found = -1;
+    for (uint32_t i = 0; i < surface_fmt_count; i++) {
+        if (surface_fmts[i].format == k_surface_fmt &&
+            surface_fmts[i].colorSpace == k_surface_color_space) {
+            surface_format_found = MGFX_SUCCESS;
+            break;
+        }
+    }
+
+    MX_ASSERT(surface_format_found == MGFX_SUCCESS, "Required surface format not found!");
+
+    uint32_t present_mode_count = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(s_phys_device, s_surface, &present_mode_count, NULL);
+    VkPresentModeKHR* present_modes = mx_alloc(tmp, surface_fmt_count * sizeof(VkPresentModeKHR));
+    vkGetPhysicalDeviceSurfacePresentModesKHR(
+        s_phys_device, s_surface, &present_mode_count, present_modes);
+    for (uint32_t i = 0; i < present_mode_count; i++) {
+    }
+
+    VkExtent2D swapchain_extent;
+    choose_swapchain_extent_vk(&s_surface_caps, info->nwh, &swapchain_extent);
+
+    swapchain_create(s_surface, swapchain_extent.width, swapchain_extent.height, &s_swapchain, tmp);
+
+    VmaAllocatorCreateInfo allocator_info = {
+        .instance = s_instance, .physicalDevice = s_phys_device, .device = s_device,
+        /*.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,*/
+    };
+    VK_CHECK(vmaCreateAllocator(&allocator_info, &s_allocator));
+
+    for (int i = 0; i < MGFX_FRAME_COUNT; i++) {
+        VkCommandPoolCreateInfo gfx_cmd_pool = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .pNext = NULL,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = s_queue_indices[MGFX_QUEUE_GRAPHICS],
+        };
+        VK_CHECK(vkCreateCommandPool(s_device, &gfx_cmd_pool, NULL, &s_frames[i].cmd_pool));
+
+        VkCommandBufferAllocateInfo buffer_alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext = NULL,
+            .commandPool = s_frames[i].cmd_pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        VK_CHECK(vkAllocateCommandBuffers(s_device, &buffer_alloc_info, &s_frames[i].cmd));
+
+        for (uint32_t worker = 0; worker < jobs_worker_count(); worker++) {
+            VkCommandPoolCreateInfo worker_cmd_pool = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .pNext = NULL,
+                .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                .queueFamilyIndex = s_queue_indices[MGFX_QUEUE_GRAPHICS],
+            };
+            VK_CHECK(vkCreateCommandPool(
+                s_device, &worker_cmd_pool, NULL, &s_frames[i].worker_cmds[worker].pool));
+        }
+
+        VkSemaphoreCreateInfo swapchain_semaphore_info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = NULL,
+            .flags = 0,
+        };
+        VK_CHECK(vkCreateSemaphore(
+            s_device, &swapchain_semaphore_info, NULL, &s_frames[i].swapchain_semaphore));
+
+        VkSemaphoreCreateInfo render_semaphore_info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = NULL,
+            .flags = 0,
+        };
+        VK_CHECK(vkCreateSemaphore(
+            s_device, &render_semaphore_info, NULL, &s_frames[i].render_semaphore));
+
+        VkFenceCreateInfo fence_info = {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            .pNext = NULL,
+            .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+        };
+        VK_CHECK(vkCreateFence(s_device, &fence_info, NULL, &s_frames[i].render_fence));
+
+        s_deletions[i] = (draw_stream){.stride = sizeof(deletion_vk)};
+        s_uploads_in_flight[i] = (draw_stream){.stride = sizeof(uint64_t)};
+    }
+
+    // Per view uniform block.
+    const VkDescriptorSetLayoutBinding view_binding = {
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        .pImmutableSamplers = NULL,
+    };
+
+    const VkDescriptorSetLayoutCreateInfo view_dsl_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .bindingCount = 1,
+        .pBindings = &view_binding,
+    };
+    VK_CHECK(vkCreateDescriptorSetLayout(s_device, &view_dsl_info, NULL, &s_view_dsl));
+
+    buffer_create(sizeof(s_view_blocks) * MGFX_FRAME_COUNT,
+                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                  VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                  &s_view_buffer);
+
+    // Lives until shutdown, which destroys the whole pool chain.
+    VkDescriptorPool view_ds_pool;
+    s_view_ds = descriptor_set_allocate(s_view_dsl, &view_ds_pool);
+
+    const VkDescriptorBufferInfo view_buffer_info = {
+        .buffer = s_view_buffer.handle,
+        .offset = 0,
+        .range = sizeof(view_block_vk),
+    };
+
+    const VkWriteDescriptorSet view_write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = NULL,
+        .dstSet = s_view_ds,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .pImageInfo = NULL,
+        .pBufferInfo = &view_buffer_info,
+        .pTexelBufferView = NULL,
+    };
+    vkUpdateDescriptorSets(s_device, 1, &view_write, 0, NULL);
+
+    if (s_bindless) {
+        bindless_init();
+    }
+
+    // Transient uniforms
+    buffer_create((size_t)MGFX_TRANSIENT_UNIFORM_REGION_SIZE * MGFX_TRANSIENT_UNIFORM_REGIONS +
+                      MGFX_TRANSIENT_UNIFORM_RANGE,
+                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                  VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                  &s_tub_buffer);
+
+    VmaAllocationInfo tub_alloc_info;
+    vmaGetAllocationInfo(s_allocator, s_tub_buffer.allocation, &tub_alloc_info);
+    s_tub_data = (uint8_t*)tub_alloc_info.pMappedData;
+    MX_ASSERT(s_tub_data != NULL, "[TransientUniform] Buffer is not host visible!");
+
+    for (uint32_t target = 0; target < 0xFF; target++) {
+        mgfx_set_view_transform((uint8_t)target, MX_MAT4_IDENTITY.val, MX_MAT4_IDENTITY.val);
+    }
+
+    // Initialize staging buffers
+    transient_ring_init(&s_tsb_pool,
+                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                        info->staging_block_size > 0 ? info->staging_block_size
+                                                     : MGFX_STAGING_BLOCK_SIZE,
+                        info->staging_budget > 0 ? info->staging_budget : MGFX_STAGING_BUDGET);
+    s_upload_budget = info->upload_budget > 0 ? info->upload_budget : MGFX_UPLOAD_BUDGET;
+
+    transient_ring_init(&s_tvb_pool,
+                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                        info->transient_vertex_block_size > 0 ? info->transient_vertex_block_size
+                                                              : MGFX_TRANSIENT_VERTEX_BLOCK_SIZE,
+                        0);
+    transient_ring_init(&s_tib_pool,
+                        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                        info->transient_index_block_size > 0 ? info->transient_index_block_size
+                                                             : MGFX_TRANSIENT_INDEX_BLOCK_SIZE,
+                        0);
+
+    memset(s_view_targets, 0, sizeof(mgfx_fbh) * 0xFF);
+
+    // Init mgfx
+    mgfx_set_view_clear(MGFX_DEFAULT_VIEW_TARGET, (float[4]){0.0f, 0.0f, 0.0f, 1.0f});
+
+    // Init debug text
+    dbg_ui_vsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/text.vert.glsl.spv");
+    dbg_ui_fsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/text.frag.glsl.spv");
+    dbg_ui_ph = mgfx_program_create_graphics(dbg_ui_vsh, dbg_ui_fsh);
+
+    // Init culling
+    s_cull_csh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/cull.comp.glsl.spv");
+    s_cull_ph = mgfx_program_create_compute(s_cull_csh);
+
+    size_t font_file_size;
+    if (mx_read_file(font_path, &font_file_size, NULL) != MX_SUCCESS) {
+        MX_LOG_ERROR("Failed to load font: %s!", font_path);
+        exit(-1);
+    }
+
+    unsigned char* ttf_buffer = mx_alloc(tmp, font_file_size); // load .ttf file
+    mx_read_file(font_path, &font_file_size, ttf_buffer);
+
+    unsigned char atlas_bitmap[512 * 512];
+
+    stbtt_pack_context context;
+    stbtt_PackBegin(&context, atlas_bitmap, atlas_w, atlas_h, 0, 1, NULL);
+    stbtt_PackFontRange(&context, ttf_buffer, 0, 32.0f, 32, 96, chars);
+
+    // Done packing
+    stbtt_PackEnd(&context);
+
+    stbtt_fontinfo font;
+    stbtt_InitFont(&font, ttf_buffer, stbtt_GetFontOffsetForIndex(ttf_buffer, 0));
+
+    const mgfx_image_info img_info = {
+        .format = VK_FORMAT_R8_UNORM,
+        .width = atlas_w,
+        .height = atlas_h,
+        .layers = 1,
+        .cube_map = MX_FALSE,
+    };
+
+    dbg_ui_font_atlas_th = mgfx_texture_create_from_memory(
+        &img_info, VK_FILTER_LINEAR, atlas_bitmap, atlas_w * atlas_h);
+    dbg_ui_font_atlas_dh =
+        mgfx_descriptor_create("u_diffuse", VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    mgfx_set_texture(dbg_ui_font_atlas_dh, dbg_ui_font_atlas_th);
+
+    typedef struct glyph_vertex {
+        float position[3];
+        float uv_x;
+        float normal[3];
+        float uv_y;
+        float color[4];
+    } glyph_vertex;
+
+    const mgfx_image_info texture_info = {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .width = 1,
+        .height = 1,
+        .layers = 1,
+        .cube_map = MX_FALSE,
+    };
+
+    MGFX_WHITE_TEXTURE = mgfx_texture_create_from_memory(
+        &texture_info, VK_FILTER_NEAREST, (uint8_t[4]){255, 255, 255, 255}, 4);
+
+    MGFX_BLACK_TEXTURE = mgfx_texture_create_from_memory(
+        &texture_info, VK_FILTER_NEAREST, (uint8_t[4]){0, 0, 0, 0}, 4);
+
+    MGFX_LOCAL_NORMAL_TEXTURE = mgfx_texture_create_from_memory(
+        &texture_info, VK_FILTER_NEAREST, (uint8_t[4]){128, 128, 255, 255}, 4);
+
+    // Init gizmos
+    dbg_quad_vbh = mgfx_vertex_buffer_create(MGFX_FS_QUAD_VERTICES, sizeof(MGFX_FS_QUAD_VERTICES));
+    dbg_quad_ibh = mgfx_index_buffer_create(MGFX_FS_QUAD_INDICES, sizeof(MGFX_FS_QUAD_INDICES));
+
+    MX_LOG_SUCCESS("MGFX Initialized!");
+    return MGFX_SUCCESS;
+}
+
+static buffer_vk* buffer_get(uint64_t idx) {
+    buffer_vk* buffer = handle_pool_get(&s_buffers, idx);
+    MX_ASSERT(buffer != NULL, "Buffer invalid handle!");
+
+    return buffer;
+}
+
+mgfx_vbh mgfx_vertex_buffer_create(const void* data, size_t len) {
+    vertex_buffer_vk* buffer;
+    const uint64_t idx = handle_pool_alloc(&s_buffers, (void**)&buffer);
+    if (idx == 0) {
+        return (mgfx_vbh){0};
+    }
+
+    vertex_buffer_create(data, len, buffer);
+
+    return (mgfx_vbh){.idx = idx};
+}
+
+mgfx_indbh mgfx_indirect_buffer_create(const void* data, size_t len) {
+    indirect_buffer_vk* buffer;
+    const uint64_t idx = handle_pool_alloc(&s_buffers, (void**)&buffer);
+    if (idx == 0) {
+        return (mgfx_indbh){0};
+    }
+
+    indirect_buffer_create(data, len, buffer);
+
+    return (mgfx_indbh){.idx = idx};
+}
+
+mgfx_sbh mgfx_storage_buffer_create(const void* data, size_t len) {
+    storage_buffer_vk* buffer;
+    const uint64_t idx = handle_pool_alloc(&s_buffers, (void**)&buffer);
+    if (idx == 0) {
+        return (mgfx_sbh){0};
+    }
+
+    storage_buffer_create(data, len, buffer);
+    bindless_write_push(idx, MGFX_BINDLESS_BUFFER_BINDING);
+
+    return (mgfx_sbh){.idx = idx};
+}
+
+mgfx_instbh mgfx_instance_buffer_create(const void* data, size_t len) {
+    // Instance data is read through a vertex binding at instance rate.
+    const mgfx_vbh vbh = mgfx_vertex_buffer_create(data, len);
+    return (mgfx_instbh){.idx = vbh.idx};
+}
+
+void mgfx_transient_vertex_buffer_allocate(const void* data,
+                                           size_t len,
+                                           mgfx_transient_buffer* out) {
+    transient_ring_allocate(&s_tvb_pool, data, len, out);
+}
+
+void mgfx_transient_index_buffer_allocate(const void* data,
+                                          size_t len,
+                                          mgfx_transient_buffer* out) {
+    transient_ring_allocate(&s_tib_pool, data, len, out);
+}
+
+void mgfx_transient_instance_buffer_allocate(const void* data,
+                                             size_t len,
+                                             mgfx_transient_buffer* out) {
+    transient_ring_allocate(&s_tvb_pool, data, len, out);
+}
+
+void mgfx_transient_uniform_buffer_allocate(const void* data,
+                                            size_t len,
+                                            mgfx_transient_buffer* out) {
+    MX_ASSERT(len <= MGFX_TRANSIENT_UNIFORM_RANGE,
+              "[TransientUniform] Allocation larger than the descriptor range!");
+
+    const uint32_t alignment = (uint32_t)s_phys_device_props.limits.minUniformBufferOffsetAlignment;
+    const uint32_t size = ((uint32_t)len + alignment - 1) & ~(alignment - 1);
+
+    // The head keeps growing past a failed allocation, every later one this frame fails too.
+    const uint32_t head = jobs_atomic_add(&s_tub_head, size);
+    if (head > MGFX_TRANSIENT_UNIFORM_REGION_SIZE - size) {
+        MX_LOG_ERROR("[TransientUniform] Frame region exhausted!");
+        memset(out, 0, sizeof(mgfx_transient_buffer));
+        return;
+    }
+
+    const uint32_t offset = MGFX_TRANSIENT_UNIFORM_REGION_SIZE * s_tub_region + head;
+    memcpy(s_tub_data + offset, data, len);
+
+    *out = (mgfx_transient_buffer){
+        .size = (uint32_t)len,
+        .offset = offset,
+        .buffer_handle = (mx_ptr_t)s_tub_buffer.handle,
+    };
+}
+
+mgfx_ibh mgfx_index_buffer_create(const void* data, size_t len) {
+    index_buffer_vk* buffer;
+    const uint64_t idx = handle_pool_alloc(&s_buffers, (void**)&buffer);
+    if (idx == 0) {
+        return (mgfx_ibh){0};
+    }
+
+    index_buffer_create(data, len, buffer);
+
+    return (mgfx_ibh){.idx = idx};
+}
+
+mgfx_ubh mgfx_uniform_buffer_create(const void* data, size_t len) {
+    uniform_buffer_vk* buffer;
+    const uint64_t idx = handle_pool_alloc(&s_buffers, (void**)&buffer);
+    if (idx == 0) {
+        return (mgfx_ubh){0};
+    }
+
+    uniform_buffer_create(data, len, buffer);
+
+    return (mgfx_ubh){.idx = idx};
+}
+
+void mgfx_buffer_update(uint64_t buffer_idx, const void* data, size_t len, size_t offset) {
+    buffer_update(buffer_get(buffer_idx), offset, len, data);
+}
+
+mgfx_uploadh mgfx_buffer_update_ex(
+    uint64_t buffer_idx, const void* data, size_t len, size_t offset, uint32_t priority) {
+    const uint64_t upload_idx = buffer_upload(buffer_get(buffer_idx), offset, len, data, priority);
+    return (mgfx_uploadh){.idx = upload_idx};
+}
+
+mx_bool mgfx_upload_complete(mgfx_uploadh uh) {
+    return handle_pool_get(&s_uploads, uh.idx) == NULL;
+}
+
+void mgfx_buffer_destroy(uint64_t idx) {
+    buffer_destroy(buffer_get(idx));
+    handle_pool_free(&s_buffers, idx);
+}
+
+mgfx_sh mgfx_shader_create(const char* path) {
+    size_t size;
+    if (mx_read_file(path, &size, NULL) != MX_SUCCESS) {
+        MX_LOG_ERROR("Failed to load shader: %s!", path);
+        exit(-1);
+    }
+
+    shader_vk* shader;
+    const uint64_t idx = handle_pool_alloc(&s_shaders, (void**)&shader);
+    if (idx == 0) {
+        return (mgfx_sh){0};
+    }
+
+    char* shader_code = mx_alloc(mx_default_allocator(), size);
+    mx_read_file(path, &size, shader_code);
+
+    MX_LOG_TRACE("%s...", path);
+    shader_create(size, shader_code, shader);
+
+    return (mgfx_sh){.idx = idx};
+}
+
+void mgfx_shader_destroy(mgfx_sh sh) {
+    shader_vk* shader = handle_pool_get(&s_shaders, sh.idx);
+    MX_ASSERT(shader != NULL, "Shader invalid handle!");
+
+    shader_destroy(shader);
+    handle_pool_free(&s_shaders, sh.idx);
+}
+
+mgfx_ph mgfx_program_create_graphics_ex(mgfx_sh vsh,
+                                        mgfx_sh fsh,
+                                        const mgfx_graphics_ex_create_info* ex_info) {
+    mgfx_program* program;
+    const mgfx_ph ph = {.idx = handle_pool_alloc(&s_programs, (void**)&program)};
+    if (ph.idx == 0) {
+        return ph;
+    }
+
+    program->shaders[MGFX_SHADER_STAGE_VERTEX] = vsh;
+    program->shaders[MGFX_SHADER_STAGE_FRAGMENT] = fsh;
+
+    program->polygon_mode = ex_info->polygon_mode;
+    program->primitive_topology = ex_info->primitive_topology;
+    program->cull_mode = ex_info->cull_mode;
+    program->blend = ex_info->blend;
+    program->id = (uint16_t)handle_pool_index(ph.idx);
+
+    // Known before the pipeline exists, submits record bindless indices for it.
+    const shader_vk* vs = handle_pool_get(&s_shaders, vsh.idx);
+    const shader_vk* fs = handle_pool_get(&s_shaders, fsh.idx);
+    program->bindless = (vs && vs->ds_infos[MGFX_SHADER_BINDLESS_SET].bindless) ||
+                        (fs && fs->ds_infos[MGFX_SHADER_BINDLESS_SET].bindless);
+    MX_ASSERT(!program->bindless || s_bindless,
+              "Bindless shaders require mgfx_init_info.bindless!");
+
+    if (ex_info->instanced) {
+        MX_ASSERT(vs != NULL, "Shader invalid handle!");
+
+        mx_bool has_instance_binding = MX_FALSE;
+        for (uint32_t i = 0; i < vs->vertex_binding_count; i++) {
+            if (vs->vertex_bindings[i].inputRate == VK_VERTEX_INPUT_RATE_INSTANCE) {
+                has_instance_binding = MX_TRUE;
+            }
+        }
+
+        if (!has_instance_binding) {
+            MX_LOG_WARN("Instanced program vertex shader has no per instance (i_) inputs!");
+        }
+    }
+
+    return ph;
+}
+
+mgfx_ph mgfx_program_create_graphics(mgfx_sh vsh, mgfx_sh fsh) {
+    const mgfx_graphics_ex_create_info gfx_create_info = {
+        .polygon_mode = VK_POLYGON_MODE_FILL,
+        .primitive_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        .cull_mode = VK_CULL_MODE_BACK_BIT,
+    };
+
+    return mgfx_program_create_graphics_ex(vsh, fsh, &gfx_create_info);
+}
+
+mgfx_ph mgfx_program_create(mgfx_sh* sh) { return (mgfx_ph){0}; }
+
+mgfx_ph mgfx_program_create_compute(mgfx_sh csh) {
+    mgfx_program* program;
+    const mgfx_ph ph = {.idx = handle_pool_alloc(&s_programs, (void**)&program)};
+    if (ph.idx == 0) {
+        return ph;
+    }
+
+    program->shaders[MGFX_SHADER_STAGE_COMPUTE] = csh;
+    program->id = (uint16_t)handle_pool_index(ph.idx);
+
+    // Compute pipelines do not depend on a view target and are created up front.
+    const shader_vk* cs = handle_pool_get(&s_shaders, csh.idx);
+    MX_ASSERT(cs != NULL, "Shader invalid handle!");
+
+    pipeline_create_compute(cs, program);
+
+    return ph;
+}
+
+static mgfx_program* program_get(mgfx_ph ph) {
+    mgfx_program* program = handle_pool_get(&s_programs, ph.idx);
+    MX_ASSERT(program != NULL, "Program invalid handle!");
+
+    return program;
+}
+
+void mgfx_program_destroy(mgfx_ph ph) {
+    pipeline_destroy(program_get(ph));
+    handle_pool_free(&s_programs, ph.idx);
+}
+
+static image_vk* image_get(mgfx_imgh imgh) {
+    image_vk* image = handle_pool_get(&s_images, imgh.idx);
+    MX_ASSERT(image != NULL, "Image invalid handle!");
+
+    return image;
+}
+
+mgfx_imgh mgfx_image_create(const mgfx_image_info* info, uint32_t usage) {
+    image_vk* image;
+    const mgfx_imgh imgh = {.idx = handle_pool_alloc(&s_images, (void**)&image)};
+    if (imgh.idx == 0) {
+        return imgh;
+    }
+
+    usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    image_create(info, usage, 0, image);
+
+    return imgh;
+}
+
+void mgfx_image_destroy(mgfx_imgh imgh) {
+    image_vk* image = handle_pool_get(&s_images, imgh.idx);
+    if (!image) {
+        MX_LOG_WARN("Attempting to destroy invalid image handle!");
+        return;
+    }
+
+    image_destroy(image);
+    handle_pool_free(&s_images, imgh.idx);
+}
+
+static mgfx_texture* texture_get(mgfx_th th) {
+    mgfx_texture* texture = handle_pool_get(&s_textures, th.idx);
+    MX_ASSERT(texture != NULL, "Texture invalid handle!");
+
+    return texture;
+}
+
+// Samplers are shared by every texture with the same sampler info, drivers may allow as few as
+// 4000 of them.
+typedef struct sampler_entry_vk {
+    mgfx_sampler_info key;
+    VkSampler sampler;
+    uint32_t ref_count;
+
+    UT_hash_handle hh;         // s_samplers, by info.
+    UT_hash_handle hh_sampler; // s_samplers_by_sampler, by sampler.
+} sampler_entry_vk;
+
+static sampler_entry_vk* s_samplers;
+static sampler_entry_vk* s_samplers_by_sampler;
+
+static VkSampler sampler_acquire(const mgfx_sampler_info* info) {
+    sampler_entry_vk* cached;
+    HASH_FIND(hh, s_samplers, info, sizeof(mgfx_sampler_info), cached);
+    if (cached) {
+        cached->ref_count++;
+        return cached->sampler;
+    }
+
+    VkSamplerCreateInfo sampler_info = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .magFilter = info->filter,
+        .minFilter = info->filter,
+        .mipmapMode = info->mipmap_mode,
+        .addressModeU = info->address_mode,
+        .addressModeV = info->address_mode,
+        .addressModeW = info->address_mode,
+        .mipLodBias = 0,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 0,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+        .borderColor = info->border_color,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    sampler_entry_vk* entry = mx_alloc(mx_default_allocator(), sizeof(sampler_entry_vk));
+    *entry = (sampler_entry_vk){.key = *info, .ref_count = 1};
+    VK_CHECK(vkCreateSampler(s_device, &sampler_info, NULL, &entry->sampler));
+
+    HASH_ADD(hh, s_samplers, key, sizeof(mgfx_sampler_info), entry);
+    HASH_ADD(hh_sampler, s_samplers_by_sampler, sampler, sizeof(VkSampler), entry);
+
+    return entry->sampler;
+}
+
+static void sampler_entry_destroy(sampler_entry_vk* entry) {
+    deletion_queue_push(DELETION_TYPE_SAMPLER, (uint64_t)entry->sampler, VK_NULL_HANDLE);
+
+    HASH_DELETE(hh, s_samplers, entry);
+    HASH_DELETE(hh_sampler, s_samplers_by_sampler, entry);
+    mx_free(mx_default_allocator(), entry);
+}
+
+static void sampler_release(VkSampler sampler) {
+    sampler_entry_vk* entry;
+    HASH_FIND(hh_sampler, s_samplers_by_sampler, &sampler, sizeof(VkSampler), entry);
+    MX_ASSERT(entry != NULL, "[Sampler] Releasing an unknown sampler!");
+
+    if (--entry->ref_count == 0) {
+        sampler_entry_destroy(entry);
+    }
+}
+
+// Repeating, trilinear when linear filtered.
+static mgfx_sampler_info texture_sampler_info(uint32_t filter) {
+    return (mgfx_sampler_info){
+        .filter = filter,
+        .mipmap_mode = filter == VK_FILTER_LINEAR ? VK_SAMPLER_MIPMAP_MODE_LINEAR
+                                                  : VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .border_color = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+    };
+}
+
+static void texture_descriptor_write(descriptor_info_vk* descriptor, const mgfx_texture* texture) {
+    if (descriptor->image_info.imageView != (VkImageView)texture->view ||
+        descriptor->image_info.sampler != (VkSampler)texture->sampler) {
+        descriptor->version++;
+    }
+
+    descriptor->image_info.imageView = (VkImageView)texture->view;
+    descriptor->image_info.sampler = (VkSampler)texture->sampler;
+    descriptor->image_info.imageLayout =
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // Expected layout
+
+    descriptor->image = image_get(texture->imgh);
+}
+
+mgfx_th mgfx_texture_create_from_memory(const mgfx_image_info* info,
+                                        uint32_t filter,
+                                        void* data,
+                                        size_t len) {
+    return mgfx_texture_create_from_memory_ex(
+        info, filter, data, len, MGFX_UPLOAD_PRIORITY_IMMEDIATE, NULL);
+}
+
+mgfx_th mgfx_texture_create_from_memory_ex(const mgfx_image_info* info,
+                                           uint32_t filter,
+                                           void* data,
+                                           size_t len,
+                                           uint32_t priority,
+                                           mgfx_uploadh* upload) {
+    mgfx_texture* texture;
+    const mgfx_th th = {.idx = handle_pool_alloc(&s_textures, (void**)&texture)};
+    if (th.idx == 0) {
+        if (upload) {
+            *upload = (mgfx_uploadh){0};
+        }
+        return th;
+    }
+
+    texture->imgh =
+        mgfx_image_create(info, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    if (texture->imgh.idx == 0) {
+        handle_pool_free(&s_textures, th.idx);
+        if (upload) {
+            *upload = (mgfx_uploadh){0};
+        }
+        return (mgfx_th){0};
+    }
+
+    image_vk* image = image_get(texture->imgh);
+
+    const uint64_t upload_idx = image_update(data, len, image, 0, priority);
+    if (upload) {
+        *upload = (mgfx_uploadh){.idx = upload_idx};
+    }
+
+    const mgfx_sampler_info sampler_info = texture_sampler_info(filter);
+    texture->sampler = (uint64_t)sampler_acquire(&sampler_info);
+    texture->view =
+        (uint64_t)image_view_acquire(image, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+    bindless_write_push(th.idx, MGFX_BINDLESS_TEXTURE_BINDING);
+
+    return th;
+};
+
+mgfx_th mgfx_texture_create_from_image(mgfx_imgh img, const uint32_t filter) {
+    mgfx_texture* texture;
+    const mgfx_th th = {.idx = handle_pool_alloc(&s_textures, (void**)&texture)};
+    if (th.idx == 0) {
+        return th;
+    }
+
+    texture->imgh = img;
+    image_vk* image = image_get(img);
+
+    // Render targets are clamped, shadow lookups outside the map read the border.
+    const mgfx_sampler_info sampler_info = {
+        .filter = filter,
+        .mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .address_mode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+        .border_color = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+    };
+    texture->sampler = (uint64_t)sampler_acquire(&sampler_info);
+
+    // TODO: Make aspect argument
+    const VkImageAspectFlags aspect = image->format == VK_FORMAT_D32_SFLOAT
+                                          ? VK_IMAGE_ASPECT_DEPTH_BIT
+                                          : VK_IMAGE_ASPECT_COLOR_BIT;
+    texture->view = (uint64_t)image_view_acquire(image, VK_IMAGE_VIEW_TYPE_2D, aspect);
+    bindless_write_push(th.idx, MGFX_BINDLESS_TEXTURE_BINDING);
+
+    return th;
+}
+
+// Async loads are decoded by a background task and uploaded through the staging path with
+// streaming priority. Their texture samples the placeholder until the upload completed, then
+// descriptors bound to it are pointed at the loaded image and the cached sets using them rebuilt.
+enum { MGFX_TEXTURE_MAX_LEVELS = 16 };
+
+typedef struct texture_load_vk {
+    char path[256];
+    uint32_t format;  // VkFormat, replaced by the format stored in ktx2 files.
+    uint64_t texture; // s_textures, stale once the texture was destroyed.
+
+    // Written by the decode task before it sets `decoded`.
+    uint8_t* pixels; // Levels of ktx2 files, or decoded rgba8.
+    mx_bool ktx2;
+    int width;
+    int height;
+    uint32_t level_count; // Levels held by `pixels`, 0 generates the chain from level 0.
+    size_t level_offsets[MGFX_TEXTURE_MAX_LEVELS];
+    size_t level_sizes[MGFX_TEXTURE_MAX_LEVELS];
+    volatile uint32_t decoded;
+
+    mgfx_imgh imgh;
+    uint64_t upload; // s_uploads of the last level.
+} texture_load_vk;
+
+static draw_stream s_texture_loads = {.stride = sizeof(texture_load_vk*)};
+
+#ifdef MGFX_BASISU
+// Basis payloads keep the channel count of the requested format and are transcoded to bc7
+// otherwise, or to rgba8 on devices without block compression.
+static uint32_t texture_load_basis_target(uint32_t requested, mx_bool srgb, VkFormat* format) {
+    if (!s_texture_compression_bc) {
+        *format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        return BASIS_TARGET_RGBA8;
+    }
+
+    switch (requested) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            *format = VK_FORMAT_BC4_UNORM_BLOCK;
+            return BASIS_TARGET_BC4;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            *format = VK_FORMAT_BC5_UNORM_BLOCK;
+            return BASIS_TARGET_BC5;
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            *format = srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+            return BASIS_TARGET_BC1;
+        default:
+            *format = srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+            return BASIS_TARGET_BC7;
+    }
+}
+#endif
+
+// Transcodes every level of a ktx2 file holding etc1s or uastc data on the decode task.
+static mx_bool texture_load_basis(texture_load_vk* load, const uint8_t* data, size_t size) {
+#ifdef MGFX_BASISU
+    basis_ktx2_info info;
+    basis_ktx2* ktx2 = basis_ktx2_open(data, size, &info);
+    if (ktx2 == NULL || info.level_count > MGFX_TEXTURE_MAX_LEVELS) {
+        MX_LOG_ERROR("[Texture] %s: Invalid basis ktx2 file!", load->path);
+        basis_ktx2_close(ktx2);
+        return MX_FALSE;
+    }
+
+    VkFormat format;
+    const uint32_t target = texture_load_basis_target(load->format, info.srgb, &format);
+    const uint32_t block_extent = vk_format_block_extent(format);
+    const uint32_t block_size = vk_format_size(format);
+
+    size_t total = 0;
+    for (uint32_t level = 0; level < info.level_count; level++) {
+        const uint32_t width = info.width >> level > 0 ? info.width >> level : 1;
+        const uint32_t height = info.height >> level > 0 ? info.height >> level : 1;
+
+        load->level_offsets[level] = total;
+        load->level_sizes[level] = (size_t)((width + block_extent - 1) / block_extent) *
+                                   ((height + block_extent - 1) / block_extent) * block_size;
+        total += load->level_sizes[level];
+    }
+
+    uint8_t* levels = mx_alloc(mx_default_allocator(), total);
+    for (uint32_t level = 0; level < info.level_count; level++) {
+        if (!basis_ktx2_transcode(ktx2,
+                                  level,
+                                  target,
+                                  levels + load->level_offsets[level],
+                                  (uint32_t)(load->level_sizes[level] / block_size))) {
+            MX_LOG_ERROR("[Texture] %s: Failed to transcode level %u!", load->path, level);
+            mx_free(mx_default_allocator(), levels);
+            basis_ktx2_close(ktx2);
+            return MX_FALSE;
+        }
+    }
+    basis_ktx2_close(ktx2);
+
+    // A single uncompressed level still gets its chain generated.
+    load->pixels = levels;
+    load->format = format;
+    load->width = (int)info.width;
+    load->height = (int)info.height;
+    load->level_count = block_extent == 1 && info.level_count == 1 ? 0 : info.level_count;
+    return MX_TRUE;
+#else
+    MX_LOG_ERROR("[Texture] %s: Basis ktx2 files need mgfx built with MGFX_BASISU!", load->path);
+    return MX_FALSE;
+#endif
+}
+
+// Reads the level index of a 2d ktx2 file, the file contents become the level data. Basis
+// payloads are transcoded instead. Takes ownership of `data` on success.
+static mx_bool texture_load_ktx2(texture_load_vk* load, uint8_t* data, size_t size) {
+    ktx2_header header;
+    if (size < sizeof(ktx2_header)) {
+        MX_LOG_ERROR("[Texture] %s: Truncated ktx2 header!", load->path);
+        return MX_FALSE;
+    }
+    memcpy(&header, data, sizeof(ktx2_header));
+
+    if (header.vk_format == VK_FORMAT_UNDEFINED) {
+        if (!texture_load_basis(load, data, size)) {
+            return MX_FALSE;
+        }
+
+        mx_free(mx_default_allocator(), data);
+        return MX_TRUE;
+    }
+
+    if (header.supercompression_scheme != 0) {
+        MX_LOG_ERROR("[Texture] %s: Supercompressed ktx2 is unsupported!", load->path);
+        return MX_FALSE;
+    }
+
+    if (header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1) {
+        MX_LOG_ERROR("[Texture] %s: Only 2d ktx2 textures are supported!", load->path);
+        return MX_FALSE;
+    }
+
+    const VkFormat format = (VkFormat)header.vk_format;
+    const uint32_t block_extent = vk_format_block_extent(format);
+    const uint32_t block_size = vk_format_size(format);
+    if (block_size == 0 || (block_extent > 1 && !s_texture_compression_bc)) {
+        MX_LOG_ERROR("[Texture] %s: Format %u is unsupported!", load->path, header.vk_format);
+        return MX_FALSE;
+    }
+
+    const uint32_t level_count = header.level_count > 0 ? header.level_count : 1;
+    if (level_count > MGFX_TEXTURE_MAX_LEVELS ||
+        size < sizeof(ktx2_header) + level_count * sizeof(ktx2_level)) {
+        MX_LOG_ERROR("[Texture] %s: Invalid ktx2 level index!", load->path);
+        return MX_FALSE;
+    }
+
+    for (uint32_t level = 0; level < level_count; level++) {
+        ktx2_level entry;
+        memcpy(&entry,
+               data + sizeof(ktx2_header) + level * sizeof(ktx2_level),
+               sizeof(ktx2_level));
+
+        const uint32_t width = header.pixel_width >> level > 0 ? header.pixel_width >> level : 1;
+        const uint32_t height = header.pixel_height >> level > 0 ? header.pixel_height >> level : 1;
+        const uint64_t expected = (uint64_t)((width + block_extent - 1) / block_extent) *
+                                  ((height + block_extent - 1) / block_extent) * block_size;
+
+        if (entry.byte_length != expected || entry.byte_offset > size ||
+            entry.byte_length > size - entry.byte_offset) {
+            MX_LOG_ERROR("[Texture] %s: Invalid ktx2 level %u!", load->path, level);
+            return MX_FALSE;
+        }
+
+        load->level_offsets[level] = (size_t)entry.byte_offset;
+        load->level_sizes[level] = (size_t)entry.byte_length;
+    }
+
+    load->pixels = data;
+    load->format = header.vk_format;
+    load->width = (int)header.pixel_width;
+    load->height = (int)header.pixel_height;
+    load->level_count = header.level_count;
+    return MX_TRUE;
+}
+
+static void texture_load_decode(void* ctx) {
+    texture_load_vk* load = ctx;
+
+    size_t size = 0;
+    if (mx_read_file(load->path, &size, NULL) == MX_SUCCESS) {
+        uint8_t* data = mx_alloc(mx_default_allocator(), size);
+        mx_read_file(load->path, &size, data);
+
+        const uint8_t identifier[KTX2_IDENTIFIER_SIZE] = KTX2_IDENTIFIER;
+        if (size >= KTX2_IDENTIFIER_SIZE &&
+            memcmp(data, identifier, KTX2_IDENTIFIER_SIZE) == 0) {
+            if (texture_load_ktx2(load, data, size)) {
+                load->ktx2 = MX_TRUE;
+                data = NULL;
+            }
+        } else {
+            int channel_count;
+            load->pixels = stbi_load_from_memory(
+                data, (int)size, &load->width, &load->height, &channel_count, 4);
+            load->level_sizes[0] = (size_t)load->width * load->height * 4;
+        }
+
+        if (data) {
+            mx_free(mx_default_allocator(), data);
+        }
+    }
+
+    jobs_atomic_add(&load->decoded, 1);
+}
+
+static void texture_load_pixels_free(texture_load_vk* load) {
+    if (load->ktx2) {
+        mx_free(mx_default_allocator(), load->pixels);
+    } else {
+        stbi_image_free(load->pixels);
+    }
+
+    load->pixels = NULL;
+}
+
+mgfx_th mgfx_texture_load_async(const char* path,
+                                uint32_t format,
+                                uint32_t filter,
+                                mgfx_th placeholder) {
+    if (placeholder.idx == 0) {
+        placeholder = MGFX_WHITE_TEXTURE;
+    }
+
+    const mgfx_texture* source = texture_get(placeholder);
+    MX_ASSERT(source->load == NULL, "[Texture] Placeholder is still loading!");
+
+    mgfx_texture* texture;
+    const mgfx_th th = {.idx = handle_pool_alloc(&s_textures, (void**)&texture)};
+    if (th.idx == 0) {
+        return th;
+    }
+
+    texture_load_vk* load = mx_alloc(mx_default_allocator(), sizeof(texture_load_vk));
+    memset(load, 0, sizeof(texture_load_vk));
+
+    MX_ASSERT(strlen(path) < sizeof(load->path), "[Texture] Path too long!");
+    strcpy(load->path, path);
+    load->format = format;
+
+    const mgfx_sampler_info sampler_info = texture_sampler_info(filter);
+
+    texture->imgh = source->imgh;
+    texture->view = source->view;
+    texture->sampler = (uint64_t)sampler_acquire(&sampler_info);
+    texture->load = load;
+    texture->placeholder = MX_TRUE;
+    image_view_retain((VkImageView)texture->view);
+    bindless_write_push(th.idx, MGFX_BINDLESS_TEXTURE_BINDING);
+
+    load->texture = th.idx;
+    draw_stream_push(&s_texture_loads, &load, 1);
+
+    jobs_submit(texture_load_decode, load);
+
+    return th;
+}
+
+mx_bool mgfx_texture_ready(mgfx_th th) { return texture_get(th)->load == NULL; }
+
+uint32_t mgfx_texture_bindless_index(mgfx_th th) {
+    MX_ASSERT(s_bindless, "[Bindless] Not enabled, see mgfx_init_info.bindless!");
+    MX_ASSERT(handle_pool_get(&s_textures, th.idx) != NULL, "Texture invalid handle!");
+    return handle_pool_index(th.idx);
+}
+
+uint32_t mgfx_buffer_bindless_index(mgfx_sbh sbh) {
+    MX_ASSERT(s_bindless, "[Bindless] Not enabled, see mgfx_init_info.bindless!");
+    MX_ASSERT(handle_pool_get(&s_buffers, sbh.idx) != NULL, "Buffer invalid handle!");
+    return handle_pool_index(sbh.idx);
+}
+
+// The image is released with the load, an ongoing decode still owns the record.
+static void texture_load_cancel(texture_load_vk* load) {
+    load->texture = 0;
+
+    if (load->imgh.idx != 0) {
+        mgfx_image_destroy(load->imgh);
+        load->imgh = (mgfx_imgh){0};
+    }
+}
+
+// Points descriptors bound to a texture at its current view and sampler, the version bump keeps
+// draws from reusing sets written with the previous ones.
+static void texture_descriptors_rewrite(uint64_t th_idx, const mgfx_texture* texture) {
+    bindless_write_push(th_idx, MGFX_BINDLESS_TEXTURE_BINDING);
+
+    for (uint32_t slot = 0; slot < s_descriptors.count; slot++) {
+        descriptor_info_vk* descriptor =
+            (descriptor_info_vk*)&s_descriptors.values[(size_t)slot * s_descriptors.stride];
+
+        if (descriptor->texture == th_idx) {
+            texture_descriptor_write(descriptor, texture);
+        }
+    }
+}
+
+static void texture_load_swap(texture_load_vk* load, mgfx_texture* texture) {
+    image_view_release((VkImageView)texture->view);
+
+    texture->imgh = load->imgh;
+    texture->view = (uint64_t)image_view_acquire(
+        image_get(load->imgh), VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+    texture->load = NULL;
+    texture->placeholder = MX_FALSE;
+
+    texture_descriptors_rewrite(load->texture, texture);
+}
+
+void mgfx_texture_set_sampler(mgfx_th th, const mgfx_sampler_info* info) {
+    mgfx_texture* texture = texture_get(th);
+
+    // Acquired first so a texture keeping its sampler info never destroys the shared sampler.
+    const VkSampler sampler = sampler_acquire(info);
+    sampler_release((VkSampler)texture->sampler);
+    texture->sampler = (uint64_t)sampler;
+
+    texture_descriptors_rewrite(th.idx, texture);
+}
+
+// Advances a load by one step and returns MX_TRUE once its record can be released.
+static mx_bool texture_load_update(texture_load_vk* load) {
+    if (jobs_atomic_add(&load->decoded, 0) == 0) {
+        return MX_FALSE;
+    }
+
+    mgfx_texture* texture = handle_pool_get(&s_textures, load->texture);
+    if (texture == NULL) {
+        texture_load_pixels_free(load);
+        return MX_TRUE;
+    }
+
+    if (load->imgh.idx == 0) {
+        if (load->pixels == NULL) {
+            MX_LOG_ERROR("[Texture] Failed to load %s, keeping its placeholder!", load->path);
+            texture->load = NULL;
+            return MX_TRUE;
+        }
+
+        const mgfx_image_info info = {
+            .format = load->format,
+            .width = (uint32_t)load->width,
+            .height = (uint32_t)load->height,
+            .layers = 1,
+            .mip_levels = load->level_count > 0 ? load->level_count : MGFX_MIP_LEVELS_AUTO,
+            .cube_map = MX_FALSE,
+        };
+
+        load->imgh =
+            mgfx_image_create(&info, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+        if (load->imgh.idx == 0) {
+            MX_LOG_ERROR("[Texture] No image left for %s, keeping its placeholder!", load->path);
+            texture_load_pixels_free(load);
+            texture->load = NULL;
+            return MX_TRUE;
+        }
+
+        image_vk* image = image_get(load->imgh);
+        if (load->level_count > 1) {
+            image->generate_mips = MX_FALSE;
+        }
+
+        // Levels are staged in order, the last one completing means all of them have.
+        const uint32_t level_count = load->level_count < image->mip_levels ? load->level_count
+                                                                            : image->mip_levels;
+        for (uint32_t level = 0; level < (level_count > 0 ? level_count : 1); level++) {
+            load->upload = image_update(load->pixels + load->level_offsets[level],
+                                        load->level_sizes[level],
+                                        image,
+                                        level,
+                                        MGFX_UPLOAD_PRIORITY_STREAMING);
+        }
+
+        texture_load_pixels_free(load);
+    }
+
+    if (handle_pool_get(&s_uploads, load->upload) != NULL) {
+        return MX_FALSE;
+    }
+
+    texture_load_swap(load, texture);
+    return MX_TRUE;
+}
+
+static void texture_loads_process() {
+    texture_load_vk** loads = (texture_load_vk**)s_texture_loads.data;
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < s_texture_loads.count; i++) {
+        if (!texture_load_update(loads[i])) {
+            loads[count++] = loads[i];
+            continue;
+        }
+
+        mx_free(mx_default_allocator(), loads[i]);
+    }
+    s_texture_loads.count = count;
+}
+
+// Waits for running decodes, loads still pending are dropped.
+static void texture_loads_destroy() {
+    jobs_wait();
+
+    texture_load_vk** loads = (texture_load_vk**)s_texture_loads.data;
+    for (uint32_t i = 0; i < s_texture_loads.count; i++) {
+        texture_load_cancel(loads[i]);
+        texture_load_pixels_free(loads[i]);
+        mx_free(mx_default_allocator(), loads[i]);
+    }
+
+    draw_stream_destroy(&s_texture_loads);
+}
+
+void mgfx_texture_destroy(mgfx_th th, mx_bool release_image) {
+    mgfx_texture* texture = texture_get(th);
+
+    // TODO: Move to texture_destroy
+    sampler_release((VkSampler)texture->sampler);
+    image_view_release((VkImageView)texture->view);
+
+    if (texture->load) {
+        texture_load_cancel(texture->load);
+    }
+
+    if (!texture->placeholder && release_image) {
+        mgfx_image_destroy(texture->imgh);
+    }
+
+    handle_pool_free(&s_textures, th.idx);
+}
+
+mgfx_dh mgfx_descriptor_create(const char* name, uint32_t type) {
+    descriptor_info_vk* descriptor;
+    const mgfx_dh dh = {.idx = handle_pool_alloc(&s_descriptors, (void**)&descriptor)};
+    if (dh.idx == 0) {
+        return dh;
+    }
+
+    descriptor->type = type;
+
+    // Dynamic uniform descriptors always cover the transient uniform buffer.
+    if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+        descriptor->buffer_info = (VkDescriptorBufferInfo){
+            .buffer = s_tub_buffer.handle,
+            .offset = 0,
+            .range = MGFX_TRANSIENT_UNIFORM_RANGE,
+        };
+        descriptor->buffer = &s_tub_buffer;
+    }
+
+    MX_ASSERT(strlen(name) <= sizeof(descriptor->name));
+    strcpy(descriptor->name, name);
+
+    return dh;
+}
+
+static descriptor_info_vk* descriptor_get(mgfx_dh dh) {
+    descriptor_info_vk* descriptor = handle_pool_get(&s_descriptors, dh.idx);
+    MX_ASSERT(descriptor != NULL, "Descriptor invalid handle!");
+
+    return descriptor;
+}
+
+void mgfx_set_buffer(mgfx_dh dh, mgfx_ubh ubh) {
+    descriptor_info_vk* descriptor = descriptor_get(dh);
+    buffer_vk* buffer = buffer_get(ubh.idx);
+
+    if (descriptor->buffer_info.buffer != buffer->handle) {
+        descriptor->version++;
+    }
+
+    descriptor->buffer_info.buffer = buffer->handle;
+    descriptor->buffer_info.offset = 0;
+    descriptor->buffer_info.range = VK_WHOLE_SIZE;
+
+    descriptor->buffer = buffer;
+}
+
+void mgfx_set_storage_buffer(mgfx_dh dh, mgfx_sbh sbh) {
+    mgfx_set_buffer(dh, (mgfx_ubh){.idx = sbh.idx});
+}
+
+void mgfx_set_texture(mgfx_dh dh, mgfx_th th) {
+    descriptor_info_vk* descriptor = descriptor_get(dh);
+
+    texture_descriptor_write(descriptor, texture_get(th));
+    descriptor->texture = th.idx;
+}
+
+void mgfx_descriptor_destroy(mgfx_dh dh) { handle_pool_free(&s_descriptors, dh.idx); }
+
+mgfx_fbh mgfx_framebuffer_create(mgfx_imgh* color_attachments,
+                                 uint32_t color_attachment_count,
+                                 mgfx_imgh depth_attachment) {
+    // TODO: Framebuffer should be an api agonstic concept.
+    framebuffer_vk* fb;
+    const mgfx_fbh fbh = {.idx = handle_pool_alloc(&s_framebuffers, (void**)&fb)};
+    if (fbh.idx == 0) {
+        return fbh;
+    }
+
+    fb->color_attachment_count = color_attachment_count;
+    for (uint32_t i = 0; i < color_attachment_count; i++) {
+        fb->color_attachments[i] = image_get(color_attachments[i]);
+        fb->color_attachment_views[i] = image_view_acquire(
+            fb->color_attachments[i], VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+
+    // A zero depth handle leaves the framebuffer without depth.
+    fb->depth_attachment = handle_pool_get(&s_images, depth_attachment.idx);
+    if (fb->depth_attachment) {
+        fb->depth_attachment_view = image_view_acquire(
+            fb->depth_attachment, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_DEPTH_BIT);
+    }
+
+    return fbh;
+}
+
+void mgfx_framebuffer_destroy(mgfx_fbh fbh) {
+    framebuffer_vk* fb = handle_pool_get(&s_framebuffers, fbh.idx);
+
+    if (!fb) {
+        MX_LOG_WARN("Attempting to destroy invalid framebuffer handle!");
+        return;
+    }
+
+    framebuffer_destroy(fb);
+    handle_pool_free(&s_framebuffers, fbh.idx);
+}
+
+mgfx_encoder* mgfx_encoder_begin() {
+    const uint32_t idx = jobs_atomic_add(&s_encoder_count, 1);
+    MX_ASSERT(idx < MGFX_MAX_ENCODERS, "[Encoder] Encoder limit reached!");
+
+    mgfx_encoder* enc = &s_encoders[idx];
+    encoder_reset(enc);
+    enc->recording = MX_TRUE;
+
+    return enc;
+}
+
+void mgfx_encoder_end(mgfx_encoder* enc) { enc->recording = MX_FALSE; }
+
+void mgfx_encoder_bind_vertex_buffer(mgfx_encoder* enc, mgfx_vbh vbh) {
+    MX_ASSERT(enc->state.vb_count < MGFX_SHADER_MAX_VERTEX_BINDING);
+
+    enc->state.vbs[enc->state.vb_count++] = (mgfx_transient_buffer){
+        .size = 0,
+        .offset = 0,
+        .buffer_handle = (mx_ptr_t)buffer_get(vbh.idx)->handle,
+    };
+}
+
+void mgfx_encoder_bind_transient_vertex_buffer(mgfx_encoder* enc, mgfx_transient_buffer tb) {
+    MX_ASSERT(enc->state.vb_count < MGFX_SHADER_MAX_VERTEX_BINDING);
+
+    enc->state.vbs[enc->state.vb_count++] = tb;
+}
+
+void mgfx_encoder_bind_transient_instance_buffer(mgfx_encoder* enc, mgfx_transient_buffer tb) {
+    MX_ASSERT(enc->state.vb_count == MGFX_SHADER_INSTANCE_BINDING,
+              "Instance buffers must be bound after the vertex buffer!");
+
+    enc->state.vbs[enc->state.vb_count++] = tb;
+}
+
+void mgfx_encoder_bind_instance_buffer(mgfx_encoder* enc, mgfx_instbh instbh) {
+    const mgfx_transient_buffer tb = {
+        .size = 0,
+        .offset = 0,
+        .buffer_handle = (mx_ptr_t)buffer_get(instbh.idx)->handle,
+    };
+
+    mgfx_encoder_bind_transient_instance_buffer(enc, tb);
+}
+
+void mgfx_encoder_bind_index_buffer(mgfx_encoder* enc, mgfx_ibh ibh) {
+    MX_ASSERT(handle_pool_get(&s_buffers, ibh.idx) != NULL, "Buffer invalid handle!");
+
+    // Resolved when the frame is prepared, the index count is read from the allocation.
+    enc->state.ib = (mgfx_transient_buffer){
+        .size = 0,
+        .offset = 0,
+        .buffer_handle = (mx_ptr_t)ibh.idx,
+    };
+}
+
+void mgfx_encoder_bind_transient_index_buffer(mgfx_encoder* enc, mgfx_transient_buffer tib) {
+    enc->state.ib = tib;
+}
+
+void mgfx_encoder_bind_descriptor(mgfx_encoder* enc, uint32_t ds_idx, mgfx_dh dh) {
+    MX_ASSERT(ds_idx < MGFX_SHADER_MAX_DESCRIPTOR_SET);
+
+    uint32_t descriptor_idx = enc->state.dh_counts[ds_idx];
+    MX_ASSERT(descriptor_idx < MGFX_SHADER_MAX_DESCRIPTOR_BINDING);
+
+    enc->state.dhs[ds_idx][descriptor_idx] = dh;
+    enc->state.dh_hashes[ds_idx] = descriptor_hash_step(enc->state.dh_hashes[ds_idx], dh.idx);
+    ++enc->state.dh_counts[ds_idx];
+}
+
+void mgfx_encoder_bind_transient_uniform_buffer(mgfx_encoder* enc,
+                                                uint32_t ds_idx,
+                                                mgfx_dh dh,
+                                                mgfx_transient_buffer tb) {
+    MX_ASSERT(ds_idx < MGFX_SHADER_MAX_DESCRIPTOR_SET);
+    MX_ASSERT(descriptor_get(dh)->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+              "[TransientUniform] Descriptor must be VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC!");
+    MX_ASSERT(enc->state.dynamic_offset_count < MGFX_SHADER_MAX_DYNAMIC_OFFSETS,
+              "[TransientUniform] Dynamic offset limit reached!");
+
+    const uint32_t descriptor_idx = enc->state.dh_counts[ds_idx];
+    mgfx_encoder_bind_descriptor(enc, ds_idx, dh);
+
+    enc->state.dh_dynamic_offsets[ds_idx][descriptor_idx] = tb.offset;
+    enc->state.dh_dynamic_masks[ds_idx] |= (uint8_t)(1u << descriptor_idx);
+    ++enc->state.dynamic_offset_count;
+}
+
+void mgfx_encoder_set_transform(mgfx_encoder* enc, const float* mtx) {
+    memcpy(enc->transform, mtx, sizeof(float) * 16);
+}
+
+void mgfx_encoder_set_bindless_indices(mgfx_encoder* enc, const uint32_t* indices) {
+    memcpy(enc->bindless_indices, indices, sizeof(enc->bindless_indices));
+}
+
+// Records the bound state as one draw. Indirect draws take their arguments from `indirect`.
+static void encoder_submit(mgfx_encoder* enc,
+                           uint8_t target,
+                           mgfx_ph ph,
+                           uint32_t instance_count,
+                           const mgfx_draw_indirect* indirect) {
+    const mgfx_program* program = program_get(ph);
+
+    mgfx_draw_arena* arena = &enc->arena;
+    mgfx_draw_state* state = &enc->state;
+
+    mgfx_draw draw = {
+        .ph = ph,
+        .ib = state->ib,
+        .transform = draw_stream_push(&arena->matrices, enc->transform, 1),
+        .descriptors = arena->descriptors.count,
+        .dynamic_offsets = arena->dynamic_offsets.count,
+        .vertex_buffers = draw_stream_push(&arena->vertex_buffers, state->vbs, state->vb_count),
+        .instance_count = instance_count,
+        .vertex_buffer_count = state->vb_count,
+        .view_target = target,
+    };
+
+    if (indirect) {
+        draw.indirect = draw_stream_push(&arena->indirects, indirect, 1);
+        draw.indirect_draw = MX_TRUE;
+    }
+
+    if (program->bindless) {
+        draw.bindless_indices =
+            draw_stream_push(&arena->bindless_indices, enc->bindless_indices, 1);
+    }
+
+    uint32_t descriptor_hash = 0;
+    for (uint32_t ds_idx = 0; ds_idx < MGFX_SHADER_MAX_DESCRIPTOR_SET; ds_idx++) {
+        const uint8_t dh_count = state->dh_counts[ds_idx];
+        draw.descriptor_counts[ds_idx] = dh_count;
+        draw_stream_push(&arena->descriptors, state->dhs[ds_idx], dh_count);
+
+        // Offsets are pushed in binding order, as vkCmdBindDescriptorSets consumes them.
+        for (uint32_t dh_idx = 0; dh_idx < dh_count; dh_idx++) {
+            if (state->dh_dynamic_masks[ds_idx] & (1u << dh_idx)) {
+                draw_stream_push(
+                    &arena->dynamic_offsets, &state->dh_dynamic_offsets[ds_idx][dh_idx], 1);
+                draw.dynamic_offset_counts[ds_idx]++;
+            }
+        }
+
+        if (dh_count > 0) {
+            draw.descriptor_hashes[ds_idx] = state->dh_hashes[ds_idx];
+            descriptor_hash =
+                descriptor_hash_step(descriptor_hash ^ ds_idx, state->dh_hashes[ds_idx]);
+        }
+    }
+
+    // View space depth of the transform origin, cameras look down -z.
+    const float* v = s_view_blocks[target].view;
+    const float* m = enc->transform;
+    const float view_depth = -(v[2] * m[12] + v[6] * m[13] + v[10] * m[14] + v[14]);
+
+    mgfx_draw_key key = {
+        .sort_key = draw_sort_key(target,
+                                  program->blend,
+                                  program->id,
+                                  descriptor_hash,
+                                  draw_depth_quantize(view_depth)),
+        .draw_idx = draw_stream_push(&arena->draws, &draw, 1),
+        .encoder = enc->idx,
+    };
+    draw_stream_push(&arena->keys, &key, 1);
+
+    memset(state->dh_counts, 0, sizeof(state->dh_counts));
+    memset(state->dh_hashes, 0, sizeof(state->dh_hashes));
+    memset(state->dh_dynamic_masks, 0, sizeof(state->dh_dynamic_masks));
+    state->dynamic_offset_count = 0;
+    state->vb_count = 0;
+    state->ib = (mgfx_transient_buffer){0};
+}
+
+void mgfx_encoder_submit(mgfx_encoder* enc, uint8_t target, mgfx_ph ph) {
+    encoder_submit(enc, target, ph, 1, NULL);
+}
+
+void mgfx_encoder_submit_instanced(mgfx_encoder* enc,
+                                   uint8_t target,
+                                   mgfx_ph ph,
+                                   uint32_t instance_count) {
+    encoder_submit(enc, target, ph, instance_count, NULL);
+}
+
+void mgfx_encoder_submit_indirect(mgfx_encoder* enc,
+                                  uint8_t target,
+                                  mgfx_ph ph,
+                                  mgfx_indbh indbh,
+                                  uint32_t offset,
+                                  uint32_t draw_count,
+                                  uint32_t stride) {
+    const mgfx_draw_indirect indirect = {
+        .buffer = indbh,
+        .offset = offset,
+        .max_draw_count = draw_count,
+        .stride = stride,
+    };
+
+    encoder_submit(enc, target, ph, 0, &indirect);
+}
+
+void mgfx_encoder_submit_indirect_count(mgfx_encoder* enc,
+                                        uint8_t target,
+                                        mgfx_ph ph,
+                                        mgfx_indbh indbh,
+                                        uint32_t offset,
+                                        mgfx_indbh count_bh,
+                                        uint32_t count_offset,
+                                        uint32_t max_draw_count,
+                                        uint32_t stride) {
+    MX_ASSERT(s_draw_indirect_count, "Draw indirect count is not supported by the device!");
+
+    const mgfx_draw_indirect indirect = {
+        .buffer = indbh,
+        .count_buffer = count_bh,
+        .offset = offset,
+        .count_offset = count_offset,
+        .max_draw_count = max_draw_count,
+        .stride = stride,
+    };
+
+    encoder_submit(enc, target, ph, 0, &indirect);
+}
+
+void mgfx_bind_vertex_buffer(mgfx_vbh vbh) { mgfx_encoder_bind_vertex_buffer(&s_encoders[0], vbh); }
+
+void mgfx_bind_transient_vertex_buffer(mgfx_transient_buffer tb) {
+    mgfx_encoder_bind_transient_vertex_buffer(&s_encoders[0], tb);
+}
 
-    const char* validationLayers = {"VK_LAYER_KHRONOS_validation"};
+void mgfx_bind_instance_buffer(mgfx_instbh instbh) {
+    mgfx_encoder_bind_instance_buffer(&s_encoders[0], instbh);
+}
 
-    for (uint32_t i = 0; i < layer_prop_count; i++) {
-        if (strcmp(validationLayers, layer_props[i].layerName) == 0) {
-            MX_LOG_WARN("Validation layers enabled");
-            instance_info.enabledLayerCount = 1;
-            instance_info.ppEnabledLayerNames = &validationLayers;
-            break;
-        }
-    }
-#endif
+void mgfx_bind_transient_instance_buffer(mgfx_transient_buffer tb) {
+    mgfx_encoder_bind_transient_instance_buffer(&s_encoders[0], tb);
+}
 
-    VK_CHECK(vkCreateInstance(&instance_info, NULL, &s_instance));
+void mgfx_bind_index_buffer(mgfx_ibh ibh) { mgfx_encoder_bind_index_buffer(&s_encoders[0], ibh); }
 
-    // Extension functions.
-    vk_cmd_begin_rendering_khr =
-        (PFN_vkCmdBeginRenderingKHR)vkGetInstanceProcAddr(s_instance, "vkCmdBeginRenderingKHR");
-    vk_cmd_end_rendering_khr =
-        (PFN_vkCmdEndRenderingKHR)vkGetInstanceProcAddr(s_instance, "vkCmdEndRenderingKHR");
+void mgfx_bind_transient_index_buffer(mgfx_transient_buffer tib) {
+    mgfx_encoder_bind_transient_index_buffer(&s_encoders[0], tib);
+}
 
-#ifdef MX_DEBUG
-    VkDebugUtilsMessengerCreateInfoEXT debug_messenger_info = {0};
-    debug_messenger_info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-    debug_messenger_info.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
-                                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
-                                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-    debug_messenger_info.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
-                                       VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
-                                       VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-    debug_messenger_info.pfnUserCallback = vk_debug_callback;
-    debug_messenger_info.pUserData = NULL;
+void mgfx_bind_descriptor(uint32_t ds_idx, mgfx_dh dh) {
+    mgfx_encoder_bind_descriptor(&s_encoders[0], ds_idx, dh);
+}
 
-    create_debug_util_messenger_ext(s_instance, &debug_messenger_info, NULL, &s_debug_messenger);
-#endif
-    if (choose_physical_device_vk(s_instance,
-                                  k_req_device_ext_count,
-                                  k_req_device_ext_names,
-                                  &s_phys_device_props,
-                                  &s_phys_device,
-                                  tmp) != VK_SUCCESS) {
-        MX_LOG_ERROR("Failed to find suitable physical device!");
-        return -1;
-    }
+void mgfx_bind_transient_uniform_buffer(uint32_t ds_idx, mgfx_dh dh, mgfx_transient_buffer tb) {
+    mgfx_encoder_bind_transient_uniform_buffer(&s_encoders[0], ds_idx, dh, tb);
+}
 
-    VK_CHECK(get_window_surface_vk(s_instance, info->nwh, &s_surface));
+void mgfx_set_view_clear(uint8_t target, float* color_4) {
+    MX_ASSERT(
+        target <= 0xFF,
+        "Attemping to set clear color for unknown target. Please call mgfx_set_view_target first");
+    memcpy(s_view_clears[target].float32, color_4, sizeof(float) * 4);
+}
 
-    uint32_t queue_family_props_count = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(s_phys_device, &queue_family_props_count, NULL);
-    VkQueueFamilyProperties* queue_family_props =
-        mx_alloc(tmp, sizeof(VkQueueFamilyProperties) * queue_family_props_count);
+void mgfx_set_view_target(uint8_t target, mgfx_fbh fb) { s_view_targets[target] = fb; }
 
-    vkGetPhysicalDeviceQueueFamilyProperties(
-        s_phys_device, &queue_family_props_count, queue_family_props);
+void mgfx_set_transform(const float* mtx) { mgfx_encoder_set_transform(&s_encoders[0], mtx); }
 
-    int unique_queue_count = 0;
-    for (uint32_t i = 0; i < queue_family_props_count; i++) {
-        if ((queue_family_props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) == VK_QUEUE_GRAPHICS_BIT) {
-            s_queue_indices[MGFX_QUEUE_GRAPHICS] = i;
-        }
+void mgfx_set_bindless_indices(const uint32_t* indices) {
+    mgfx_encoder_set_bindless_indices(&s_encoders[0], indices);
+}
 
-        VkBool32 present_supported = VK_FALSE;
-        vkGetPhysicalDeviceSurfaceSupportKHR(s_phys_device, i, s_surface, &present_supported);
-        if (present_supported == VK_TRUE) {
-            s_queue_indices[MGFX_QUEUE_PRESENT] = i;
-        }
+void mgfx_set_view_transform(uint8_t target, const float* view, const float* proj) {
+    view_block_vk* block = &s_view_blocks[target];
 
-        ++unique_queue_count;
+    memcpy(block->view, view, sizeof(block->view));
+    memcpy(block->proj, proj, sizeof(block->proj));
 
-        // Check if complete.
-        int complete = MGFX_SUCCESS;
-        for (uint16_t j = 0; j < unique_queue_count; j++) {
-            if (s_queue_indices[MGFX_QUEUE_PRESENT] == -1) {
-                complete = !MGFX_SUCCESS;
-            }
-        }
+    mx_mat4 view_mtx, proj_mtx;
+    memcpy(view_mtx.val, view, sizeof(view_mtx.val));
+    memcpy(proj_mtx.val, proj, sizeof(proj_mtx.val));
+    memcpy(block->view_proj, mx_mat4_mul(proj_mtx, view_mtx).val, sizeof(block->view_proj));
 
-        if (complete == MGFX_SUCCESS) {
-            break;
+    // Views are rigid, the inverse is the transposed rotation and the rotated negated position.
+    const float* v = view;
+    float* inv = block->view_inv;
+    for (uint32_t row = 0; row < 3; row++) {
+        for (uint32_t col = 0; col < 3; col++) {
+            inv[col * 4 + row] = v[row * 4 + col];
         }
-    }
 
-    for (uint16_t i = 0; i < MGFX_QUEUE_COUNT; i++) {
-        if (s_queue_indices[MGFX_QUEUE_PRESENT] == -1) {
-            MX_LOG_ERROR("Failed to find graphics queue!");
-            break;
-        }
+        inv[row * 4 + 3] = 0.0f;
+        inv[12 + row] =
+            -(v[row * 4 + 0] * v[12] + v[row * 4 + 1] * v[13] + v[row * 4 + 2] * v[14]);
     }
+    inv[15] = 1.0f;
+}
 
-    float queue_priority = 1.0f;
-    VkDeviceQueueCreateInfo queue_infos[MGFX_QUEUE_COUNT] = {0};
-    for (uint16_t i = 0; i < unique_queue_count; i++) {
-        queue_infos[i].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queue_infos[i].pNext = NULL;
-        queue_infos[i].flags = 0;
-        queue_infos[i].queueFamilyIndex = s_queue_indices[i];
-        queue_infos[i].queueCount = 1;
-        queue_infos[i].pQueuePriorities = &queue_priority;
-    }
+void mgfx_set_view(const float* mtx) {
+    float proj[16];
+    memcpy(proj, s_view_blocks[MGFX_DEFAULT_VIEW_TARGET].proj, sizeof(proj));
+    mgfx_set_view_transform(MGFX_DEFAULT_VIEW_TARGET, mtx, proj);
+}
 
-    VkPhysicalDeviceFeatures phys_device_features = {0};
-    phys_device_features.fillModeNonSolid = VK_TRUE;
+void mgfx_set_proj(const float* mtx) {
+    float view[16];
+    memcpy(view, s_view_blocks[MGFX_DEFAULT_VIEW_TARGET].view, sizeof(view));
+    mgfx_set_view_transform(MGFX_DEFAULT_VIEW_TARGET, view, mtx);
+}
 
-    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features = {
-        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
-        .dynamicRendering = VK_TRUE,
-    };
+void mgfx_submit(uint8_t target, mgfx_ph ph) { mgfx_encoder_submit(&s_encoders[0], target, ph); }
 
-    VkDeviceCreateInfo device_info = {
-        .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pNext = &dynamic_rendering_features,
-        .flags = 0,
-        .queueCreateInfoCount = unique_queue_count,
-        .pQueueCreateInfos = queue_infos,
-        .enabledExtensionCount = k_req_device_ext_count,
-        .ppEnabledExtensionNames = k_req_device_ext_names,
-        .pEnabledFeatures = &phys_device_features,
-    };
-    VK_CHECK(vkCreateDevice(s_phys_device, &device_info, NULL, &s_device));
+void mgfx_submit_instanced(uint8_t target, mgfx_ph ph, uint32_t instance_count) {
+    mgfx_encoder_submit_instanced(&s_encoders[0], target, ph, instance_count);
+}
 
-    for (uint16_t i = 0; i < unique_queue_count; i++) {
-        vkGetDeviceQueue(s_device, s_queue_indices[i], 0, &s_queues[i]);
-    }
+void mgfx_submit_indirect(uint8_t target,
+                          mgfx_ph ph,
+                          mgfx_indbh indbh,
+                          uint32_t offset,
+                          uint32_t draw_count,
+                          uint32_t stride) {
+    mgfx_encoder_submit_indirect(&s_encoders[0], target, ph, indbh, offset, draw_count, stride);
+}
 
-#ifdef MX_MACOS
-    PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR;
-#endif
+void mgfx_submit_indirect_count(uint8_t target,
+                                mgfx_ph ph,
+                                mgfx_indbh indbh,
+                                uint32_t offset,
+                                mgfx_indbh count_bh,
+                                uint32_t count_offset,
+                                uint32_t max_draw_count,
+                                uint32_t stride) {
+    mgfx_encoder_submit_indirect_count(&s_encoders[0],
+                                       target,
+                                       ph,
+                                       indbh,
+                                       offset,
+                                       count_bh,
+                                       count_offset,
+                                       max_draw_count,
+                                       stride);
+}
 
-    VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(s_phys_device, s_surface, &s_surface_caps));
+static void cull_objects_prepare(const cull_vk* cull,
+                                 const mgfx_cull_object* src,
+                                 uint32_t first,
+                                 uint32_t count,
+                                 mgfx_cull_object* dst) {
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t object_idx = first + i;
+        MX_ASSERT(src[i].batch == cull->object_batches[object_idx],
+                  "[Cull] Objects can not change batch!");
+
+        dst[i] = src[i];
+        dst[i].batch_first = cull->batch_firsts[src[i].batch];
+        dst[i].command = cull->object_commands[object_idx];
+    }
+}
 
-    uint32_t surface_fmt_count = 0;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(s_phys_device, s_surface, &surface_fmt_count, NULL);
-    VkSurfaceFormatKHR* surface_fmts =
-        mx_alloc(tmp, surface_fmt_count * sizeof(VkSurfaceFormatKHR));
-    vkGetPhysicalDeviceSurfaceFormatsKHR(
-        s_phys_device, s_surface, &surface_fmt_count, surface_fmts);
+mgfx_cullh mgfx_cull_create(const mgfx_cull_object* objects,
+                            uint32_t object_count,
+                            uint32_t batch_count,
+                            uint32_t view_count) {
+    MX_ASSERT(object_count > 0 && batch_count > 0 && view_count > 0);
+    MX_ASSERT(s_draw_indirect_first_instance,
+              "[Cull] Culled draws require the drawIndirectFirstInstance device feature!");
 
-    int surface_format_found = -1;
-    for (uint32_t i = 0; i < surface_fmt_count; i++) {
-        if (surface_fmts[i].format == k_surface_fmt &&
-            surface_fmts[i].colorSpace == k_surface_color_space) {
-            surface_format_found = MGFX_SUCCESS;
-            break;
-        }
+    mx_allocator_t allocator = mx_default_allocator();
+
+    cull_vk* cull;
+    const mgfx_cullh cullh = {.idx = handle_pool_alloc(&s_culls, (void**)&cull)};
+    if (cullh.idx == 0) {
+        return cullh;
     }
 
-    MX_ASSERT(surface_format_found == MGFX_SUCCESS, "Required surface format not found!");
+    cull->object_count = object_count;
+    cull->batch_count = batch_count;
+    cull->view_count = view_count;
+
+    cull->batch_firsts = mx_alloc(allocator, batch_count * sizeof(uint32_t));
+    cull->batch_sizes = mx_alloc(allocator, batch_count * sizeof(uint32_t));
+    cull->object_batches = mx_alloc(allocator, object_count * sizeof(uint32_t));
+    cull->object_commands = mx_alloc(allocator, object_count * sizeof(uint32_t));
+    memset(cull->batch_sizes, 0, batch_count * sizeof(uint32_t));
+
+    // Batches own contiguous command ranges, objects keep a fixed slot for uncompacted culling.
+    for (uint32_t i = 0; i < object_count; i++) {
+        MX_ASSERT(objects[i].batch < batch_count, "[Cull] Object batch out of range!");
+        cull->object_batches[i] = objects[i].batch;
+        cull->object_commands[i] = cull->batch_sizes[objects[i].batch]++;
+    }
 
-    uint32_t present_mode_count = 0;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(s_phys_device, s_surface, &present_mode_count, NULL);
-    VkPresentModeKHR* present_modes = mx_alloc(tmp, surface_fmt_count * sizeof(VkPresentModeKHR));
-    vkGetPhysicalDeviceSurfacePresentModesKHR(
-        s_phys_device, s_surface, &present_mode_count, present_modes);
-    for (uint32_t i = 0; i < present_mode_count; i++) {
+    uint32_t batch_first = 0;
+    for (uint32_t batch = 0; batch < batch_count; batch++) {
+        cull->batch_firsts[batch] = batch_first;
+        batch_first += cull->batch_sizes[batch];
     }
 
-    VkExtent2D swapchain_extent;
-    choose_swapchain_extent_vk(&s_surface_caps, info->nwh, &swapchain_extent);
+    for (uint32_t i = 0; i < object_count; i++) {
+        cull->object_commands[i] += cull->batch_firsts[objects[i].batch];
+    }
 
-    swapchain_create(s_surface, swapchain_extent.width, swapchain_extent.height, &s_swapchain, tmp);
+    const size_t objects_size = object_count * sizeof(mgfx_cull_object);
+    mgfx_cull_object* prepared = mx_alloc(allocator, objects_size);
+    cull_objects_prepare(cull, objects, 0, object_count, prepared);
 
-    VmaAllocatorCreateInfo allocator_info = {
-        .instance = s_instance, .physicalDevice = s_phys_device, .device = s_device,
-        /*.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,*/
-    };
-    VK_CHECK(vmaCreateAllocator(&allocator_info, &s_allocator));
+    cull->objects = mgfx_storage_buffer_create(prepared, objects_size);
+    cull->commands = mgfx_indirect_buffer_create(
+        NULL, (size_t)view_count * object_count * sizeof(VkDrawIndexedIndirectCommand));
+    cull->counts =
+        mgfx_indirect_buffer_create(NULL, (size_t)view_count * batch_count * sizeof(uint32_t));
 
-    for (int i = 0; i < MGFX_FRAME_COUNT; i++) {
-        VkCommandPoolCreateInfo gfx_cmd_pool = {
-            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-            .pNext = NULL,
-            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-            .queueFamilyIndex = s_queue_indices[MGFX_QUEUE_GRAPHICS],
-        };
-        VK_CHECK(vkCreateCommandPool(s_device, &gfx_cmd_pool, NULL, &s_frames[i].cmd_pool));
+    mx_free(allocator, prepared);
 
-        VkCommandBufferAllocateInfo buffer_alloc_info = {
-            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-            .pNext = NULL,
-            .commandPool = s_frames[i].cmd_pool,
-            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-            .commandBufferCount = 1,
-        };
-        VK_CHECK(vkAllocateCommandBuffers(s_device, &buffer_alloc_info, &s_frames[i].cmd));
+    const mgfx_program* cull_program = program_get(s_cull_ph);
 
-        VkSemaphoreCreateInfo swapchain_semaphore_info = {
-            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-            .pNext = NULL,
-            .flags = 0,
-        };
-        VK_CHECK(vkCreateSemaphore(
-            s_device, &swapchain_semaphore_info, NULL, &s_frames[i].swapchain_semaphore));
+    const VkDescriptorSetLayout cull_dsl = (VkDescriptorSetLayout)cull_program->dsls[0];
+    cull->ds = descriptor_set_allocate(cull_dsl, &cull->ds_pool);
 
-        VkSemaphoreCreateInfo render_semaphore_info = {
-            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-            .pNext = NULL,
-            .flags = 0,
-        };
-        VK_CHECK(vkCreateSemaphore(
-            s_device, &render_semaphore_info, NULL, &s_frames[i].render_semaphore));
+    const VkDescriptorBufferInfo buffer_infos[] = {
+        {.buffer = buffer_get(cull->objects.idx)->handle, .offset = 0, .range = VK_WHOLE_SIZE},
+        {.buffer = buffer_get(cull->commands.idx)->handle, .offset = 0, .range = VK_WHOLE_SIZE},
+        {.buffer = buffer_get(cull->counts.idx)->handle, .offset = 0, .range = VK_WHOLE_SIZE},
+    };
 
-        VkFenceCreateInfo fence_info = {
-            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    VkWriteDescriptorSet writes[3];
+    for (uint32_t binding = 0; binding < 3; binding++) {
+        writes[binding] = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
             .pNext = NULL,
-            .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+            .dstSet = cull->ds,
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = NULL,
+            .pBufferInfo = &buffer_infos[binding],
+            .pTexelBufferView = NULL,
         };
-        VK_CHECK(vkCreateFence(s_device, &fence_info, NULL, &s_frames[i].render_fence));
     }
+    vkUpdateDescriptorSets(s_device, 3, writes, 0, NULL);
 
-    VkDescriptorPoolCreateInfo ds_pool_info = {
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .pNext = NULL,
-        .flags = 0,
-        .maxSets = 300,
-        .poolSizeCount = k_ds_pool_sizes_count,
-        .pPoolSizes = k_ds_pool_sizes,
-    };
-    VK_CHECK(vkCreateDescriptorPool(s_device, &ds_pool_info, NULL, &s_ds_pool));
+    return cullh;
+}
 
-    // Initialize staging buffers
-    enum { MGFX_MAX_STAGING_BUFFER_SIZE = MX_MB * 500 };
-    ring_buffer_create(MGFX_MAX_STAGING_BUFFER_SIZE,
-                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                       VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
-                       &s_tsb_pool);
-
-    ring_buffer_create(MGFX_DEBUG_MAX_TEXT * 4 * 48,
-                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                       0,
-                       &s_tvb_pool);
-
-    ring_buffer_create(MGFX_DEBUG_MAX_TEXT * 6 * sizeof(uint32_t),
-                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                       0,
-                       &s_tib_pool);
+void mgfx_cull_update(mgfx_cullh cullh,
+                      const mgfx_cull_object* objects,
+                      uint32_t first,
+                      uint32_t count) {
+    const cull_vk* cull = cull_get(cullh);
+    MX_ASSERT(first + count <= cull->object_count);
 
-    memset(s_view_targets, 0, sizeof(mgfx_fbh) * 0xFF);
+    const size_t size = count * sizeof(mgfx_cull_object);
+    mgfx_cull_object* prepared = mx_alloc(mx_default_allocator(), size);
+    cull_objects_prepare(cull, objects, first, count, prepared);
 
-    // Init mgfx
-    mgfx_set_view_clear(MGFX_DEFAULT_VIEW_TARGET, (float[4]){0.0f, 0.0f, 0.0f, 1.0f});
+    mgfx_buffer_update(cull->objects.idx, prepared, size, first * sizeof(mgfx_cull_object));
 
-    // Init debug text
-    dbg_ui_vsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/text.vert.glsl.spv");
-    dbg_ui_fsh = mgfx_shader_create(MGFX_ASSET_PATH "shaders/text.frag.glsl.spv");
-    dbg_ui_ph = mgfx_program_create_graphics(dbg_ui_vsh, dbg_ui_fsh);
+    mx_free(mx_default_allocator(), prepared);
+}
 
-    size_t font_file_size;
-    if (mx_read_file(font_path, &font_file_size, NULL) != MX_SUCCESS) {
-        MX_LOG_ERROR("Failed to load font: %s!", font_path);
-        exit(-1);
-    }
+void mgfx_cull_destroy(mgfx_cullh cullh) {
+    mx_allocator_t allocator = mx_default_allocator();
+    cull_vk* cull = cull_get(cullh);
 
-    unsigned char* ttf_buffer = mx_alloc(tmp, font_file_size); // load .ttf file
-    mx_read_file(font_path, &font_file_size, ttf_buffer);
+    mgfx_buffer_destroy(cull->objects.idx);
+    mgfx_buffer_destroy(cull->commands.idx);
+    mgfx_buffer_destroy(cull->counts.idx);
+    deletion_queue_push_descriptor_set(cull->ds_pool, cull->ds);
 
-    unsigned char atlas_bitmap[512 * 512];
+    mx_free(allocator, cull->batch_firsts);
+    mx_free(allocator, cull->batch_sizes);
+    mx_free(allocator, cull->object_batches);
+    mx_free(allocator, cull->object_commands);
 
-    stbtt_pack_context context;
-    stbtt_PackBegin(&context, atlas_bitmap, atlas_w, atlas_h, 0, 1, NULL);
-    stbtt_PackFontRange(&context, ttf_buffer, 0, 32.0f, 32, 96, chars);
+    handle_pool_free(&s_culls, cullh.idx);
+}
 
-    // Done packing
-    stbtt_PackEnd(&context);
+mgfx_sbh mgfx_cull_objects(mgfx_cullh cullh) { return cull_get(cullh)->objects; }
 
-    stbtt_fontinfo font;
-    stbtt_InitFont(&font, ttf_buffer, stbtt_GetFontOffsetForIndex(ttf_buffer, 0));
+void mgfx_cull_view(mgfx_cullh cullh, uint32_t view, const float* view_proj) {
+    cull_vk* cull = cull_get(cullh);
+    MX_ASSERT(view < cull->view_count, "[Cull] View out of range!");
 
-    const mgfx_image_info img_info = {
-        .format = VK_FORMAT_R8_UNORM,
-        .width = atlas_w,
-        .height = atlas_h,
-        .layers = 1,
-        .cube_map = MX_FALSE,
+    cull_dispatch_vk dispatch = {
+        .cull = cull,
+        .pc =
+            {
+                .object_count = cull->object_count,
+                .command_offset = view * cull->object_count,
+                .count_offset = view * cull->batch_count,
+                .compact = s_draw_indirect_count,
+            },
     };
 
-    dbg_ui_font_atlas_th = mgfx_texture_create_from_memory(
-        &img_info, VK_FILTER_LINEAR, atlas_bitmap, atlas_w * atlas_h);
-    dbg_ui_font_atlas_dh =
-        mgfx_descriptor_create("u_diffuse", VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    mgfx_set_texture(dbg_ui_font_atlas_dh, dbg_ui_font_atlas_th);
+    cull_frustum_planes(view_proj, dispatch.pc.planes);
 
-    typedef struct glyph_vertex {
-        float position[3];
-        float uv_x;
-        float normal[3];
-        float uv_y;
-        float color[4];
-    } glyph_vertex;
+    draw_stream_push(&s_cull_dispatches, &dispatch, 1);
+}
+
+static void cull_dispatches_record(VkCommandBuffer cmd) {
+    if (s_cull_dispatches.count == 0) {
+        return;
+    }
+
+    const cull_dispatch_vk* dispatches = (const cull_dispatch_vk*)s_cull_dispatches.data;
+
+    // Previous frames may still read the commands being overwritten.
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         0,
+                         NULL,
+                         0,
+                         NULL,
+                         0,
+                         NULL);
+
+    for (uint32_t i = 0; i < s_cull_dispatches.count; i++) {
+        const cull_vk* cull = dispatches[i].cull;
+        vkCmdFillBuffer(cmd,
+                        buffer_get(cull->counts.idx)->handle,
+                        dispatches[i].pc.count_offset * sizeof(uint32_t),
+                        cull->batch_count * sizeof(uint32_t),
+                        0);
+    }
+
+    const VkMemoryBarrier fill_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         1,
+                         &fill_barrier,
+                         0,
+                         NULL,
+                         0,
+                         NULL);
+
+    const mgfx_program* cull_program = program_get(s_cull_ph);
+
+    const VkPipelineLayout layout = (VkPipelineLayout)cull_program->pipeline_layout;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, (VkPipeline)cull_program->pipeline);
+
+    for (uint32_t i = 0; i < s_cull_dispatches.count; i++) {
+        const cull_vk* cull = dispatches[i].cull;
+
+        vkCmdBindDescriptorSets(
+            cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &cull->ds, 0, NULL);
+        vkCmdPushConstants(cmd,
+                           layout,
+                           VK_SHADER_STAGE_COMPUTE_BIT,
+                           0,
+                           sizeof(cull_pc_vk),
+                           &dispatches[i].pc);
+        vkCmdDispatch(
+            cmd, (cull->object_count + MGFX_CULL_GROUP_SIZE - 1) / MGFX_CULL_GROUP_SIZE, 1, 1);
+    }
 
-    const mgfx_image_info texture_info = {
-        .format = VK_FORMAT_R8G8B8A8_UNORM,
-        .width = 1,
-        .height = 1,
-        .layers = 1,
-        .cube_map = MX_FALSE,
+    const VkMemoryBarrier cull_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
     };
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         0,
+                         1,
+                         &cull_barrier,
+                         0,
+                         NULL,
+                         0,
+                         NULL);
+
+    s_cull_dispatches.count = 0;
+}
 
-    MGFX_WHITE_TEXTURE = mgfx_texture_create_from_memory(
-        &texture_info, VK_FILTER_NEAREST, (uint8_t[4]){255, 255, 255, 255}, 4);
+void mgfx_encoder_submit_culled(mgfx_encoder* enc,
+                                uint8_t target,
+                                mgfx_ph ph,
+                                mgfx_cullh cullh,
+                                uint32_t view,
+                                uint32_t batch) {
+    const cull_vk* cull = cull_get(cullh);
+    MX_ASSERT(view < cull->view_count && batch < cull->batch_count);
+
+    const uint32_t batch_size = cull->batch_sizes[batch];
+    if (batch_size == 0) {
+        return;
+    }
 
-    MGFX_BLACK_TEXTURE = mgfx_texture_create_from_memory(
-        &texture_info, VK_FILTER_NEAREST, (uint8_t[4]){0, 0, 0, 0}, 4);
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    const uint32_t offset = (view * cull->object_count + cull->batch_firsts[batch]) * stride;
+
+    if (s_draw_indirect_count) {
+        mgfx_encoder_submit_indirect_count(enc,
+                                           target,
+                                           ph,
+                                           cull->commands,
+                                           offset,
+                                           cull->counts,
+                                           (view * cull->batch_count + batch) * sizeof(uint32_t),
+                                           batch_size,
+                                           stride);
+    } else {
+        // Culled commands are left in place with an instance count of 0.
+        mgfx_encoder_submit_indirect(enc, target, ph, cull->commands, offset, batch_size, stride);
+    }
+}
 
-    MGFX_LOCAL_NORMAL_TEXTURE = mgfx_texture_create_from_memory(
-        &texture_info, VK_FILTER_NEAREST, (uint8_t[4]){128, 128, 255, 255}, 4);
+void mgfx_submit_culled(
+    uint8_t target, mgfx_ph ph, mgfx_cullh cullh, uint32_t view, uint32_t batch) {
+    mgfx_encoder_submit_culled(&s_encoders[0], target, ph, cullh, view, batch);
+}
 
-    // Init gizmos
-    dbg_quad_vbh = mgfx_vertex_buffer_create(MGFX_FS_QUAD_VERTICES, sizeof(MGFX_FS_QUAD_VERTICES));
-    dbg_quad_ibh = mgfx_index_buffer_create(MGFX_FS_QUAD_INDICES, sizeof(MGFX_FS_QUAD_INDICES));
+static void program_create_pipeline(mgfx_program* program, const framebuffer_vk* fb) {
+    const shader_vk* vs =
+        handle_pool_get(&s_shaders, program->shaders[MGFX_SHADER_STAGE_VERTEX].idx);
+    const shader_vk* fs =
+        handle_pool_get(&s_shaders, program->shaders[MGFX_SHADER_STAGE_FRAGMENT].idx);
 
-    MX_LOG_SUCCESS("MGFX Initialized!");
-    return MGFX_SUCCESS;
+    pipeline_create_graphics(vs, fs, fb, program);
 }
 
-mgfx_vbh mgfx_vertex_buffer_create(const void* data, size_t len) {
-    buffer_entry* entry = mx_alloc(mx_default_allocator(), sizeof(buffer_entry));
-    memset(entry, 0, sizeof(buffer_entry));
+// State bound in a secondary command buffer, used to filter redundant binds.
+typedef struct bound_state_vk {
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
 
-    vertex_buffer_create(data, len, &entry->value);
+    VkDescriptorSet sets[MGFX_SHADER_MAX_DESCRIPTOR_SET];
+    uint32_t set_count;
 
-    entry->key = (VkBuffer)entry->value.handle;
-    HASH_ADD(hh, s_buffer_table, key, sizeof(mgfx_vbh), entry);
+    uint32_t dynamic_offsets[MGFX_SHADER_MAX_DYNAMIC_OFFSETS];
+    uint8_t set_dynamic_offsets[MGFX_SHADER_MAX_DESCRIPTOR_SET + 1];
 
-    return (mgfx_vbh){.idx = (uint64_t)entry->key};
-}
+    VkBuffer vbs[MGFX_SHADER_MAX_VERTEX_BINDING];
+    VkDeviceSize vb_offsets[MGFX_SHADER_MAX_VERTEX_BINDING];
+    uint32_t vb_count;
 
-void mgfx_transient_vertex_buffer_allocate(const void* data,
-                                           size_t len,
-                                           mgfx_transient_buffer* out) {
-    transient_buffer_allocate(&s_tvb_pool, data, len, out);
-}
+    VkBuffer ib;
+    VkDeviceSize ib_offset;
+    VkIndexType ib_type;
 
-void mgfx_transient_index_buffer_allocate(const void* data,
-                                          size_t len,
-                                          mgfx_transient_buffer* out) {
-    transient_buffer_allocate(&s_tib_pool, data, len, out);
-}
+    mgfx_draw_pc pc;
+    mx_bool pc_valid;
+    mx_bool view_valid;
 
-mgfx_ibh mgfx_index_buffer_create(const void* data, size_t len) {
-    buffer_entry* entry = mx_alloc(mx_default_allocator(), sizeof(buffer_entry));
-    memset(entry, 0, sizeof(buffer_entry));
+    uint32_t bindless_indices[MGFX_BINDLESS_INDEX_COUNT];
+    mx_bool bindless_indices_valid;
+    mx_bool bindless_valid;
+} bound_state_vk;
 
-    index_buffer_create(data, len, &entry->value);
+// Sets holding transient uniforms only stay bound while their dynamic offsets match.
+static mx_bool bound_set_equal(const bound_state_vk* bound,
+                               const draw_cmd_vk* draw_cmd,
+                               uint32_t set) {
+    if (bound->sets[set] != draw_cmd->sets[set]) {
+        return MX_FALSE;
+    }
 
-    entry->key = entry->value.handle;
-    HASH_ADD(hh, s_buffer_table, key, sizeof(mgfx_ibh), entry);
+    const uint32_t first = draw_cmd->set_dynamic_offsets[set];
+    const uint32_t count = draw_cmd->set_dynamic_offsets[set + 1] - first;
+    const uint32_t bound_first = bound->set_dynamic_offsets[set];
 
-    return (mgfx_ibh){.idx = (uint64_t)entry->key};
+    return bound->set_dynamic_offsets[set + 1] - bound_first == count &&
+           memcmp(&bound->dynamic_offsets[bound_first],
+                  &draw_cmd->dynamic_offsets[first],
+                  sizeof(uint32_t) * count) == 0;
 }
 
-mgfx_ubh mgfx_uniform_buffer_create(const void* data, size_t len) {
-    buffer_entry* entry = mx_alloc(mx_default_allocator(), sizeof(buffer_entry));
-    uniform_buffer_create(data, len, &entry->value);
+static mgfx_bind_counts s_worker_binds[MGFX_JOBS_MAX_WORKERS];
+static mgfx_bind_counts s_worker_binds_skipped[MGFX_JOBS_MAX_WORKERS];
 
-    entry->key = entry->value.handle;
-    HASH_ADD(hh, s_buffer_table, key, sizeof(mgfx_ubh), entry);
+static VkCommandBuffer secondary_cmds_acquire(secondary_cmds_vk* cmds) {
+    if (cmds->count == cmds->capacity) {
+        const uint32_t capacity = cmds->capacity > 0 ? cmds->capacity * 2 : 8;
 
-    return (mgfx_ubh){.idx = (uint64_t)entry->key};
-}
+        VkCommandBuffer* buffers =
+            mx_alloc(mx_default_allocator(), sizeof(VkCommandBuffer) * capacity);
+        MX_ASSERT(buffers != NULL, "[CommandBuffer] Failed to grow secondary command buffers!");
 
-void mgfx_buffer_update(uint64_t buffer_idx, const void* data, size_t len, size_t offset) {
-    buffer_entry* entry;
-    HASH_FIND(hh, s_buffer_table, &buffer_idx, sizeof(uint64_t), entry);
+        if (cmds->cmds) {
+            memcpy(buffers, cmds->cmds, sizeof(VkCommandBuffer) * cmds->capacity);
+            mx_free(mx_default_allocator(), cmds->cmds);
+        }
+
+        VkCommandBufferAllocateInfo alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext = NULL,
+            .commandPool = cmds->pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = capacity - cmds->capacity,
+        };
+        VK_CHECK(vkAllocateCommandBuffers(s_device, &alloc_info, &buffers[cmds->capacity]));
 
-    MX_ASSERT(entry != NULL, "Buffer invalid handle!");
+        cmds->cmds = buffers;
+        cmds->capacity = capacity;
+    }
 
-    buffer_update(&entry->value, offset, len, data);
+    return cmds->cmds[cmds->count++];
 }
 
-void mgfx_buffer_destroy(uint64_t idx) {
-    vkDeviceWaitIdle(s_device);
-    buffer_entry* entry;
-    HASH_FIND(hh, s_buffer_table, &idx, sizeof(idx), entry);
+static void draw_record_chunks_fn(void* ctx, uint32_t begin, uint32_t end, uint32_t worker) {
+    frame_vk* frame = (frame_vk*)ctx;
 
-    MX_ASSERT(entry != NULL, "Buffer invalid handle!");
-    buffer_destroy(&entry->value);
-}
+    draw_chunk_vk* chunks = (draw_chunk_vk*)s_draw_chunks.data;
+    const draw_segment_vk* segments = (const draw_segment_vk*)s_draw_segments.data;
+    const draw_cmd_vk* draw_cmds = (const draw_cmd_vk*)s_draw_cmds.data;
 
-mgfx_sh mgfx_shader_create(const char* path) {
-    size_t size;
-    if (mx_read_file(path, &size, NULL) != MX_SUCCESS) {
-        MX_LOG_ERROR("Failed to load shader: %s!", path);
-        exit(-1);
-    }
+    // Counted locally, then written once to avoid sharing cache lines between workers.
+    mgfx_bind_counts binds = {0};
+    mgfx_bind_counts skipped = {0};
 
-    char* shader_code = mx_alloc(mx_default_allocator(), size);
-    mx_read_file(path, &size, shader_code);
+    for (uint32_t chunk_idx = begin; chunk_idx < end; chunk_idx++) {
+        draw_chunk_vk* chunk = &chunks[chunk_idx];
+        const framebuffer_vk* fb = segments[chunk->segment].fb;
 
-    shader_entry* entry = mx_alloc(mx_default_allocator(), sizeof(shader_entry));
-    memset(entry, 0, sizeof(shader_entry));
+        VkFormat color_formats[MGFX_FRAMEBUFFER_MAX_COLOR_ATTACHMENTS];
+        for (uint32_t i = 0; i < fb->color_attachment_count; i++) {
+            color_formats[i] = fb->color_attachments[i]->format;
+        }
 
-    MX_LOG_TRACE("%s...", path);
-    shader_create(size, shader_code, &entry->value);
+        VkCommandBufferInheritanceRenderingInfo rendering_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .viewMask = 0,
+            .colorAttachmentCount = fb->color_attachment_count,
+            .pColorAttachmentFormats = color_formats,
+            .depthAttachmentFormat =
+                fb->depth_attachment ? fb->depth_attachment->format : VK_FORMAT_UNDEFINED,
+            .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        };
 
-    entry->key = entry->value.module;
-    HASH_ADD(hh, s_shader_table, key, sizeof(VkShaderModule), entry);
+        VkCommandBufferInheritanceInfo inheritance_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            .pNext = &rendering_info,
+        };
 
-    return (mgfx_sh){.idx = (uint64_t)entry->key};
-}
+        VkCommandBufferBeginInfo begin_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = NULL,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                     VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+            .pInheritanceInfo = &inheritance_info,
+        };
 
-void mgfx_shader_destroy(mgfx_sh sh) {
-    shader_entry* entry;
-    HASH_FIND(hh, s_shader_table, &sh, sizeof(sh), entry);
+        chunk->cmd = secondary_cmds_acquire(&frame->worker_cmds[worker]);
+        VkCommandBuffer cmd = chunk->cmd;
 
-    MX_ASSERT(entry != NULL, "Shader invalid handle!");
+        VK_CHECK(vkBeginCommandBuffer(cmd, &begin_info));
+        vk_cmd_set_viewport(cmd, fb);
 
-    shader_destroy(&entry->value);
+        // Secondary command buffers start without any bound state.
+        bound_state_vk bound = {0};
 
-    HASH_DEL(s_shader_table, entry);
-    mx_free(mx_default_allocator(), entry);
-}
+        const uint32_t view_offset =
+            (uint32_t)(sizeof(s_view_blocks) * s_frame_idx +
+                       sizeof(view_block_vk) * segments[chunk->segment].target);
 
-mgfx_ph mgfx_program_create_graphics_ex(mgfx_sh vsh,
-                                        mgfx_sh fsh,
-                                        const mgfx_graphics_ex_create_info* ex_info) {
-    program_entry* entry = mx_alloc(mx_default_allocator(), sizeof(program_entry));
-    memset(entry, 0, sizeof(program_entry));
-    entry->key.idx = (uint64_t)entry;
+        for (uint32_t cmd_idx = 0; cmd_idx < chunk->cmd_count; cmd_idx++) {
+            const draw_cmd_vk* draw_cmd = &draw_cmds[chunk->first_cmd + cmd_idx];
 
-    entry->value.shaders[MGFX_SHADER_STAGE_VERTEX] = vsh;
-    entry->value.shaders[MGFX_SHADER_STAGE_FRAGMENT] = fsh;
+            if (bound.pipeline != draw_cmd->pipeline) {
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, draw_cmd->pipeline);
+                bound.pipeline = draw_cmd->pipeline;
+                binds.pipelines++;
 
-    entry->value.polygon_mode = ex_info->polygon_mode;
-    entry->value.primitive_topology = ex_info->primitive_topology;
-    entry->value.cull_mode = ex_info->cull_mode;
+                // Conservatively treat different layouts as incompatible.
+                if (bound.pipeline_layout != draw_cmd->pipeline_layout) {
+                    bound.pipeline_layout = draw_cmd->pipeline_layout;
+                    bound.set_count = 0;
+                    bound.pc_valid = MX_FALSE;
+                    bound.view_valid = MX_FALSE;
+                    bound.bindless_indices_valid = MX_FALSE;
+                    bound.bindless_valid = MX_FALSE;
+                }
+            } else {
+                skipped.pipelines++;
+            }
 
-    if (ex_info->instanced) {
-    }
+            // Rebind from the first set slot that differs, lower slots stay bound.
+            uint32_t first_set = 0;
+            while (first_set < draw_cmd->set_count && first_set < bound.set_count &&
+                   bound_set_equal(&bound, draw_cmd, first_set)) {
+                first_set++;
+            }
 
-    HASH_ADD(hh, s_program_table, key, sizeof(entry->key), entry);
+            if (first_set < draw_cmd->set_count) {
+                const uint32_t first_offset = draw_cmd->set_dynamic_offsets[first_set];
+
+                vkCmdBindDescriptorSets(cmd,
+                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                        draw_cmd->pipeline_layout,
+                                        first_set,
+                                        draw_cmd->set_count - first_set,
+                                        &draw_cmd->sets[first_set],
+                                        draw_cmd->set_dynamic_offsets[draw_cmd->set_count] -
+                                            first_offset,
+                                        &draw_cmd->dynamic_offsets[first_offset]);
+
+                memcpy(&bound.sets[first_set],
+                       &draw_cmd->sets[first_set],
+                       sizeof(VkDescriptorSet) * (draw_cmd->set_count - first_set));
+                memcpy(bound.dynamic_offsets,
+                       draw_cmd->dynamic_offsets,
+                       sizeof(bound.dynamic_offsets));
+                memcpy(bound.set_dynamic_offsets,
+                       draw_cmd->set_dynamic_offsets,
+                       sizeof(bound.set_dynamic_offsets));
+                bound.set_count = draw_cmd->set_count;
+                binds.descriptor_sets += draw_cmd->set_count - first_set;
+            }
+            skipped.descriptor_sets += first_set;
+
+            // Chunks never cross view targets, the view block is bound once per layout.
+            if (draw_cmd->view_block && !bound.view_valid) {
+                vkCmdBindDescriptorSets(cmd,
+                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                        draw_cmd->pipeline_layout,
+                                        MGFX_SHADER_VIEW_SET,
+                                        1,
+                                        &s_view_ds,
+                                        1,
+                                        &view_offset);
+                bound.view_valid = MX_TRUE;
+                binds.descriptor_sets++;
+            }
 
-    return entry->key;
-}
+            // Likewise the bindless arrays, draws select their resources with pushed indices.
+            if (draw_cmd->bindless_indices && !bound.bindless_valid) {
+                vkCmdBindDescriptorSets(cmd,
+                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                        draw_cmd->pipeline_layout,
+                                        MGFX_SHADER_BINDLESS_SET,
+                                        1,
+                                        &s_bindless_ds[s_frame_idx],
+                                        0,
+                                        NULL);
+                bound.bindless_valid = MX_TRUE;
+                binds.descriptor_sets++;
+            }
 
-mgfx_ph mgfx_program_create_graphics(mgfx_sh vsh, mgfx_sh fsh) {
-    const mgfx_graphics_ex_create_info gfx_create_info = {
-        .polygon_mode = VK_POLYGON_MODE_FILL,
-        .primitive_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-        .cull_mode = VK_CULL_MODE_BACK_BIT,
-    };
+            if (draw_cmd->vb_count > 0) {
+                if (bound.vb_count != draw_cmd->vb_count ||
+                    memcmp(bound.vbs, draw_cmd->vbs, sizeof(VkBuffer) * draw_cmd->vb_count) != 0 ||
+                    memcmp(bound.vb_offsets,
+                           draw_cmd->vb_offsets,
+                           sizeof(VkDeviceSize) * draw_cmd->vb_count) != 0) {
+                    vkCmdBindVertexBuffers(
+                        cmd, 0, draw_cmd->vb_count, draw_cmd->vbs, draw_cmd->vb_offsets);
+
+                    memcpy(bound.vbs, draw_cmd->vbs, sizeof(VkBuffer) * draw_cmd->vb_count);
+                    memcpy(bound.vb_offsets,
+                           draw_cmd->vb_offsets,
+                           sizeof(VkDeviceSize) * draw_cmd->vb_count);
+                    bound.vb_count = draw_cmd->vb_count;
+                    binds.vertex_buffers++;
+                } else {
+                    skipped.vertex_buffers++;
+                }
+            }
 
-    return mgfx_program_create_graphics_ex(vsh, fsh, &gfx_create_info);
-}
+            if (bound.ib != draw_cmd->ib || bound.ib_offset != draw_cmd->ib_offset ||
+                bound.ib_type != VK_INDEX_TYPE_UINT32) {
+                vkCmdBindIndexBuffer(cmd, draw_cmd->ib, draw_cmd->ib_offset, VK_INDEX_TYPE_UINT32);
 
-mgfx_ph mgfx_program_create(mgfx_sh* sh) { return (mgfx_ph){0}; }
+                bound.ib = draw_cmd->ib;
+                bound.ib_offset = draw_cmd->ib_offset;
+                bound.ib_type = VK_INDEX_TYPE_UINT32;
+                binds.index_buffers++;
+            } else {
+                skipped.index_buffers++;
+            }
 
-mgfx_ph mgfx_program_create_compute(mgfx_sh csh) {
-    program_entry* entry = mx_alloc(mx_default_allocator(), sizeof(program_entry));
-    memset(entry, 0, sizeof(program_entry));
+            if (!bound.pc_valid ||
+                memcmp(bound.pc.model, draw_cmd->model, sizeof(bound.pc.model)) != 0) {
+                memcpy(bound.pc.model, draw_cmd->model, sizeof(bound.pc.model));
+                vkCmdPushConstants(cmd,
+                                   draw_cmd->pipeline_layout,
+                                   VK_SHADER_STAGE_VERTEX_BIT,
+                                   0,
+                                   sizeof(bound.pc),
+                                   &bound.pc);
+                bound.pc_valid = MX_TRUE;
+                binds.push_constants++;
+            } else {
+                skipped.push_constants++;
+            }
 
-    entry->key.idx = (uint64_t)entry;
+            if (draw_cmd->bindless_indices) {
+                if (!bound.bindless_indices_valid ||
+                    memcmp(bound.bindless_indices,
+                           draw_cmd->bindless_indices,
+                           sizeof(bound.bindless_indices)) != 0) {
+                    memcpy(bound.bindless_indices,
+                           draw_cmd->bindless_indices,
+                           sizeof(bound.bindless_indices));
+                    vkCmdPushConstants(cmd,
+                                       draw_cmd->pipeline_layout,
+                                       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                                       sizeof(bound.pc),
+                                       sizeof(bound.bindless_indices),
+                                       bound.bindless_indices);
+                    bound.bindless_indices_valid = MX_TRUE;
+                    binds.push_constants++;
+                } else {
+                    skipped.push_constants++;
+                }
+            }
 
-    entry->value.shaders[MGFX_SHADER_STAGE_COMPUTE] = csh;
+            if (draw_cmd->indirect == VK_NULL_HANDLE) {
+                vkCmdDrawIndexed(cmd, draw_cmd->index_count, draw_cmd->instance_count, 0, 0, 0);
+            } else if (draw_cmd->indirect_count_buffer != VK_NULL_HANDLE) {
+                vkCmdDrawIndexedIndirectCount(cmd,
+                                              draw_cmd->indirect,
+                                              draw_cmd->indirect_offset,
+                                              draw_cmd->indirect_count_buffer,
+                                              draw_cmd->indirect_count_offset,
+                                              draw_cmd->indirect_draw_count,
+                                              draw_cmd->indirect_stride);
+            } else if (s_multi_draw_indirect) {
+                vkCmdDrawIndexedIndirect(cmd,
+                                         draw_cmd->indirect,
+                                         draw_cmd->indirect_offset,
+                                         draw_cmd->indirect_draw_count,
+                                         draw_cmd->indirect_stride);
+            } else {
+                for (uint32_t i = 0; i < draw_cmd->indirect_draw_count; i++) {
+                    vkCmdDrawIndexedIndirect(cmd,
+                                             draw_cmd->indirect,
+                                             draw_cmd->indirect_offset +
+                                                 (VkDeviceSize)i * draw_cmd->indirect_stride,
+                                             1,
+                                             draw_cmd->indirect_stride);
+                }
+            }
+        }
 
-    HASH_ADD(hh, s_program_table, key, sizeof(entry->key), entry);
+        VK_CHECK(vkEndCommandBuffer(cmd));
+    }
 
-    return entry->key;
+    s_worker_binds[worker] = binds;
+    s_worker_binds_skipped[worker] = skipped;
 }
 
-void mgfx_program_destroy(mgfx_ph ph) {
-    program_entry* entry;
-    HASH_FIND(hh, s_program_table, &ph, sizeof(ph), entry);
+// Copies are grouped by destination, keeping the order they were queued in within a group so a
+// later write to a range still lands last. Consecutive copies of a group from the same staging
+// block share one copy command with adjacent regions merged. A copy overlapping a region written
+// since the last barrier on its destination starts a new command behind a transfer barrier.
+// Copy queues are grouped by destination with the draw key radix sort, which is stable so
+// copies into the same destination keep their staging order.
+static draw_stream s_copy_keys = {.stride = sizeof(mgfx_draw_key)};
+static draw_stream s_copy_keys_scratch = {.stride = sizeof(mgfx_draw_key)};
+static draw_stream s_buffer_copies_sorted = {.stride = sizeof(buffer_to_buffer_copy_vk)};
+static draw_stream s_image_copies_sorted = {.stride = sizeof(buffer_to_image_copy_vk)};
+
+// Sorts `queue` by the destination pointer stored `dst_offset` bytes into each copy. The copies
+// are gathered into `sorted_queue`, which then swaps places with `queue`.
+static void copy_queue_sort(draw_stream* queue, draw_stream* sorted_queue, size_t dst_offset) {
+    const uint32_t count = queue->count;
+    if (count < 2) {
+        return;
+    }
 
-    pipeline_destroy(&entry->value);
+    s_copy_keys.count = 0;
+    s_copy_keys_scratch.count = 0;
+    draw_stream_reserve(&s_copy_keys, count);
+    draw_stream_reserve(&s_copy_keys_scratch, count);
 
-    HASH_DEL(s_program_table, entry);
-    mx_free(mx_default_allocator(), entry);
-}
+    mgfx_draw_key* keys = (mgfx_draw_key*)s_copy_keys.data;
+    for (uint32_t i = 0; i < count; i++) {
+        const void* dst;
+        memcpy(&dst, queue->data + (size_t)i * queue->stride + dst_offset, sizeof(dst));
+        keys[i] = (mgfx_draw_key){.sort_key = (uint64_t)(uintptr_t)dst, .draw_idx = i};
+    }
 
-mgfx_imgh mgfx_image_create(const mgfx_image_info* info, uint32_t usage) {
-    image_entry* entry = mx_alloc(mx_default_allocator(), sizeof(image_entry));
-    memset(entry, 0, sizeof(image_entry));
+    const mgfx_draw_key* sorted =
+        draw_sort_keys(keys, (mgfx_draw_key*)s_copy_keys_scratch.data, count);
 
-    usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    sorted_queue->count = 0;
+    draw_stream_reserve(sorted_queue, count);
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(sorted_queue->data + (size_t)i * queue->stride,
+               queue->data + (size_t)sorted[i].draw_idx * queue->stride,
+               queue->stride);
+    }
+    sorted_queue->count = count;
 
-    image_create(info, usage, 0, &entry->value);
+    const draw_stream swap = *queue;
+    *queue = *sorted_queue;
+    *sorted_queue = swap;
+}
+
+// Barriers, regions and images gathered while recording the queues.
+static draw_stream s_copy_barriers = {.stride = sizeof(VkImageMemoryBarrier)};
+static draw_stream s_copy_buffer_regions = {.stride = sizeof(VkBufferCopy)};
+static draw_stream s_copy_image_regions = {.stride = sizeof(VkBufferImageCopy)};
+static draw_stream s_copy_mip_images = {.stride = sizeof(image_vk*)};
 
-    entry->key = entry->value.handle;
-    HASH_ADD(hh, s_image_table, key, sizeof(VkImage), entry);
+// Rewinds `stream` and returns room for `count` elements.
+static void* copy_scratch(draw_stream* stream, uint32_t count) {
+    stream->count = 0;
+    draw_stream_reserve(stream, count);
 
-    return (mgfx_imgh){.idx = (uint64_t)entry->key};
+    return stream->data;
 }
 
-void mgfx_image_destroy(mgfx_imgh imgh) {
-    image_entry* entry;
-    HASH_FIND(hh, s_image_table, &imgh, sizeof(mgfx_imgh), entry);
+static void copy_queues_sort() {
+    copy_queue_sort(
+        &s_buffer_copies, &s_buffer_copies_sorted, offsetof(buffer_to_buffer_copy_vk, dst));
+    copy_queue_sort(
+        &s_image_copies, &s_image_copies_sorted, offsetof(buffer_to_image_copy_vk, dst));
+}
 
-    if (!entry) {
-        MX_LOG_WARN("Attempting to destroy invalid image handle!");
-        return;
+static VkAccessFlags buffer_copy_dst_access(VkBufferUsageFlags usage) {
+    VkAccessFlags access = 0;
+
+    if ((usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) != 0) {
+        access |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    }
+    if ((usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) != 0) {
+        access |= VK_ACCESS_INDEX_READ_BIT;
+    }
+    if ((usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) != 0) {
+        access |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    }
+    if ((usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) != 0) {
+        access |= VK_ACCESS_SHADER_READ_BIT;
     }
 
-    image_destroy(&entry->value);
+    return access;
+}
 
-    HASH_DEL(s_image_table, entry);
-    mx_free(mx_default_allocator(), entry);
+// Layouts are tracked per image, barriers around copies cover all of its levels and layers.
+static VkImageSubresourceRange image_copy_range(const buffer_to_image_copy_vk* copy) {
+    return (VkImageSubresourceRange){
+        .aspectMask = copy->copy.imageSubresource.aspectMask,
+        .baseMipLevel = 0,
+        .levelCount = VK_REMAINING_MIP_LEVELS,
+        .baseArrayLayer = 0,
+        .layerCount = VK_REMAINING_ARRAY_LAYERS,
+    };
 }
 
-mgfx_th mgfx_texture_create_from_memory(const mgfx_image_info* info,
-                                        uint32_t filter,
-                                        void* data,
-                                        size_t len) {
-    texture_entry* entry = mx_alloc(mx_default_allocator(), sizeof(texture_entry));
-    memset(entry, 0, sizeof(texture_entry));
+// Blits every level of the images from the one above it, starting at the uploaded level 0. One
+// barrier per level moves the level just written to a blit source for all images at once, the
+// images are left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL.
+static void image_mips_record(VkCommandBuffer cmd,
+                              image_vk** images,
+                              uint32_t image_count,
+                              uint32_t level_count) {
+    VkImageMemoryBarrier* barriers = copy_scratch(&s_copy_barriers, image_count);
 
-    entry->value.imgh =
-        mgfx_image_create(info, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    for (uint32_t level = 1; level <= level_count; level++) {
+        uint32_t barrier_count = 0;
 
-    image_entry* image_entry;
-    HASH_FIND(hh, s_image_table, &entry->value.imgh, sizeof(mgfx_imgh), image_entry);
+        for (uint32_t i = 0; i < image_count; i++) {
+            if (images[i]->mip_levels < level) {
+                continue;
+            }
 
-    image_update(data, len, &image_entry->value);
+            barriers[barrier_count++] = (VkImageMemoryBarrier){
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .pNext = NULL,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = images[i]->handle,
+                .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0,
+                                     images[i]->layer_count},
+            };
+        }
 
-    VkSamplerCreateInfo sampler_info = {
-        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-        .pNext = NULL,
-        .flags = 0,
-        .magFilter = filter,
-        .minFilter = filter,
-        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
-        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-        .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-        .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-        .mipLodBias = 0,
-        .anisotropyEnable = VK_FALSE,
-        .maxAnisotropy = 0,
-        .compareEnable = VK_FALSE,
-        .compareOp = VK_COMPARE_OP_ALWAYS,
-        .minLod = 0.0f,
-        .maxLod = 1.0f,
-        .borderColor = 0,
-        .unnormalizedCoordinates = VK_FALSE,
-    };
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0,
+                             0,
+                             NULL,
+                             0,
+                             NULL,
+                             barrier_count,
+                             barriers);
 
-    VK_CHECK(vkCreateSampler(s_device, &sampler_info, NULL, (VkSampler*)&entry->value.sampler));
+        for (uint32_t i = 0; i < image_count; i++) {
+            const image_vk* image = images[i];
+            if (image->mip_levels <= level) {
+                continue;
+            }
 
-    image_create_view(&image_entry->value,
-                      VK_IMAGE_VIEW_TYPE_2D,
-                      VK_IMAGE_ASPECT_COLOR_BIT,
-                      (VkImageView*)(&entry->key));
-    HASH_ADD(hh, s_texture_table, key, sizeof(uint64_t), entry);
+            const VkExtent3D src = image_level_extent(image, level - 1);
+            const VkExtent3D dst = image_level_extent(image, level);
 
-    return entry->key;
-};
+            const VkImageBlit blit = {
+                .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, image->layer_count},
+                .srcOffsets = {{0, 0, 0}, {(int32_t)src.width, (int32_t)src.height, 1}},
+                .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, image->layer_count},
+                .dstOffsets = {{0, 0, 0}, {(int32_t)dst.width, (int32_t)dst.height, 1}},
+            };
 
-mgfx_th mgfx_texture_create_from_image(mgfx_imgh img, const uint32_t filter) {
-    texture_entry* entry = mx_alloc(mx_default_allocator(), sizeof(texture_entry));
-    memset(entry, 0, sizeof(texture_entry));
+            vkCmdBlitImage(cmd,
+                           image->handle,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           image->handle,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1,
+                           &blit,
+                           VK_FILTER_LINEAR);
+        }
+    }
 
-    entry->value.imgh = img;
+    for (uint32_t i = 0; i < image_count; i++) {
+        images[i]->layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    }
+}
 
-    image_entry* image_entry;
-    HASH_FIND(hh, s_image_table, &entry->value.imgh, sizeof(mgfx_imgh), image_entry);
+static mx_bool buffer_regions_overlap(const VkBufferCopy* regions,
+                                      uint32_t region_count,
+                                      const VkBufferCopy* copy) {
+    for (uint32_t i = 0; i < region_count; i++) {
+        if (regions[i].dstOffset < copy->dstOffset + copy->size &&
+            copy->dstOffset < regions[i].dstOffset + regions[i].size) {
+            return MX_TRUE;
+        }
+    }
 
-    VkSamplerCreateInfo sampler_info = {
-        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-        .pNext = NULL,
-        .flags = 0,
-        .magFilter = filter,
-        .minFilter = filter,
-        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+    return MX_FALSE;
+}
 
-        /*.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,*/
-        /*.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,*/
-        /*.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,*/
+static mx_bool ranges_overlap(int64_t a, uint32_t a_size, int64_t b, uint32_t b_size) {
+    return a < b + b_size && b < a + a_size;
+}
 
-        // Shadow
-        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
-        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
-        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
-        /*.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,*/
+static mx_bool image_regions_overlap(const VkBufferImageCopy* regions,
+                                     uint32_t region_count,
+                                     const VkBufferImageCopy* copy) {
+    const VkImageSubresourceLayers* sub = &copy->imageSubresource;
+
+    for (uint32_t i = 0; i < region_count; i++) {
+        const VkBufferImageCopy* region = &regions[i];
+        const VkImageSubresourceLayers* region_sub = &region->imageSubresource;
+
+        if (region_sub->mipLevel == sub->mipLevel &&
+            (region_sub->aspectMask & sub->aspectMask) != 0 &&
+            ranges_overlap(region_sub->baseArrayLayer,
+                           region_sub->layerCount,
+                           sub->baseArrayLayer,
+                           sub->layerCount) &&
+            ranges_overlap(region->imageOffset.x,
+                           region->imageExtent.width,
+                           copy->imageOffset.x,
+                           copy->imageExtent.width) &&
+            ranges_overlap(region->imageOffset.y,
+                           region->imageExtent.height,
+                           copy->imageOffset.y,
+                           copy->imageExtent.height) &&
+            ranges_overlap(region->imageOffset.z,
+                           region->imageExtent.depth,
+                           copy->imageOffset.z,
+                           copy->imageExtent.depth)) {
+            return MX_TRUE;
+        }
+    }
 
-        .mipLodBias = 0,
-        .anisotropyEnable = VK_FALSE,
-        .maxAnisotropy = 0,
-        .compareEnable = VK_FALSE,
-        .compareOp = VK_COMPARE_OP_ALWAYS,
-        .minLod = 0.0f,
-        .maxLod = 1.0f,
+    return MX_FALSE;
+}
 
-        .borderColor = 0,
-        .unnormalizedCoordinates = 0,
-    };
+static void buffer_copy_record(VkCommandBuffer cmd,
+                               VkBuffer src,
+                               const buffer_vk* dst,
+                               const VkBufferCopy* regions,
+                               uint32_t region_count) {
+    if (region_count == 0) {
+        return;
+    }
 
-    // TODO: Make aspect argument
-    if (image_entry->value.format == VK_FORMAT_D32_SFLOAT) {
-        image_create_view(&image_entry->value,
-                          VK_IMAGE_VIEW_TYPE_2D,
-                          VK_IMAGE_ASPECT_DEPTH_BIT,
-                          (VkImageView*)(&entry->key));
-        HASH_ADD(hh, s_texture_table, key, sizeof(uint64_t), entry);
-    } else {
-        image_create_view(&image_entry->value,
-                          VK_IMAGE_VIEW_TYPE_2D,
-                          VK_IMAGE_ASPECT_COLOR_BIT,
-                          (VkImageView*)(&entry->key));
-        HASH_ADD(hh, s_texture_table, key, sizeof(uint64_t), entry);
+    vkCmdCopyBuffer(cmd, src, dst->handle, region_count, regions);
+
+    s_stats.upload_copies++;
+    s_stats.upload_regions += region_count;
+}
+
+static void image_copy_record(VkCommandBuffer cmd,
+                              VkBuffer src,
+                              const image_vk* dst,
+                              const VkBufferImageCopy* regions,
+                              uint32_t region_count) {
+    if (region_count == 0) {
+        return;
     }
 
-    VK_CHECK(vkCreateSampler(s_device, &sampler_info, NULL, (VkSampler*)&entry->value.sampler));
+    vkCmdCopyBufferToImage(
+        cmd, src, dst->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region_count, regions);
 
-    return entry->key;
+    s_stats.upload_copies++;
+    s_stats.upload_regions += region_count;
 }
 
-void mgfx_texture_destroy(mgfx_th th, mx_bool release_image) {
-    VK_CHECK(vkDeviceWaitIdle(s_device));
+// Orders a copy behind the earlier ones writing the same range of its destination.
+static void buffer_copy_barrier(VkCommandBuffer cmd, const buffer_vk* dst) {
+    const VkBufferMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = dst->handle,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         NULL,
+                         1,
+                         &barrier,
+                         0,
+                         NULL);
+}
 
-    texture_entry* entry;
-    HASH_FIND(hh, s_texture_table, &th, sizeof(th), entry);
-    MX_ASSERT(entry != NULL, "Texture invalid handle!");
+static void image_copy_barrier(VkCommandBuffer cmd, const buffer_to_image_copy_vk* copy) {
+    const VkImageMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = copy->dst->handle,
+        .subresourceRange = image_copy_range(copy),
+    };
 
-    // TODO: Move to texture_destroy
-    vkDestroyImageView(s_device, (VkImageView)entry->key.idx, NULL);
-    vkDestroySampler(s_device, (VkSampler)entry->value.sampler, NULL);
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         NULL,
+                         0,
+                         NULL,
+                         1,
+                         &barrier);
+}
+
+// Records the frame's upload queues with one barrier before the image copies and one after all
+// copies, which makes the uploads visible to every stage reading them.
+static void copy_queues_record(VkCommandBuffer cmd) {
+    s_stats.upload_copies = 0;
+    s_stats.upload_regions = 0;
 
-    HASH_DEL(s_texture_table, entry);
-    if (release_image) {
-        mgfx_image_destroy(entry->value.imgh);
+    if (s_buffer_copies.count == 0 && s_image_copies.count == 0) {
+        return;
     }
 
-    mx_free(mx_default_allocator(), entry);
-}
+    copy_queues_sort();
 
-mgfx_dh mgfx_descriptor_create(const char* name, uint32_t type) {
-    descriptor_entry* entry = mx_alloc(mx_default_allocator(), sizeof(descriptor_entry));
-    memset(entry, 0, sizeof(descriptor_entry));
+    const buffer_to_buffer_copy_vk* buffer_copies = (buffer_to_buffer_copy_vk*)s_buffer_copies.data;
+    const buffer_to_image_copy_vk* image_copies = (buffer_to_image_copy_vk*)s_image_copies.data;
+    const uint32_t buffer_copy_count = s_buffer_copies.count;
+    const uint32_t image_copy_count = s_image_copies.count;
 
-    entry->key = (mgfx_dh){.idx = (uint64_t)(entry)};
-    entry->value = (descriptor_info_vk){.type = type};
+    // Uploads split into pieces copy into the same image more than once, each image is
+    // transitioned once before and once after all of its copies.
+    VkImageMemoryBarrier* pre_copy_barriers = copy_scratch(&s_copy_barriers, image_copy_count);
+    uint32_t pre_copy_count = 0;
 
-    MX_ASSERT(strlen(name) <= sizeof(entry->value.name));
-    strcpy(entry->value.name, name);
+    for (uint32_t i = 0; i < image_copy_count; i++) {
+        image_vk* dst = image_copies[i].dst;
+        if (dst->layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            continue;
+        }
 
-    HASH_ADD(hh, s_descriptor_table, key, sizeof(uint64_t), entry);
+        pre_copy_barriers[pre_copy_count++] = (VkImageMemoryBarrier){
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = NULL,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = dst->layout,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = dst->handle,
+            .subresourceRange = image_copy_range(&image_copies[i]),
+        };
+        dst->layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    }
 
-    return entry->key;
-}
+    if (pre_copy_count > 0) {
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0,
+                             0,
+                             NULL,
+                             0,
+                             NULL,
+                             pre_copy_count,
+                             pre_copy_barriers);
+    }
 
-void mgfx_set_buffer(mgfx_dh dh, mgfx_ubh ubh) {
-    descriptor_entry* entry;
-    HASH_FIND(hh, s_descriptor_table, &dh, sizeof(dh), entry);
-    MX_ASSERT(entry != NULL, "Descriptor invalid handle!");
+    // Buffer to buffer copy queue
+    VkBufferCopy* buffer_regions = copy_scratch(&s_copy_buffer_regions, buffer_copy_count);
+    VkAccessFlags buffer_access = 0;
 
-    buffer_entry* buffer_entry;
-    HASH_FIND(hh, s_buffer_table, &ubh, sizeof(ubh), buffer_entry);
-    MX_ASSERT(buffer_entry != NULL, "buffer invalid handle!");
+    for (uint32_t first = 0; first < buffer_copy_count;) {
+        const buffer_vk* dst = buffer_copies[first].dst;
+        VkBuffer src = buffer_copies[first].src;
 
-    entry->value.buffer_info.buffer = (VkBuffer)ubh.idx;
-    entry->value.buffer_info.offset = 0;
-    entry->value.buffer_info.range = VK_WHOLE_SIZE;
+        uint32_t region_count = 0;  // Regions written since the last barrier on dst,
+        uint32_t command_first = 0; // the ones from command_first on are not recorded yet.
 
-    entry->value.buffer = &buffer_entry->value;
-}
+        uint32_t copy_idx = first;
+        for (; copy_idx < buffer_copy_count; copy_idx++) {
+            const buffer_to_buffer_copy_vk* copy = &buffer_copies[copy_idx];
+            if (copy->dst != dst) {
+                break;
+            }
 
-void mgfx_set_texture(mgfx_dh dh, mgfx_th th) {
-    descriptor_entry* entry;
-    HASH_FIND(hh, s_descriptor_table, &dh, sizeof(dh), entry);
-    MX_ASSERT(entry != NULL, "Descriptor invalid handle!");
+            const mx_bool overlaps =
+                buffer_regions_overlap(buffer_regions, region_count, &copy->copy);
+            if (overlaps || copy->src != src) {
+                buffer_copy_record(
+                    cmd, src, dst, &buffer_regions[command_first], region_count - command_first);
+                command_first = region_count;
+                src = copy->src;
+            }
 
-    texture_entry* texture_entry;
-    HASH_FIND(hh, s_texture_table, &th, sizeof(th), texture_entry);
-    MX_ASSERT(texture_entry != NULL, "Texture invalid handle!");
+            if (overlaps) {
+                buffer_copy_barrier(cmd, dst);
+                region_count = command_first = 0;
+            }
 
-    entry->value.image_info.imageView = (VkImageView)th.idx;
-    entry->value.image_info.sampler = (VkSampler)texture_entry->value.sampler;
-    entry->value.image_info.imageLayout =
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // Expected layout
+            VkBufferCopy* prev =
+                region_count > command_first ? &buffer_regions[region_count - 1] : NULL;
+            if (prev && prev->srcOffset + prev->size == copy->copy.srcOffset &&
+                prev->dstOffset + prev->size == copy->copy.dstOffset) {
+                prev->size += copy->copy.size;
+            } else {
+                buffer_regions[region_count++] = copy->copy;
+            }
+        }
 
-    image_entry* image_entry;
-    HASH_FIND(hh, s_image_table, &texture_entry->value.imgh, sizeof(mgfx_imgh), image_entry);
-    MX_ASSERT(image_entry != NULL, "Image invalid handle!");
-    entry->value.image = &image_entry->value;
-}
+        buffer_copy_record(
+            cmd, src, dst, &buffer_regions[command_first], region_count - command_first);
+        buffer_access |= buffer_copy_dst_access(dst->usage);
 
-void mgfx_descriptor_destroy(mgfx_dh dh) {}
+        first = copy_idx;
+    }
 
-mgfx_fbh mgfx_framebuffer_create(mgfx_imgh* color_attachments,
-                                 uint32_t color_attachment_count,
-                                 mgfx_imgh depth_attachment) {
-    // TODO: Framebuffer should be an api agonstic concept.
-    framebuffer_entry* entry = mx_alloc(mx_default_allocator(), sizeof(framebuffer_entry));
-    memset(entry, 0, sizeof(framebuffer_entry));
+    // Buffer to image copy queue
+    VkBufferImageCopy* image_regions = copy_scratch(&s_copy_image_regions, image_copy_count);
+
+    for (uint32_t first = 0; first < image_copy_count;) {
+        const image_vk* dst = image_copies[first].dst;
+        VkBuffer src = image_copies[first].src;
+
+        uint32_t region_count = 0;
+        uint32_t command_first = 0;
+
+        uint32_t copy_idx = first;
+        for (; copy_idx < image_copy_count; copy_idx++) {
+            const buffer_to_image_copy_vk* copy = &image_copies[copy_idx];
+            if (copy->dst != dst) {
+                break;
+            }
+
+            const mx_bool overlaps =
+                image_regions_overlap(image_regions, region_count, &copy->copy);
+            if (overlaps || copy->src != src) {
+                image_copy_record(
+                    cmd, src, dst, &image_regions[command_first], region_count - command_first);
+                command_first = region_count;
+                src = copy->src;
+            }
+
+            if (overlaps) {
+                image_copy_barrier(cmd, copy);
+                region_count = command_first = 0;
+            }
 
-    framebuffer_vk* fb = &entry->value;
-    fb->color_attachment_count = color_attachment_count;
-    for (uint32_t i = 0; i < color_attachment_count; i++) {
-        image_entry* color_entry;
-        HASH_FIND(hh, s_image_table, &color_attachments[i], sizeof(mgfx_imgh), color_entry);
+            image_regions[region_count++] = copy->copy;
+        }
+
+        image_copy_record(
+            cmd, src, dst, &image_regions[command_first], region_count - command_first);
 
-        fb->color_attachments[i] = &color_entry->value;
-        image_create_view(fb->color_attachments[i],
-                          VK_IMAGE_VIEW_TYPE_2D,
-                          VK_IMAGE_ASPECT_COLOR_BIT,
-                          &fb->color_attachment_views[i]);
+        first = copy_idx;
     }
 
-    image_entry* depth_entry;
-    HASH_FIND(hh, s_image_table, &depth_attachment, sizeof(mgfx_imgh), depth_entry);
-    if (depth_entry) {
-        fb->depth_attachment = &depth_entry->value;
-        image_create_view(fb->depth_attachment,
-                          VK_IMAGE_VIEW_TYPE_2D,
-                          VK_IMAGE_ASPECT_DEPTH_BIT,
-                          &fb->depth_attachment_view);
+    // Images whose upload completed this frame rebuild their mip chain. Copies are sorted by
+    // destination so an image marked twice is marked by adjacent copies.
+    image_vk** mip_images = copy_scratch(&s_copy_mip_images, image_copy_count);
+    uint32_t mip_image_count = 0;
+    uint32_t mip_level_count = 0;
+
+    for (uint32_t i = 0; i < image_copy_count; i++) {
+        const buffer_to_image_copy_vk* copy = &image_copies[i];
+        if (!copy->generate_mips || copy->dst->layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            continue;
+        }
+
+        if (mip_image_count == 0 || mip_images[mip_image_count - 1] != copy->dst) {
+            mip_images[mip_image_count++] = copy->dst;
+            if (copy->dst->mip_levels > mip_level_count) {
+                mip_level_count = copy->dst->mip_levels;
+            }
+        }
     }
 
-    entry->key.idx = (uint64_t)fb;
-    HASH_ADD(hh, s_framebuffer_table, key, sizeof(mgfx_fbh), entry);
+    if (mip_image_count > 0) {
+        image_mips_record(cmd, mip_images, mip_image_count, mip_level_count);
+    }
 
-    return entry->key;
-}
+    VkImageMemoryBarrier* sampled_barriers = copy_scratch(&s_copy_barriers, image_copy_count);
+    uint32_t sampled_count = 0;
 
-void mgfx_framebuffer_destroy(mgfx_fbh fbh) {
-    framebuffer_entry* framebuffer_entry;
-    HASH_FIND(hh, s_framebuffer_table, &fbh, sizeof(mgfx_fbh), framebuffer_entry);
+    for (uint32_t i = 0; i < image_copy_count; i++) {
+        image_vk* dst = image_copies[i].dst;
+        if (dst->layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
+            dst->layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+            continue;
+        }
 
-    if (!framebuffer_entry) {
-        MX_LOG_WARN("Attempting to destroy invalid framebuffer handle!");
-        return;
+        // TODO: Check if sampled.
+        sampled_barriers[sampled_count++] = (VkImageMemoryBarrier){
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = NULL,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .oldLayout = dst->layout,
+            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = dst->handle,
+            .subresourceRange = image_copy_range(&image_copies[i]),
+        };
+        dst->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     }
 
-    framebuffer_destroy(&framebuffer_entry->value);
+    const VkMemoryBarrier buffer_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = buffer_access,
+    };
 
-    HASH_DEL(s_framebuffer_table, framebuffer_entry);
-    mx_free(mx_default_allocator(), framebuffer_entry);
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0,
+                         buffer_access != 0 ? 1 : 0,
+                         &buffer_barrier,
+                         0,
+                         NULL,
+                         sampled_count,
+                         sampled_barriers);
+
+    s_buffer_copies.count = 0;
+    s_image_copies.count = 0;
 }
 
-void mgfx_bind_vertex_buffer(mgfx_vbh vbh) {
-    mgfx_draw* current_draw = &s_draws[s_draw_count];
-    current_draw->vbhs[current_draw->vbh_count] = vbh;
+static void descriptor_set_lru_unlink(descriptor_set_entry* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        s_descriptor_set_lru_head = entry->lru_next;
+    }
+
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        s_descriptor_set_lru_tail = entry->lru_prev;
+    }
 
-    ++current_draw->vbh_count;
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
 }
 
-void mgfx_bind_transient_vertex_buffer(mgfx_transient_buffer tb) {
-    mgfx_draw* current_draw = &s_draws[s_draw_count];
-    current_draw->tvbs[current_draw->tvbh_count] = tb;
-
-    ++current_draw->tvbh_count;
+static void descriptor_set_lru_push_front(descriptor_set_entry* entry) {
+    entry->lru_next = s_descriptor_set_lru_head;
+    if (s_descriptor_set_lru_head) {
+        s_descriptor_set_lru_head->lru_prev = entry;
+    } else {
+        s_descriptor_set_lru_tail = entry;
+    }
+    s_descriptor_set_lru_head = entry;
 }
 
-void mgfx_bind_index_buffer(mgfx_ibh ibh) {
-    mgfx_draw* current_draw = &s_draws[s_draw_count];
-    current_draw->ibh = ibh;
+// Frames in flight may still reference the set, it is freed once they retired.
+static void descriptor_set_evict(descriptor_set_entry* entry) {
+    deletion_queue_push_descriptor_set(entry->pool, entry->value);
+
+    descriptor_set_lru_unlink(entry);
+    HASH_DELETE(hh, s_descriptor_set_table, entry);
+    mx_free(mx_default_allocator(), entry);
+    s_descriptor_set_count--;
 }
 
-void mgfx_bind_transient_index_buffer(mgfx_transient_buffer tib) {
-    mgfx_draw* current_draw = &s_draws[s_draw_count];
-    current_draw->tib = tib;
+static void descriptor_sets_evict_layout(VkDescriptorSetLayout dsl) {
+    descriptor_set_entry *entry, *tmp;
+    HASH_ITER(hh, s_descriptor_set_table, entry, tmp) {
+        if (entry->key.dsl == (uint64_t)dsl) {
+            descriptor_set_evict(entry);
+        }
+    }
 }
 
-void mgfx_bind_descriptor(uint32_t ds_idx, mgfx_dh dh) {
-    MX_ASSERT(ds_idx < MGFX_SHADER_MAX_DESCRIPTOR_SET);
+static VkDescriptorPool descriptor_pool_create() {
+    // Sized for sets of a few uniform and storage buffers and up to 6 textures.
+    const VkDescriptorPoolSize pool_sizes[] = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MGFX_DESCRIPTOR_POOL_SETS * 2},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, MGFX_DESCRIPTOR_POOL_SETS},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MGFX_DESCRIPTOR_POOL_SETS * 2},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MGFX_DESCRIPTOR_POOL_SETS / 2},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MGFX_DESCRIPTOR_POOL_SETS * 6},
+    };
 
-    mgfx_draw* current_draw = &s_draws[s_draw_count];
+    const VkDescriptorPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = NULL,
+        // Evicted sets are returned individually.
+        .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+        .maxSets = MGFX_DESCRIPTOR_POOL_SETS,
+        .poolSizeCount = sizeof(pool_sizes) / sizeof(VkDescriptorPoolSize),
+        .pPoolSizes = pool_sizes,
+    };
 
-    uint32_t descriptor_idx = current_draw->desc_sets[ds_idx].dh_count;
-    MX_ASSERT(descriptor_idx < MGFX_SHADER_MAX_DESCRIPTOR_BINDING);
+    VkDescriptorPool pool;
+    VK_CHECK(vkCreateDescriptorPool(s_device, &pool_info, NULL, &pool));
+    draw_stream_push(&s_ds_pools, &pool, 1);
 
-    current_draw->desc_sets[ds_idx].dhs[descriptor_idx] = dh;
-    ++current_draw->desc_sets[ds_idx].dh_count;
+    return pool;
 }
 
-void mgfx_set_view_clear(uint8_t target, float* color_4) {
-    MX_ASSERT(
-        target <= 0xFF,
-        "Attemping to set clear color for unknown target. Please call mgfx_set_view_target first");
-    memcpy(s_view_clears[target].float32, color_4, sizeof(float) * 4);
-}
+// Tries every pool of the chain starting with the last one that had room, then grows it.
+static VkDescriptorSet descriptor_set_allocate(VkDescriptorSetLayout dsl, VkDescriptorPool* pool) {
+    VkDescriptorSetAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = NULL,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &dsl,
+    };
 
-void mgfx_set_view_target(uint8_t target, mgfx_fbh fb) { s_view_targets[target] = fb; }
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    const VkDescriptorPool* pools = (const VkDescriptorPool*)s_ds_pools.data;
+    for (uint32_t i = 0; i < s_ds_pools.count; i++) {
+        const uint32_t pool_idx = (s_ds_pool_current + i) % s_ds_pools.count;
+        alloc_info.descriptorPool = pools[pool_idx];
+
+        const VkResult result = vkAllocateDescriptorSets(s_device, &alloc_info, &set);
+        if (result == VK_SUCCESS) {
+            s_ds_pool_current = pool_idx;
+            *pool = pools[pool_idx];
+            return set;
+        }
 
-void mgfx_set_transform(const float* mtx) { memcpy(s_current_transform, mtx, sizeof(float) * 16); }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+            VK_CHECK(result);
+        }
+    }
 
-void mgfx_set_view(const float* mtx) { memcpy(s_current_view, mtx, sizeof(float) * 16); }
+    alloc_info.descriptorPool = descriptor_pool_create();
+    s_ds_pool_current = s_ds_pools.count - 1;
+    VK_CHECK(vkAllocateDescriptorSets(s_device, &alloc_info, &set));
 
-void mgfx_set_proj(const float* mtx) { memcpy(s_current_proj, mtx, sizeof(float) * 16); }
+    *pool = alloc_info.descriptorPool;
+    return set;
+}
 
-void mgfx_submit(uint8_t target, mgfx_ph ph) {
-    MX_ASSERT(s_draw_count < MGFX_MAX_DRAW_COUNT,
-              "Reached max draws! Consider instancing or batching!");
+static void descriptor_set_write(const descriptor_set_entry* entry,
+                                 const mgfx_dh* dhs,
+                                 uint32_t dh_count) {
+    for (uint32_t binding_idx = 0; binding_idx < dh_count; binding_idx++) {
+        const descriptor_info_vk* descriptor = descriptor_get(dhs[binding_idx]);
 
-    program_entry* entry;
-    HASH_FIND(hh, s_program_table, &ph, sizeof(ph), entry);
-    MX_ASSERT(entry != NULL, "Program invalid handle!");
+        VkWriteDescriptorSet write = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = NULL,
+            .dstSet = entry->value,
+            .dstBinding = binding_idx,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = descriptor->type,
+            .pImageInfo = NULL,
+            .pBufferInfo = NULL,
+            .pTexelBufferView = NULL,
+        };
 
-    if ((VkPipeline)entry->value.pipeline == VK_NULL_HANDLE) {
-        mgfx_program* program = &entry->value;
+        switch (descriptor->type) {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            // Sampled images are transitioned by the target pre pass before the draws
+            // of this view target execute.
+            write.pImageInfo = &descriptor->image_info;
+            break;
 
-        shader_entry* vs_entry;
-        HASH_FIND(hh,
-                  s_shader_table,
-                  &program->shaders[MGFX_SHADER_STAGE_VERTEX],
-                  sizeof(VkShaderModule),
-                  vs_entry);
-        const shader_vk* vs = vs_entry ? &vs_entry->value : NULL;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            write.pBufferInfo = &descriptor->buffer_info;
+            break;
 
-        shader_entry* fs_entry;
-        HASH_FIND(hh,
-                  s_shader_table,
-                  &program->shaders[MGFX_SHADER_STAGE_FRAGMENT],
-                  sizeof(VkShaderModule),
-                  fs_entry);
-        const shader_vk* fs = fs_entry ? &fs_entry->value : NULL;
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+        case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK:
+        case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+        case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_NV:
+        case VK_DESCRIPTOR_TYPE_SAMPLE_WEIGHT_IMAGE_QCOM:
+        case VK_DESCRIPTOR_TYPE_BLOCK_MATCH_IMAGE_QCOM:
+        case VK_DESCRIPTOR_TYPE_MUTABLE_EXT:
+        case VK_DESCRIPTOR_TYPE_MAX_ENUM:
+        default:
+            MX_LOG_ERROR("Unsupported descriptor type!");
+            break;
+        };
 
-        if (target == MGFX_DEFAULT_VIEW_TARGET) {
-            pipeline_create_graphics(vs, fs, &s_swapchain.framebuffer, program);
-        } else {
-            framebuffer_entry* fb_entry;
-            HASH_FIND(hh, s_framebuffer_table, &s_view_targets[target], sizeof(mgfx_fbh), fb_entry);
+        vkUpdateDescriptorSets(s_device, 1, &write, 0, NULL);
+    }
+}
 
-            if (!fb_entry) {
-                MX_LOG_ERROR("Submitting to unknown view target '%d'! Please call "
-                             "mgfx_set_view_target().",
-                             target);
-            }
+// `hash` is the bind time hash of `dhs`, full keys are compared so colliding hashes are safe.
+static VkDescriptorSet descriptor_set_get(VkDescriptorSetLayout dsl,
+                                          const mgfx_dh* dhs,
+                                          uint32_t dh_count,
+                                          uint32_t hash) {
+    descriptor_set_key_vk key;
+    memset(&key, 0, sizeof(key));
+    key.dsl = (uint64_t)dsl;
+    key.dh_count = dh_count;
+    for (uint32_t i = 0; i < dh_count; i++) {
+        key.dhs[i] = dhs[i].idx;
+        key.versions[i] = descriptor_get(dhs[i])->version;
+    }
+
+    const uint32_t set_hash = descriptor_hash_step(hash, (uint64_t)dsl);
 
-            pipeline_create_graphics(vs, fs, &fb_entry->value, program);
+    descriptor_set_entry* entry;
+    HASH_FIND_BYHASHVALUE(
+        hh, s_descriptor_set_table, &key, sizeof(descriptor_set_key_vk), set_hash, entry);
+
+    if (entry) {
+        if (entry != s_descriptor_set_lru_head) {
+            descriptor_set_lru_unlink(entry);
+            descriptor_set_lru_push_front(entry);
         }
+        return entry->value;
+    }
+
+    if (s_descriptor_set_count >= MGFX_DESCRIPTOR_SET_CACHE_SIZE) {
+        descriptor_set_evict(s_descriptor_set_lru_tail);
+        s_stats.descriptor_set_evictions++;
     }
 
-    mgfx_draw* current_draw = &s_draws[s_draw_count];
-    current_draw->view_target = target;
-    current_draw->ph = ph;
+    entry = mx_alloc(mx_default_allocator(), sizeof(descriptor_set_entry));
+    memset(entry, 0, sizeof(descriptor_set_entry));
+
+    entry->key = key;
+    entry->value = descriptor_set_allocate(dsl, &entry->pool);
+    descriptor_set_write(entry, dhs, dh_count);
 
-    memcpy(current_draw->draw_pc.model, s_current_transform, sizeof(float) * 16);
-    memcpy(current_draw->draw_pc.view, s_current_view, sizeof(float) * 16);
-    memcpy(current_draw->draw_pc.proj, s_current_proj, sizeof(float) * 16);
+    HASH_ADD_BYHASHVALUE(
+        hh, s_descriptor_set_table, key, sizeof(descriptor_set_key_vk), set_hash, entry);
+    descriptor_set_lru_push_front(entry);
+    s_descriptor_set_count++;
 
-    // TODO: Make ph.idx a uint16_t
-    current_draw->sort_key = ((uint64_t)(target) << 56) |         // highest priority (view)
-                             ((uint64_t)(ph.idx & 0xFFFF) << 40); // then shader program
-    /*| ((uint64_t)(descriptors_hash) << 8);*/
-    ++s_draw_count;
+    return entry->value;
 }
 
 void mgfx_frame() {
@@ -2260,13 +6111,42 @@ void mgfx_frame() {
 
     // Wait and reset render fence of current frame idx.
     VK_CHECK(vkWaitForFences(s_device, 1, &frame->render_fence, VK_TRUE, UINT64_MAX));
+    deletion_queue_flush(&s_deletions[s_frame_idx]);
+    transient_ring_reclaim(&s_tvb_pool, s_frame_idx);
+    transient_ring_reclaim(&s_tib_pool, s_frame_idx);
+    transient_ring_reclaim(&s_tsb_pool, s_frame_idx);
+    staging_uploads_reclaim(s_frame_idx);
 
     if (!swapchain_update(frame, s_width, s_height, &s_swapchain)) {
+        // The frame is skipped, its draws, cull dispatches and the transient data they reference
+        // are dropped.
+        // Staged uploads are kept for the next frame.
+        for (uint32_t enc_idx = 0; enc_idx < s_encoder_count; enc_idx++) {
+            draw_arena_reset(&s_encoders[enc_idx].arena);
+        }
+        s_encoder_count = 1;
+        s_cull_dispatches.count = 0;
+
+        transient_ring_discard(&s_tvb_pool);
+        transient_ring_discard(&s_tib_pool);
+        s_tub_head = 0;
         return;
     }
 
+    // Before draws resolve their descriptor sets, swapped textures rebuild the ones using them.
+    texture_loads_process();
+
+    // The fence above retired the last frame reading this frame's bindless set.
+    if (s_bindless) {
+        bindless_writes_flush(s_frame_idx);
+    }
+
     VK_CHECK(vkResetFences(s_device, 1, &frame->render_fence));
 
+    // The previous use of this frame's view blocks is complete.
+    buffer_update(
+        &s_view_buffer, sizeof(s_view_blocks) * s_frame_idx, sizeof(s_view_blocks), s_view_blocks);
+
     vkResetCommandBuffer(frame->cmd, 0);
     VkCommandBufferBeginInfo cmd_begin_info = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -2277,475 +6157,378 @@ void mgfx_frame() {
 
     VK_CHECK(vkBeginCommandBuffer(frame->cmd, &cmd_begin_info));
 
-    // Buffer to buffer copy queue
-    if (s_buffer_to_buffer_copy_count > 0) {
-        VkMemoryBarrier vb_cpy_barriers[MGFX_MAX_FRAME_BUFFER_COPIES];
-        uint32_t vb_cpy_barrier_count = 0;
-
-        for (uint32_t copy_idx = 0; copy_idx < s_buffer_to_buffer_copy_count; copy_idx++) {
-            const buffer_vk* src = s_buffer_to_buffer_copy_queue[copy_idx].src;
-            buffer_vk* dst = s_buffer_to_buffer_copy_queue[copy_idx].dst;
-            VkBufferCopy* cpy = &s_buffer_to_buffer_copy_queue[copy_idx].copy;
-
-            vkCmdCopyBuffer(frame->cmd, src->handle, dst->handle, 1, cpy);
-
-            if ((dst->usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) ==
-                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
-                vb_cpy_barriers[vb_cpy_barrier_count++] =
-                    (VkMemoryBarrier){.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
-                                      .pNext = NULL,
-                                      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                                      .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT};
-            } else if ((dst->usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) ==
-                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
-                vb_cpy_barriers[vb_cpy_barrier_count++] =
-                    (VkMemoryBarrier){.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
-                                      .pNext = NULL,
-                                      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                                      .dstAccessMask = VK_ACCESS_INDEX_READ_BIT};
-            };
-        };
-
-        // Vertex buffer memory barriers
-        vkCmdPipelineBarrier(frame->cmd,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-                             0,
-                             vb_cpy_barrier_count,
-                             vb_cpy_barriers,
-                             0,
-                             NULL,
-                             0,
-                             NULL);
-
-        s_buffer_to_buffer_copy_count = 0;
-    }
-
-    // Buffer to image copy queue
-    if (s_buffer_to_image_copy_count > 0) {
-        VkImageMemoryBarrier sampled_barriers[MGFX_MAX_FRAME_BUFFER_COPIES];
-        uint32_t sampled_copy_count = 0;
-
-        VkImageMemoryBarrier pre_copy_barriers[MGFX_MAX_FRAME_BUFFER_COPIES];
-        uint32_t pre_copy_count = 0;
-
-        for (uint32_t i = 0; i < s_buffer_to_image_copy_count; i++) {
-            pre_copy_barriers[pre_copy_count++] = (VkImageMemoryBarrier){
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .pNext = NULL,
-                .srcAccessMask = 0,
-                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .oldLayout = s_buffer_to_image_copy_queue[i].dst->layout,
-                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = s_buffer_to_image_copy_queue[i].dst->handle,
-                .subresourceRange =
-                    {
-                        .aspectMask =
-                            s_buffer_to_image_copy_queue[i].copy.imageSubresource.aspectMask,
-                        .baseMipLevel = 0,
-                        .levelCount = 1,
-                        .baseArrayLayer =
-                            s_buffer_to_image_copy_queue[i].copy.imageSubresource.baseArrayLayer,
-                        .layerCount =
-                            s_buffer_to_image_copy_queue[i].copy.imageSubresource.layerCount,
-                    },
-            };
-            s_buffer_to_image_copy_queue[i].dst->layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    staging_deferred_process();
 
-            // TODO: Check if sampled.
-            sampled_barriers[sampled_copy_count++] = (VkImageMemoryBarrier){
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .pNext = NULL,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-                .oldLayout = s_buffer_to_image_copy_queue[i].dst->layout,
-                .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = s_buffer_to_image_copy_queue[i].dst->handle,
-                .subresourceRange =
-                    {
-                        .aspectMask =
-                            s_buffer_to_image_copy_queue[i].copy.imageSubresource.aspectMask,
-                        .baseMipLevel = 0,
-                        .levelCount = 1,
-                        .baseArrayLayer =
-                            s_buffer_to_image_copy_queue[i].copy.imageSubresource.baseArrayLayer,
-                        .layerCount =
-                            s_buffer_to_image_copy_queue[i].copy.imageSubresource.layerCount,
-                    },
-            };
+    copy_queues_record(frame->cmd);
 
-            s_buffer_to_image_copy_queue[i].dst->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        }
+    cull_dispatches_record(frame->cmd);
 
-        // Fragment Sampled image memory barriers
-        vkCmdPipelineBarrier(frame->cmd,
-                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             0,
-                             0,
-                             NULL,
-                             0,
-                             NULL,
-                             pre_copy_count,
-                             pre_copy_barriers);
+    vk_cmd_transition_image(frame->cmd,
+                            &s_swapchain.images[s_swapchain.free_idx],
+                            VK_IMAGE_ASPECT_COLOR_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL);
 
-        for (uint32_t i = 0; i < s_buffer_to_image_copy_count; i++) {
-            vkCmdCopyBufferToImage(frame->cmd,
-                                   (VkBuffer)s_buffer_to_image_copy_queue[i].src->handle,
-                                   (VkImage)s_buffer_to_image_copy_queue[i].dst->handle,
-                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                   1,
-                                   &s_buffer_to_image_copy_queue[i].copy);
-        }
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
 
-        // Fragment Sampled image memory barriers
-        vkCmdPipelineBarrier(frame->cmd,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                             0,
-                             0,
-                             NULL,
-                             0,
-                             NULL,
-                             sampled_copy_count,
-                             sampled_barriers);
+    // Merge encoder keys. Encoders have ended so their arenas are only read from here on.
+    const uint32_t encoder_count = s_encoder_count;
+    MX_ASSERT(encoder_count <= MGFX_MAX_ENCODERS);
 
-        s_buffer_to_image_copy_count = 0;
-    }
+    s_frame_keys.count = 0;
+    for (uint32_t enc_idx = 0; enc_idx < encoder_count; enc_idx++) {
+        const mgfx_encoder* enc = &s_encoders[enc_idx];
+        MX_ASSERT(!enc->recording, "[Encoder] Encoder still recording at frame end!");
 
-    // Clear transient buffers
-    for (uint32_t tsb_idx = 0; tsb_idx < s_tsbs_count; tsb_idx++) {
-        s_tsb_pool.tail = (s_tsb_pool.tail + s_tsbs[tsb_idx].size) % s_tsb_pool.size;
+        draw_stream_push(&s_frame_keys, enc->arena.keys.data, enc->arena.keys.count);
     }
-    s_tsbs_count = 0;
 
-    vk_cmd_transition_image(frame->cmd,
-                            &s_swapchain.images[s_swapchain.free_idx],
-                            VK_IMAGE_ASPECT_COLOR_BIT,
-                            VK_IMAGE_LAYOUT_GENERAL);
+    const uint32_t draw_count = s_frame_keys.count;
+    draw_stream_reserve(&s_frame_keys_scratch, draw_count);
+    const mgfx_draw_key* keys = draw_sort_keys((mgfx_draw_key*)s_frame_keys.data,
+                                               (mgfx_draw_key*)s_frame_keys_scratch.data,
+                                               draw_count);
 
-    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    // Prepare draws in sorted order. Descriptor set allocation, pipeline creation and the
+    // transient rings are not thread safe so they are resolved here before recording.
+    s_draw_cmds.count = 0;
+    s_draw_segments.count = 0;
+    s_draw_chunks.count = 0;
 
-    // Sort draws by view target, program, descriptor sets
-    qsort(s_draws, (size_t)s_draw_count, sizeof(mgfx_draw), draw_compare_fn);
+    draw_stream_reserve(&s_draw_cmds, draw_count);
 
     framebuffer_vk* fb = NULL;
-    uint8_t target = MGFX_DEFAULT_VIEW_TARGET - 1;
-
-    VkDescriptorSet flat_ds[MGFX_SHADER_MAX_DESCRIPTOR_SET];
-    uint32_t flat_ds_count = 0;
+    uint8_t target = 0;
 
     mgfx_program* cur_program = NULL;
 
-    VkBuffer cur_vbs[MGFX_SHADER_MAX_VERTEX_BINDING];
-    uint32_t cur_vert_count = 0;
-
+    // Persistent index buffer whose index count was last looked up.
     VkBuffer cur_ib = VK_NULL_HANDLE;
     uint32_t cur_idx_count = 0;
 
-    for (uint32_t draw_idx = 0; draw_idx < s_draw_count; draw_idx++) {
-        const mgfx_draw* draw = &s_draws[draw_idx];
-        program_entry* program_entry;
-        HASH_FIND(hh, s_program_table, &draw->ph, sizeof(mgfx_ph), program_entry);
+    // Draws without an index buffer reuse the previous one.
+    VkBuffer draw_ib = VK_NULL_HANDLE;
+    uint32_t draw_ib_offset = 0;
+    uint32_t draw_idx_count = 0;
 
-        MX_ASSERT(program_entry != NULL);
+    for (uint32_t key_idx = 0; key_idx < draw_count; key_idx++) {
+        const mgfx_draw_arena* arena = &s_encoders[keys[key_idx].encoder].arena;
+        const mgfx_draw* draw = &((const mgfx_draw*)arena->draws.data)[keys[key_idx].draw_idx];
+        const mgfx_dh* dhs = (const mgfx_dh*)arena->descriptors.data;
+        const uint32_t* dynamic_offsets = (const uint32_t*)arena->dynamic_offsets.data;
+        const mgfx_transient_buffer* vbs = (const mgfx_transient_buffer*)arena->vertex_buffers.data;
+        const float(*mtxs)[16] = (const float(*)[16])arena->matrices.data;
 
-        if (draw->view_target != target) {
-            target = draw->view_target;
+        mgfx_program* program = program_get(draw->ph);
 
-            if (fb != NULL) {
-                vk_cmd_end_rendering(frame->cmd);
-            }
+        if (s_draw_segments.count == 0 || draw->view_target != target) {
+            target = draw->view_target;
 
-            // Target pre pass resource barriers and transitions
-            for (uint32_t target_draw_idx = draw_idx; target_draw_idx < s_draw_count;
-                 target_draw_idx++) {
-                const mgfx_draw* target_draw = &s_draws[target_draw_idx];
+            if (target == MGFX_DEFAULT_VIEW_TARGET) {
+                fb = &s_swapchain.framebuffer;
+            } else {
+                fb = handle_pool_get(&s_framebuffers, s_view_targets[target].idx);
 
-                if (target_draw->view_target != target) {
-                    break;
+                if (!fb) {
+                    MX_LOG_ERROR("Submitting to unknown view target '%d'! Please call "
+                                 "mgfx_set_view_target().",
+                                 target);
                 }
+            }
 
-                for (uint32_t ds_idx = 0; ds_idx < MGFX_SHADER_MAX_DESCRIPTOR_SET; ds_idx++) {
-                    if (target_draw->desc_sets[ds_idx].dh_count <= 0) {
-                        continue;
-                    }
+            const draw_segment_vk segment = {
+                .fb = fb,
+                .target = target,
+                .first_key = key_idx,
+                .first_chunk = s_draw_chunks.count,
+            };
+            draw_stream_push(&s_draw_segments, &segment, 1);
 
-                    for (uint32_t bind_idx = 0; bind_idx < target_draw->desc_sets[ds_idx].dh_count;
-                         bind_idx++) {
-                        mgfx_dh dh = target_draw->desc_sets[ds_idx].dhs[bind_idx];
-                        const descriptor_entry* descriptor_entry;
-
-                        HASH_FIND(hh, s_descriptor_table, &dh, sizeof(mgfx_dh), descriptor_entry);
-                        MX_ASSERT(descriptor_entry != NULL, "Descriptor invalid handle!");
-
-                        switch (descriptor_entry->value.type) {
-                        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-                            if (descriptor_entry->value.image->layout !=
-                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-                                switch (descriptor_entry->value.image->format) {
-                                case (VK_FORMAT_D32_SFLOAT):
-                                    vk_cmd_transition_image(
-                                        frame->cmd,
-                                        descriptor_entry->value.image,
-                                        VK_IMAGE_ASPECT_DEPTH_BIT,
-                                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-                                    break;
-                                default:
-                                    vk_cmd_transition_image(
-                                        frame->cmd,
-                                        descriptor_entry->value.image,
-                                        VK_IMAGE_ASPECT_COLOR_BIT,
-                                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-                                    break;
-                                }
-                            }
-                            break;
-                        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-                            break;
+            cur_program = NULL;
+        }
 
-                        case VK_DESCRIPTOR_TYPE_MAX_ENUM:
-                        default:
-                            MX_ASSERT(0, "Uknown descriptor set");
-                            break;
-                        }
-                    }
-                }
-            }
+        draw_segment_vk* segment =
+            &((draw_segment_vk*)s_draw_segments.data)[s_draw_segments.count - 1];
+        segment->key_count++;
 
-            if (target == MGFX_DEFAULT_VIEW_TARGET) {
-                fb = &s_swapchain.framebuffer;
-            } else {
-                framebuffer_entry* fb_entry;
-                HASH_FIND(
-                    hh, s_framebuffer_table, &s_view_targets[target], sizeof(mgfx_fbh), fb_entry);
-                fb = &fb_entry->value;
-            }
+        if (segment->chunk_count == 0 ||
+            ((draw_chunk_vk*)s_draw_chunks.data)[s_draw_chunks.count - 1].cmd_count ==
+                MGFX_DRAW_CHUNK_SIZE) {
+            const draw_chunk_vk chunk = {
+                .segment = s_draw_segments.count - 1,
+                .first_cmd = s_draw_cmds.count,
+            };
+            draw_stream_push(&s_draw_chunks, &chunk, 1);
+            segment->chunk_count++;
+        }
 
-            for (uint32_t color_attachment_idx = 0;
-                 color_attachment_idx < fb->color_attachment_count;
-                 color_attachment_idx++) {
-                vk_cmd_transition_image(frame->cmd,
-                                        fb->color_attachments[color_attachment_idx],
-                                        VK_IMAGE_ASPECT_COLOR_BIT,
-                                        VK_IMAGE_LAYOUT_GENERAL);
-
-                if (s_view_clears[target].uint32[3]) {
-                    vk_cmd_clear_image(frame->cmd,
-                                       fb->color_attachments[color_attachment_idx],
-                                       &range,
-                                       &s_view_clears[target]);
-                }
-            }
+        if (cur_program != program) {
+            cur_program = program;
 
-            if (fb->depth_attachment) {
-                vk_cmd_transition_image(frame->cmd,
-                                        fb->depth_attachment,
-                                        VK_IMAGE_ASPECT_DEPTH_BIT,
-                                        VK_IMAGE_LAYOUT_GENERAL);
+            // Pipelines are created against the first view target they are drawn to.
+            if ((VkPipeline)cur_program->pipeline == VK_NULL_HANDLE) {
+                program_create_pipeline(cur_program, fb);
             }
-
-            vk_cmd_begin_rendering(frame->cmd, fb);
-            /*MX_LOG_INFO("TARGET : %u", target);*/
-            /*for (uint32_t i = 0; i < fb->color_attachment_count; i++) {*/
-            /*    MX_LOG_INFO("color_attachment: %lu", (uint64_t)fb->color_attachment_views[i]);*/
-            /*}*/
-            /*MX_LOG_INFO("depth_attachment: %lu", (uint64_t)fb->depth_attachment_view);*/
         }
 
-        // Check program in view target.
-        if (cur_program != &program_entry->value) {
-            cur_program = &program_entry->value;
-            vkCmdBindPipeline(
-                frame->cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, (VkPipeline)cur_program->pipeline);
+        draw_cmd_vk draw_cmd = {
+            .pipeline = (VkPipeline)cur_program->pipeline,
+            .pipeline_layout = (VkPipelineLayout)cur_program->pipeline_layout,
+            .instance_count = draw->indirect_draw ? 0 : draw->instance_count,
+            .model = mtxs[draw->transform],
+            .view_block = cur_program->view_block,
+        };
+
+        if (cur_program->bindless) {
+            const uint32_t(*bindless_indices)[MGFX_BINDLESS_INDEX_COUNT] =
+                (const uint32_t(*)[MGFX_BINDLESS_INDEX_COUNT])arena->bindless_indices.data;
+            draw_cmd.bindless_indices = bindless_indices[draw->bindless_indices];
         }
 
-        flat_ds_count = 0;
+        uint32_t dh_offset = draw->descriptors;
+        uint32_t dynamic_offset = draw->dynamic_offsets;
+        uint32_t dynamic_offset_count = 0;
         for (uint32_t ds_idx = 0; ds_idx < MGFX_SHADER_MAX_DESCRIPTOR_SET; ds_idx++) {
-            if (draw->desc_sets[ds_idx].dh_count <= 0) {
+            const mgfx_dh* set_dhs = &dhs[dh_offset];
+            const uint32_t set_dh_count = draw->descriptor_counts[ds_idx];
+            dh_offset += set_dh_count;
+
+            if (set_dh_count <= 0) {
                 continue;
             }
-            uint32_t ds_hash;
-            mx_murmur_hash_32(draw->desc_sets[ds_idx].dhs,
-                              draw->desc_sets[ds_idx].dh_count * sizeof(mgfx_dh),
-                              (uint32_t)draw->ph.idx,
-                              &ds_hash);
 
-            descriptor_set_entry* ds_entry;
-            HASH_FIND_INT(s_descriptor_set_table, &ds_hash, ds_entry);
+            // Transient uniforms only change the offsets, the cached set is shared.
+            const uint32_t set_offset_count = draw->dynamic_offset_counts[ds_idx];
+            draw_cmd.set_dynamic_offsets[draw_cmd.set_count] = (uint8_t)dynamic_offset_count;
+            memcpy(&draw_cmd.dynamic_offsets[dynamic_offset_count],
+                   &dynamic_offsets[dynamic_offset],
+                   sizeof(uint32_t) * set_offset_count);
+            dynamic_offset += set_offset_count;
+            dynamic_offset_count += set_offset_count;
+            draw_cmd.set_dynamic_offsets[draw_cmd.set_count + 1] = (uint8_t)dynamic_offset_count;
+
+            draw_cmd.sets[draw_cmd.set_count++] =
+                descriptor_set_get((VkDescriptorSetLayout)cur_program->dsls[ds_idx],
+                                   set_dhs,
+                                   set_dh_count,
+                                   draw->descriptor_hashes[ds_idx]);
+        }
 
-            if (ds_entry) {
-                flat_ds[flat_ds_count++] = ds_entry->value;
-                continue;
+        if (draw->vertex_buffer_count > 0) {
+            const mgfx_transient_buffer* draw_vbs = &vbs[draw->vertex_buffers];
+            MX_ASSERT(draw->vertex_buffer_count <= MGFX_SHADER_MAX_VERTEX_BINDING);
+
+            draw_cmd.vb_count = draw->vertex_buffer_count;
+            for (uint32_t vb_idx = 0; vb_idx < draw->vertex_buffer_count; ++vb_idx) {
+                draw_cmd.vbs[vb_idx] = (VkBuffer)draw_vbs[vb_idx].buffer_handle;
+                draw_cmd.vb_offsets[vb_idx] = draw_vbs[vb_idx].offset;
             }
+        }
 
-            VkDescriptorSetAllocateInfo descriptor_set_alloc_info = {
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-                .pNext = NULL,
-                .descriptorPool = s_ds_pool,
-                .descriptorSetCount = 1,
-                .pSetLayouts = (VkDescriptorSetLayout*)&cur_program->dsls[ds_idx],
-            };
+        if (draw->ib.size == 0 && draw->ib.buffer_handle != 0) {
+            const index_buffer_vk* index_buffer =
+                handle_pool_get(&s_buffers, (uint64_t)draw->ib.buffer_handle);
 
-            ds_entry = mx_alloc(mx_default_allocator(), sizeof(descriptor_set_entry));
-            memset(ds_entry, 0, sizeof(descriptor_set_entry));
+            if (!index_buffer) {
+                MX_LOG_WARN("Index buffer invalid handle!");
+            } else if (index_buffer->handle != cur_ib) {
+                VmaAllocationInfo index_buffer_alloc_info = {0};
+                vmaGetAllocationInfo(
+                    s_allocator, index_buffer->allocation, &index_buffer_alloc_info);
+                cur_idx_count = (uint32_t)index_buffer_alloc_info.size / sizeof(uint32_t);
+
+                cur_ib = index_buffer->handle;
+            }
+
+            draw_ib = cur_ib;
+            draw_ib_offset = 0;
+            draw_idx_count = cur_idx_count;
+        }
 
-            ds_entry->key = ds_hash;
-            HASH_ADD_INT(s_descriptor_set_table, key, ds_entry);
+        if (draw->ib.size > 0) {
+            draw_ib = (VkBuffer)draw->ib.buffer_handle;
+            draw_ib_offset = draw->ib.offset;
+            draw_idx_count = draw->ib.size / sizeof(uint32_t);
+        }
+
+        MX_ASSERT(draw_ib != VK_NULL_HANDLE, "Unsupported draw method!");
+        draw_cmd.ib = draw_ib;
+        draw_cmd.ib_offset = draw_ib_offset;
+        draw_cmd.index_count = draw_idx_count;
+
+        if (draw->indirect_draw) {
+            const mgfx_draw_indirect* indirect =
+                &((const mgfx_draw_indirect*)arena->indirects.data)[draw->indirect];
+
+            draw_cmd.indirect = buffer_get(indirect->buffer.idx)->handle;
+            draw_cmd.indirect_offset = indirect->offset;
+            draw_cmd.indirect_draw_count = indirect->max_draw_count;
+            draw_cmd.indirect_stride = indirect->stride;
+            draw_cmd.indirect_count_buffer =
+                indirect->count_buffer.idx != 0 ? buffer_get(indirect->count_buffer.idx)->handle
+                                                 : VK_NULL_HANDLE;
+            draw_cmd.indirect_count_offset = indirect->count_offset;
+        }
+
+        draw_stream_push(&s_draw_cmds, &draw_cmd, 1);
+        ((draw_chunk_vk*)s_draw_chunks.data)[s_draw_chunks.count - 1].cmd_count++;
+    }
+
+    // Record chunks in parallel, worker `i` uses its own per frame command pool.
+    for (uint32_t worker = 0; worker < jobs_worker_count(); worker++) {
+        VK_CHECK(vkResetCommandPool(s_device, frame->worker_cmds[worker].pool, 0));
+        frame->worker_cmds[worker].count = 0;
+    }
 
-            VK_CHECK(
-                vkAllocateDescriptorSets(s_device, &descriptor_set_alloc_info, &ds_entry->value));
-            flat_ds[flat_ds_count++] = ds_entry->value;
+    memset(s_worker_binds, 0, sizeof(s_worker_binds));
+    memset(s_worker_binds_skipped, 0, sizeof(s_worker_binds_skipped));
 
-            for (uint32_t binding_idx = 0; binding_idx < draw->desc_sets[ds_idx].dh_count;
-                 binding_idx++) {
+    jobs_parallel_for(s_draw_chunks.count, 1, draw_record_chunks_fn, frame);
 
-                mgfx_dh dh = draw->desc_sets[ds_idx].dhs[binding_idx];
-                const descriptor_entry* descriptor_entry;
+    s_stats.binds = (mgfx_bind_counts){0};
+    s_stats.binds_skipped = (mgfx_bind_counts){0};
+    for (uint32_t worker = 0; worker < jobs_worker_count(); worker++) {
+        const mgfx_bind_counts* binds = &s_worker_binds[worker];
+        const mgfx_bind_counts* skipped = &s_worker_binds_skipped[worker];
 
-                HASH_FIND(hh, s_descriptor_table, &dh, sizeof(mgfx_dh), descriptor_entry);
-                MX_ASSERT(descriptor_entry != NULL, "Descriptor invalid handle!");
+        s_stats.binds.pipelines += binds->pipelines;
+        s_stats.binds.descriptor_sets += binds->descriptor_sets;
+        s_stats.binds.vertex_buffers += binds->vertex_buffers;
+        s_stats.binds.index_buffers += binds->index_buffers;
+        s_stats.binds.push_constants += binds->push_constants;
 
-                VkWriteDescriptorSet write = {
-                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                    .pNext = NULL,
-                    .dstSet = ds_entry->value,
-                    .dstBinding = binding_idx,
-                    .dstArrayElement = 0,
-                    .descriptorCount = 1,
-                    .descriptorType = descriptor_entry->value.type,
-                    .pImageInfo = NULL,
-                    .pBufferInfo = NULL,
-                    .pTexelBufferView = NULL,
-                };
+        s_stats.binds_skipped.pipelines += skipped->pipelines;
+        s_stats.binds_skipped.descriptor_sets += skipped->descriptor_sets;
+        s_stats.binds_skipped.vertex_buffers += skipped->vertex_buffers;
+        s_stats.binds_skipped.index_buffers += skipped->index_buffers;
+        s_stats.binds_skipped.push_constants += skipped->push_constants;
+    }
+
+    const draw_segment_vk* segments = (const draw_segment_vk*)s_draw_segments.data;
+    const draw_chunk_vk* chunks = (const draw_chunk_vk*)s_draw_chunks.data;
+
+    for (uint32_t segment_idx = 0; segment_idx < s_draw_segments.count; segment_idx++) {
+        const draw_segment_vk* segment = &segments[segment_idx];
+        fb = segment->fb;
+        target = segment->target;
+
+        // Target pre pass resource barriers and transitions
+        for (uint32_t key_idx = segment->first_key;
+             key_idx < segment->first_key + segment->key_count;
+             key_idx++) {
+            const mgfx_draw_arena* arena = &s_encoders[keys[key_idx].encoder].arena;
+            const mgfx_draw* target_draw =
+                &((const mgfx_draw*)arena->draws.data)[keys[key_idx].draw_idx];
+            const mgfx_dh* target_dhs = (const mgfx_dh*)arena->descriptors.data;
+
+            uint32_t target_dh_count = 0;
+            for (uint32_t ds_idx = 0; ds_idx < MGFX_SHADER_MAX_DESCRIPTOR_SET; ds_idx++) {
+                target_dh_count += target_draw->descriptor_counts[ds_idx];
+            }
+
+            for (uint32_t bind_idx = 0; bind_idx < target_dh_count; bind_idx++) {
+                const descriptor_info_vk* descriptor =
+                    descriptor_get(target_dhs[target_draw->descriptors + bind_idx]);
 
-                switch (descriptor_entry->value.type) {
-                case VK_DESCRIPTOR_TYPE_SAMPLER:
+                switch (descriptor->type) {
                 case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-                case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-                case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-                    write.pImageInfo = &descriptor_entry->value.image_info;
-                    MX_ASSERT(descriptor_entry->value.image->layout ==
-                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                    if (descriptor->image->layout !=
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+                        switch (descriptor->image->format) {
+                        case (VK_FORMAT_D32_SFLOAT):
+                            vk_cmd_transition_image(frame->cmd,
+                                                    descriptor->image,
+                                                    VK_IMAGE_ASPECT_DEPTH_BIT,
+                                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                            break;
+                        default:
+                            vk_cmd_transition_image(frame->cmd,
+                                                    descriptor->image,
+                                                    VK_IMAGE_ASPECT_COLOR_BIT,
+                                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                            break;
+                        }
+                    }
                     break;
-
-                case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-                case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
                 case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
                 case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-                    write.pBufferInfo = &descriptor_entry->value.buffer_info;
+                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
                     break;
 
-                case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-                case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK:
-                case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
-                case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_NV:
-                case VK_DESCRIPTOR_TYPE_SAMPLE_WEIGHT_IMAGE_QCOM:
-                case VK_DESCRIPTOR_TYPE_BLOCK_MATCH_IMAGE_QCOM:
-                case VK_DESCRIPTOR_TYPE_MUTABLE_EXT:
                 case VK_DESCRIPTOR_TYPE_MAX_ENUM:
                 default:
-                    MX_LOG_ERROR("Unsupported descriptor type!");
+                    MX_ASSERT(0, "Uknown descriptor set");
                     break;
-                };
-
-                vkUpdateDescriptorSets(s_device, 1, &write, 0, NULL);
+                }
             }
         }
 
-        if (flat_ds_count > 0) {
-            vkCmdBindDescriptorSets(frame->cmd,
-                                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                    (VkPipelineLayout)cur_program->pipeline_layout,
-                                    0,
-                                    flat_ds_count,
-                                    flat_ds,
-                                    0,
-                                    NULL);
-        }
-
-        // TODO: More robust equality check
-        if (draw->vbh_count > 0 && cur_vbs[0] != (VkBuffer)draw->vbhs[0].idx) {
-            VkDeviceSize offsets = 0;
-
-            MX_ASSERT(draw->vbh_count < MGFX_SHADER_MAX_VERTEX_BINDING);
-            memcpy(cur_vbs, draw->vbhs, draw->vbh_count);
-
-            vkCmdBindVertexBuffers(frame->cmd, 0, draw->vbh_count, (VkBuffer*)draw->vbhs, &offsets);
-        }
-
-        if (draw->tvbh_count > 0) {
-            MX_ASSERT(draw->tvbh_count < MGFX_SHADER_MAX_VERTEX_BINDING);
-            VkDeviceSize offsets[MGFX_SHADER_MAX_VERTEX_BINDING] = {0};
-
-            for (uint32_t tvb_idx = 0; tvb_idx < draw->tvbh_count; ++tvb_idx) {
-                cur_vbs[tvb_idx] = (VkBuffer)draw->tvbs[tvb_idx].buffer_handle;
-
-                offsets[tvb_idx] = draw->tvbs[tvb_idx].offset;
-                s_tvb_pool.tail =
-                    (uint32_t)((s_tvb_pool.tail + draw->tvbs[tvb_idx].size) % s_tvb_pool.size);
+        for (uint32_t color_attachment_idx = 0; color_attachment_idx < fb->color_attachment_count;
+             color_attachment_idx++) {
+            vk_cmd_transition_image(frame->cmd,
+                                    fb->color_attachments[color_attachment_idx],
+                                    VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_IMAGE_LAYOUT_GENERAL);
+
+            if (s_view_clears[target].uint32[3]) {
+                vk_cmd_clear_image(frame->cmd,
+                                   fb->color_attachments[color_attachment_idx],
+                                   &range,
+                                   &s_view_clears[target]);
             }
-
-            vkCmdBindVertexBuffers(frame->cmd, 0, draw->tvbh_count, cur_vbs, offsets);
         }
 
-        if ((VkBuffer)draw->ibh.idx != VK_NULL_HANDLE && (VkBuffer)draw->ibh.idx != cur_ib) {
-            VkDeviceSize offset = 0;
-
-            const buffer_entry* index_buffer_entry;
-            HASH_FIND(hh, s_buffer_table, &draw->ibh, sizeof(mgfx_ibh), index_buffer_entry);
-
-            if (index_buffer_entry) {
-                VmaAllocationInfo index_buffer_alloc_info = {0};
-                vmaGetAllocationInfo(
-                    s_allocator, index_buffer_entry->value.allocation, &index_buffer_alloc_info);
-                cur_idx_count = (uint32_t)index_buffer_alloc_info.size / sizeof(uint32_t);
-            } else {
-                MX_LOG_WARN("Index buffer invalid handle!");
-            }
-
-            cur_ib = (VkBuffer)draw->ibh.idx;
-            vkCmdBindIndexBuffer(frame->cmd, cur_ib, 0, VK_INDEX_TYPE_UINT32);
+        if (fb->depth_attachment) {
+            vk_cmd_transition_image(frame->cmd,
+                                    fb->depth_attachment,
+                                    VK_IMAGE_ASPECT_DEPTH_BIT,
+                                    VK_IMAGE_LAYOUT_GENERAL);
         }
 
-        if ((VkBuffer)draw->tib.buffer_handle != VK_NULL_HANDLE) {
-            if ((VkBuffer)draw->tib.buffer_handle != cur_ib) {
-                cur_ib = (VkBuffer)draw->tib.buffer_handle;
-            };
+        vk_cmd_begin_rendering(frame->cmd, fb, VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
 
-            vkCmdBindIndexBuffer(frame->cmd, cur_ib, draw->tib.offset, VK_INDEX_TYPE_UINT32);
-            cur_idx_count = draw->tib.size / sizeof(uint32_t);
-            s_tib_pool.tail = (s_tib_pool.tail + draw->tib.size) % s_tib_pool.size;
+        for (uint32_t chunk_idx = segment->first_chunk;
+             chunk_idx < segment->first_chunk + segment->chunk_count;
+             chunk_idx++) {
+            vkCmdExecuteCommands(frame->cmd, 1, &chunks[chunk_idx].cmd);
         }
 
-        vkCmdPushConstants(frame->cmd,
-                           (VkPipelineLayout)cur_program->pipeline_layout,
-                           VK_SHADER_STAGE_VERTEX_BIT,
-                           0,
-                           sizeof(draw->draw_pc),
-                           &draw->draw_pc);
-
-        if (cur_ib) {
-            vkCmdDrawIndexed(frame->cmd, cur_idx_count, 1, 0, 0, 0);
-        } else {
-            MX_ASSERT(MX_FALSE, "Unsupported draw method!");
-            vkCmdDraw(frame->cmd, cur_vert_count, 1, 0, 0);
-        }
+        vk_cmd_end_rendering(frame->cmd);
     }
 
     // Clear draws
-    memset(s_draws, 0, s_draw_count * sizeof(mgfx_draw));
-    s_draw_count = 0;
+    s_stats.draw_count = draw_count;
+    s_stats.draw_bytes = (size_t)s_frame_keys.count * s_frame_keys.stride;
+    s_stats.draw_arena_capacity = (size_t)s_frame_keys.capacity * s_frame_keys.stride +
+                                  (size_t)s_frame_keys_scratch.capacity * s_frame_keys_scratch.stride;
+
+    for (uint32_t enc_idx = 0; enc_idx < encoder_count; enc_idx++) {
+        s_stats.draw_bytes += draw_arena_size(&s_encoders[enc_idx].arena);
+        draw_arena_reset(&s_encoders[enc_idx].arena);
+    }
 
-    if (fb != NULL) {
-        vk_cmd_end_rendering(frame->cmd);
+    for (uint32_t enc_idx = 0; enc_idx < MGFX_MAX_ENCODERS; enc_idx++) {
+        s_stats.draw_arena_capacity += draw_arena_capacity(&s_encoders[enc_idx].arena);
+    }
+
+    s_encoder_count = 1;
+
+    if (s_staging_frame_bytes > s_staging_peak_bytes) {
+        s_staging_peak_bytes = s_staging_frame_bytes;
     }
+    s_staging_total_bytes += s_staging_frame_bytes;
+
+    s_stats.staging_bytes = s_staging_frame_bytes;
+    s_stats.staging_bytes_peak = s_staging_peak_bytes;
+    s_stats.staging_bytes_average = (double)s_staging_total_bytes / (double)(s_frame_ctr + 1);
+    s_stats.staging_capacity = s_tsb_pool.capacity;
+    s_stats.staging_deferred_bytes = staging_deferred_size();
+    s_stats.texture_loads = s_texture_loads.count;
+    s_stats.samplers = HASH_CNT(hh, s_samplers);
+    s_stats.image_views = HASH_CNT(hh, s_image_views);
+    s_stats.descriptor_sets = s_descriptor_set_count;
+    s_stats.descriptor_pools = s_ds_pools.count;
+    s_staging_frame_bytes = 0;
+    s_upload_streamed_bytes = 0;
 
     vk_cmd_transition_image(frame->cmd,
                             &s_swapchain.images[s_swapchain.free_idx],
@@ -2767,6 +6550,15 @@ void mgfx_frame() {
         .pSignalSemaphores = &frame->render_semaphore,
     };
     VK_CHECK(vkQueueSubmit(s_queues[MGFX_QUEUE_GRAPHICS], 1, &submit_info, frame->render_fence));
+    deletion_queue_submit(s_frame_idx);
+    transient_ring_submit(&s_tvb_pool, s_frame_idx);
+    transient_ring_submit(&s_tib_pool, s_frame_idx);
+    transient_ring_submit(&s_tsb_pool, s_frame_idx);
+    staging_uploads_submit(s_frame_idx);
+
+    // Transient uniforms written from here on belong to the next submit.
+    s_tub_region = (s_tub_region + 1) % MGFX_TRANSIENT_UNIFORM_REGIONS;
+    s_tub_head = 0;
 
     VkPresentInfoKHR present_info = {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -2894,16 +6686,16 @@ void mgfx_debug_draw_text(int32_t x, int32_t y, const char* fmt, ...) {
     s_height = 720;
     const real_t right = (real_t)s_width;
     const real_t top = (real_t)s_height;
-    mgfx_set_proj(mx_ortho(0.0f, right, 0.0, top, -100.0f, 100.0f).val);
+    mx_mat4 proj = mx_ortho(0.0f, right, 0.0, top, -100.0f, 100.0f);
 
     mx_vec3 ui_cam_pos = {0, 0, 2};
     mx_vec3 ui_inverse_pos = mx_vec3_scale(ui_cam_pos, -1.0f);
 
     mx_mat4 view = mx_translate(ui_inverse_pos);
-    mgfx_set_view(view.val);
 
+    // Text shares the target with scene draws, push the full transform instead of a view block.
     mx_mat4 model = mx_translate((mx_vec3){(float)x, (float)y, -1.0});
-    mgfx_set_transform(model.val);
+    mgfx_set_transform(mx_mat4_mul(proj, mx_mat4_mul(view, model)).val);
 
     mgfx_transient_buffer tvb = {0};
     mgfx_transient_vertex_buffer_allocate(vertices, vertex_count * sizeof(glyph_vertex), &tvb);
@@ -2919,6 +6711,8 @@ void mgfx_debug_draw_text(int32_t x, int32_t y, const char* fmt, ...) {
 }
 
 void mgfx_shutdown() {
+    texture_loads_destroy();
+
     // Destroy built in
     mgfx_texture_destroy(MGFX_WHITE_TEXTURE, MX_TRUE);
     mgfx_texture_destroy(MGFX_BLACK_TEXTURE, MX_TRUE);
@@ -2935,24 +6729,114 @@ void mgfx_shutdown() {
     mgfx_shader_destroy(dbg_ui_fsh);
     mgfx_program_destroy(dbg_ui_ph);
 
+    // Shutdown culling
+    mgfx_program_destroy(s_cull_ph);
+    mgfx_shader_destroy(s_cull_csh);
+    draw_stream_destroy(&s_cull_dispatches);
+
     // Destroy vulkan renderer
     VK_CHECK(vkDeviceWaitIdle(s_device));
 
-    buffer_destroy(&s_tsb_pool.buffer);
-    buffer_destroy(&s_tvb_pool.buffer);
-    buffer_destroy(&s_tib_pool.buffer);
+    for (uint32_t priority = 0; priority < MGFX_UPLOAD_PRIORITY_COUNT; priority++) {
+        staging_upload_vk* uploads = (staging_upload_vk*)s_staging_deferred[priority].data;
+        for (uint32_t i = 0; i < s_staging_deferred[priority].count; i++) {
+            mx_free(mx_default_allocator(), uploads[i].data);
+        }
+        draw_stream_destroy(&s_staging_deferred[priority]);
+    }
+
+    for (uint32_t i = 0; i < MGFX_FRAME_COUNT; i++) {
+        draw_stream_destroy(&s_uploads_in_flight[i]);
+    }
+    draw_stream_destroy(&s_uploads_staged);
+
+    draw_stream_destroy(&s_buffer_copies);
+    draw_stream_destroy(&s_image_copies);
+    draw_stream_destroy(&s_buffer_copies_sorted);
+    draw_stream_destroy(&s_image_copies_sorted);
+    draw_stream_destroy(&s_copy_keys);
+    draw_stream_destroy(&s_copy_keys_scratch);
+    draw_stream_destroy(&s_copy_barriers);
+    draw_stream_destroy(&s_copy_buffer_regions);
+    draw_stream_destroy(&s_copy_image_regions);
+    draw_stream_destroy(&s_copy_mip_images);
+
+    transient_ring_destroy(&s_tsb_pool);
+    transient_ring_destroy(&s_tvb_pool);
+    transient_ring_destroy(&s_tib_pool);
+
+    buffer_destroy(&s_view_buffer);
+    buffer_destroy(&s_tub_buffer);
+    vkDestroyDescriptorSetLayout(s_device, s_view_dsl, NULL);
+
+    // Views and samplers still referenced by leaked textures and framebuffers.
+    image_view_entry_vk *view_entry, *view_tmp;
+    HASH_ITER(hh, s_image_views, view_entry, view_tmp) { image_view_entry_destroy(view_entry); }
+
+    sampler_entry_vk *sampler_entry, *sampler_tmp;
+    HASH_ITER(hh, s_samplers, sampler_entry, sampler_tmp) { sampler_entry_destroy(sampler_entry); }
+
+    // Cached sets are returned with their pools below.
+    descriptor_set_entry *set_entry, *set_tmp;
+    HASH_ITER(hh, s_descriptor_set_table, set_entry, set_tmp) {
+        HASH_DELETE(hh, s_descriptor_set_table, set_entry);
+        mx_free(mx_default_allocator(), set_entry);
+    }
+    s_descriptor_set_lru_head = s_descriptor_set_lru_tail = NULL;
+    s_descriptor_set_count = 0;
+
+    // Nothing is in flight once the device is idle.
+    for (uint32_t i = 0; i < MGFX_FRAME_COUNT; i++) {
+        deletion_queue_flush(&s_deletions[i]);
+        draw_stream_destroy(&s_deletions[i]);
+    }
+    deletion_queue_flush(&s_deletions_pending);
+    draw_stream_destroy(&s_deletions_pending);
+
+    if (s_bindless) {
+        vkDestroyDescriptorPool(s_device, s_bindless_pool, NULL);
+        vkDestroyDescriptorSetLayout(s_device, s_bindless_dsl, NULL);
 
-    vkDestroyDescriptorPool(s_device, s_ds_pool, NULL);
+        for (uint32_t i = 0; i < MGFX_FRAME_COUNT; i++) {
+            draw_stream_destroy(&s_bindless_writes[i]);
+        }
+    }
+    for (uint32_t i = 0; i < s_ds_pools.count; i++) {
+        vkDestroyDescriptorPool(s_device, ((VkDescriptorPool*)s_ds_pools.data)[i], NULL);
+    }
+    draw_stream_destroy(&s_ds_pools);
 
-    shader_entry *current_entry, *tmp;
-    HASH_ITER(hh, s_shader_table, current_entry, tmp) {
-        HASH_DEL(s_shader_table, current_entry); // Remove from hashmap
-        free(current_entry);                     // Free allocated memory
+    for (uint32_t enc_idx = 0; enc_idx < MGFX_MAX_ENCODERS; enc_idx++) {
+        draw_arena_destroy(&s_encoders[enc_idx].arena);
     }
+    draw_stream_destroy(&s_frame_keys);
+    draw_stream_destroy(&s_frame_keys_scratch);
+    draw_stream_destroy(&s_draw_cmds);
+    draw_stream_destroy(&s_draw_segments);
+    draw_stream_destroy(&s_draw_chunks);
+
+    handle_pool_destroy(&s_buffers);
+    handle_pool_destroy(&s_shaders);
+    handle_pool_destroy(&s_programs);
+    handle_pool_destroy(&s_descriptors);
+    handle_pool_destroy(&s_framebuffers);
+    handle_pool_destroy(&s_uploads);
+    handle_pool_destroy(&s_textures);
+    handle_pool_destroy(&s_images);
+    handle_pool_destroy(&s_culls);
 
     for (int i = 0; i < MGFX_FRAME_COUNT; i++) {
         vkDestroyCommandPool(s_device, s_frames[i].cmd_pool, NULL);
 
+        for (uint32_t worker = 0; worker < jobs_worker_count(); worker++) {
+            secondary_cmds_vk* worker_cmds = &s_frames[i].worker_cmds[worker];
+            vkDestroyCommandPool(s_device, worker_cmds->pool, NULL);
+
+            if (worker_cmds->cmds) {
+                mx_free(mx_default_allocator(), worker_cmds->cmds);
+            }
+        }
+
         vkDestroySemaphore(s_device, s_frames[i].render_semaphore, NULL);
         vkDestroyFence(s_device, s_frames[i].render_fence, NULL);
 
@@ -2970,8 +6854,12 @@ void mgfx_shutdown() {
 #endif
 
     vkDestroyInstance(s_instance, NULL);
+
+    jobs_shutdown();
 }
 
+const mgfx_stats* mgfx_get_stats() { return &s_stats; }
+
 void mgfx_reset(uint32_t width, uint32_t height) {
     MX_LOG_TRACE("Window resized to (%d, %d)", width, height);
     s_width = width;
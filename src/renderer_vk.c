@@ -393,12 +393,38 @@ uint32_t vk_format_size(VkFormat format) {
         result = 4;
         break;
 
+    // Block compressed formats are sized per 4x4 block.
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+        result = 8;
+        break;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        result = 16;
+        break;
+
     default:
         break;
     }
     return result;
 }
 
+uint32_t vk_format_block_extent(VkFormat format) {
+    return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK ? 4 : 1;
+}
+
 VkResult get_window_surface_vk(VkInstance instance, void* nwh, VkSurfaceKHR* surface) {
     GLFWwindow* window = (GLFWwindow*)nwh;
     return glfwCreateWindowSurface(instance, window, NULL, surface);
@@ -664,7 +690,7 @@ void vk_cmd_clear_image(VkCommandBuffer cmd,
     vkCmdClearColorImage(cmd, target->handle, target->layout, clear, 1, range);
 }
 
-void vk_cmd_begin_rendering(VkCommandBuffer cmd, framebuffer_vk* fb) {
+void vk_cmd_begin_rendering(VkCommandBuffer cmd, framebuffer_vk* fb, VkRenderingFlags flags) {
     int width = 0;
     int height = 0;
 
@@ -721,7 +747,7 @@ void vk_cmd_begin_rendering(VkCommandBuffer cmd, framebuffer_vk* fb) {
     VkRenderingInfo rendering_info = {
         .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
         .pNext = NULL,
-        .flags = 0,
+        .flags = flags,
         .renderArea = {.offset = {0, 0}, .extent = {width, height}},
         .layerCount = 1,
         .viewMask = 0,
@@ -733,6 +759,24 @@ void vk_cmd_begin_rendering(VkCommandBuffer cmd, framebuffer_vk* fb) {
 
     vk_cmd_begin_rendering_khr(cmd, &rendering_info);
 
+    // Dynamic state is not inherited, secondary command buffers set their own.
+    if ((flags & VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT) == 0) {
+        vk_cmd_set_viewport(cmd, fb);
+    }
+}
+
+void vk_cmd_set_viewport(VkCommandBuffer cmd, const framebuffer_vk* fb) {
+    int width = 0;
+    int height = 0;
+
+    if (fb->color_attachment_count > 0) {
+        width = fb->color_attachments[0]->extent.width;
+        height = fb->color_attachments[0]->extent.height;
+    } else if (fb->depth_attachment) {
+        width = fb->depth_attachment->extent.width;
+        height = fb->depth_attachment->extent.height;
+    }
+
     // Flipped view port to align with openGL style convention.
     VkViewport view_port = {
         .x = 0,
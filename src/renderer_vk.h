@@ -11,6 +11,8 @@
 
 #include "mgfx/defines.h"
 
+#include "jobs.h"
+
 #ifdef _MSC_VER
 #define VK_CHECK(call)                                                                             \
     do {                                                                                           \
@@ -31,7 +33,10 @@
     } while (0)
 #endif
 
+// Bytes per texel, or per block of block compressed formats.
 uint32_t vk_format_size(VkFormat format);
+// Width and height of a block in texels, 1 for formats that are not block compressed.
+uint32_t vk_format_block_extent(VkFormat format);
 
 VkResult get_window_surface_vk(VkInstance instance, void* window, VkSurfaceKHR* surface);
 
@@ -48,10 +53,20 @@ void choose_swapchain_extent_vk(const VkSurfaceCapabilitiesKHR* surface_caps,
 
 enum { MGFX_FRAME_0, MGFX_FRAME_1, MGFX_FRAME_COUNT };
 
+// Secondary command buffers recorded by a single job worker, reused every frame.
+typedef struct secondary_cmds_vk {
+    VkCommandPool pool;
+    VkCommandBuffer* cmds;
+    uint32_t count;
+    uint32_t capacity;
+} secondary_cmds_vk;
+
 typedef struct frame_vk {
     VkCommandPool cmd_pool;
     VkCommandBuffer cmd;
 
+    secondary_cmds_vk worker_cmds[MGFX_JOBS_MAX_WORKERS];
+
     VkSemaphore render_semaphore;
     VkFence render_fence;
 
@@ -64,6 +79,10 @@ typedef struct image_vk {
     VkImageLayout layout;
 
     uint32_t layer_count;
+    uint32_t mip_levels;
+    mx_bool generate_mips; // Uploads to level 0 rebuild the other levels.
+
+    uint32_t deferred_uploads[MGFX_UPLOAD_PRIORITY_COUNT]; // Waiting in each staging queue.
 
     VkImage handle;
     VmaAllocation allocation;
@@ -107,22 +126,20 @@ typedef struct buffer_vk {
     VmaAllocation allocation;
     VkBuffer handle;
     VkBufferUsageFlags usage;
+
+    uint32_t deferred_uploads[MGFX_UPLOAD_PRIORITY_COUNT]; // Waiting in each staging queue.
 } buffer_vk;
 
 typedef buffer_vk vertex_buffer_vk;
 typedef buffer_vk index_buffer_vk;
 typedef buffer_vk uniform_buffer_vk;
-
-typedef struct ring_buffer_vk {
-    buffer_vk buffer;
-    size_t size;
-    uint32_t head;
-    uint32_t tail;
-} ring_buffer_vk;
+typedef buffer_vk indirect_buffer_vk;
+typedef buffer_vk storage_buffer_vk;
 
 typedef struct descriptor_set_info_vk {
     VkDescriptorSetLayoutBinding bindings[MGFX_SHADER_MAX_DESCRIPTOR_BINDING];
     uint32_t binding_count;
+    mx_bool bindless; // Reads the global bindless arrays instead of a set of its own.
 } descriptor_set_info_vk;
 
 typedef struct shader_vk {
@@ -154,6 +171,9 @@ typedef struct descriptor_info_vk {
         image_vk* image;
         buffer_vk* buffer;
     };
+
+    uint64_t texture; // mgfx_th of image descriptors.
+    uint32_t version; // Bumped whenever the written resources change.
 } descriptor_info_vk;
 
 // TODO: Remove.
@@ -163,14 +183,16 @@ extern PFN_vkCmdEndRenderingKHR vk_cmd_end_rendering_khr;
 // Commands.
 typedef struct buffer_to_buffer_copy_vk {
     VkBufferCopy copy;
-    const buffer_vk* src;
+    VkBuffer src;
     buffer_vk* dst;
 } buffer_to_buffer_copy_vk;
 
 typedef struct buffer_to_image_copy_vk {
     VkBufferImageCopy copy;
-    const buffer_vk* src;
+    VkBuffer src;
     image_vk* dst;
+
+    mx_bool generate_mips; // Last piece of an upload into a mipmapped image.
 } buffer_to_image_copy_vk;
 
 void vk_cmd_transition_image(VkCommandBuffer cmd,
@@ -188,7 +210,8 @@ void vk_cmd_copy_image_to_image(VkCommandBuffer cmd,
                                 VkImageAspectFlags aspect,
                                 image_vk* dst);
 
-void vk_cmd_begin_rendering(VkCommandBuffer cmd, framebuffer_vk* fb);
+void vk_cmd_begin_rendering(VkCommandBuffer cmd, framebuffer_vk* fb, VkRenderingFlags flags);
+void vk_cmd_set_viewport(VkCommandBuffer cmd, const framebuffer_vk* fb);
 void vk_cmd_end_rendering(VkCommandBuffer cmd);
 
 #endif
@@ -0,0 +1,387 @@
+#include "bc_encode.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MGFX_BC_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MGFX_BC_NEON
+#endif
+
+// Texels are split into one array per channel so four texels project per simd lane group.
+typedef struct bc_block {
+    float channels[4][BC_BLOCK_TEXELS];
+    uint32_t channel_count;
+} bc_block;
+
+static void bc_block_load(const uint8_t* texels, uint32_t channel_count, bc_block* block) {
+    block->channel_count = channel_count;
+    for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+        for (uint32_t ch = 0; ch < channel_count; ch++) {
+            block->channels[ch][i] = (float)texels[i * 4 + ch];
+        }
+    }
+}
+
+static float bc_clamp(float value, float lo, float hi) {
+    return value < lo ? lo : (value > hi ? hi : value);
+}
+
+// Endpoints are the extreme texels along the principal axis of the block.
+static void bc_endpoints(const bc_block* block, float e0[4], float e1[4]) {
+    const uint32_t n = block->channel_count;
+
+    float mean[4] = {0};
+    for (uint32_t ch = 0; ch < n; ch++) {
+        for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+            mean[ch] += block->channels[ch][i];
+        }
+        mean[ch] /= BC_BLOCK_TEXELS;
+    }
+
+    float cov[4][4] = {0};
+    for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+        for (uint32_t a = 0; a < n; a++) {
+            const float da = block->channels[a][i] - mean[a];
+            for (uint32_t b = a; b < n; b++) {
+                cov[a][b] += da * (block->channels[b][i] - mean[b]);
+            }
+        }
+    }
+    for (uint32_t a = 0; a < n; a++) {
+        for (uint32_t b = 0; b < a; b++) {
+            cov[a][b] = cov[b][a];
+        }
+    }
+
+    // Power iteration from the channel with the largest variance.
+    float axis[4] = {0};
+    uint32_t widest = 0;
+    for (uint32_t ch = 1; ch < n; ch++) {
+        widest = cov[ch][ch] > cov[widest][widest] ? ch : widest;
+    }
+    axis[widest] = 1.0f;
+
+    for (uint32_t iter = 0; iter < 8; iter++) {
+        float next[4] = {0};
+        float len2 = 0.0f;
+        for (uint32_t a = 0; a < n; a++) {
+            for (uint32_t b = 0; b < n; b++) {
+                next[a] += cov[a][b] * axis[b];
+            }
+            len2 += next[a] * next[a];
+        }
+
+        if (len2 < 1e-12f) {
+            break;
+        }
+
+        const float inv_len = 1.0f / sqrtf(len2);
+        for (uint32_t a = 0; a < n; a++) {
+            axis[a] = next[a] * inv_len;
+        }
+    }
+
+    float t_min = 0.0f;
+    float t_max = 0.0f;
+    for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+        float t = 0.0f;
+        for (uint32_t ch = 0; ch < n; ch++) {
+            t += (block->channels[ch][i] - mean[ch]) * axis[ch];
+        }
+        t_min = t < t_min ? t : t_min;
+        t_max = t > t_max ? t : t_max;
+    }
+
+    for (uint32_t ch = 0; ch < 4; ch++) {
+        e0[ch] = ch < n ? bc_clamp(mean[ch] + axis[ch] * t_min, 0.0f, 255.0f) : 0.0f;
+        e1[ch] = ch < n ? bc_clamp(mean[ch] + axis[ch] * t_max, 0.0f, 255.0f) : 0.0f;
+    }
+}
+
+// Picks the nearest of `steps` evenly spaced points from e0 to e1 for every texel.
+static void bc_project(const bc_block* block,
+                       const float e0[4],
+                       const float e1[4],
+                       uint32_t steps,
+                       uint8_t indices[BC_BLOCK_TEXELS]) {
+    const uint32_t n = block->channel_count;
+
+    float dir[4] = {0};
+    float len2 = 0.0f;
+    for (uint32_t ch = 0; ch < n; ch++) {
+        dir[ch] = e1[ch] - e0[ch];
+        len2 += dir[ch] * dir[ch];
+    }
+
+    if (len2 < 1e-6f) {
+        memset(indices, 0, BC_BLOCK_TEXELS);
+        return;
+    }
+
+    const float scale = (float)(steps - 1) / len2;
+    const float max_step = (float)(steps - 1);
+
+    uint32_t i = 0;
+#if defined(MGFX_BC_SSE)
+    for (; i < BC_BLOCK_TEXELS; i += 4) {
+        __m128 t = _mm_setzero_ps();
+        for (uint32_t ch = 0; ch < n; ch++) {
+            const __m128 d = _mm_sub_ps(_mm_loadu_ps(&block->channels[ch][i]), _mm_set1_ps(e0[ch]));
+            t = _mm_add_ps(t, _mm_mul_ps(d, _mm_set1_ps(dir[ch] * scale)));
+        }
+        t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(max_step));
+
+        int32_t steps_i[4];
+        _mm_storeu_si128((__m128i*)steps_i, _mm_cvttps_epi32(_mm_add_ps(t, _mm_set1_ps(0.5f))));
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            indices[i + lane] = (uint8_t)steps_i[lane];
+        }
+    }
+#elif defined(MGFX_BC_NEON)
+    for (; i < BC_BLOCK_TEXELS; i += 4) {
+        float32x4_t t = vdupq_n_f32(0.0f);
+        for (uint32_t ch = 0; ch < n; ch++) {
+            const float32x4_t texels = vld1q_f32(&block->channels[ch][i]);
+            const float32x4_t d = vsubq_f32(texels, vdupq_n_f32(e0[ch]));
+            t = vmlaq_f32(t, d, vdupq_n_f32(dir[ch] * scale));
+        }
+        t = vminq_f32(vmaxq_f32(t, vdupq_n_f32(0.0f)), vdupq_n_f32(max_step));
+
+        uint32_t steps_u[4];
+        vst1q_u32(steps_u, vcvtq_u32_f32(vaddq_f32(t, vdupq_n_f32(0.5f))));
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            indices[i + lane] = (uint8_t)steps_u[lane];
+        }
+    }
+#endif
+
+    for (; i < BC_BLOCK_TEXELS; i++) {
+        float t = 0.0f;
+        for (uint32_t ch = 0; ch < n; ch++) {
+            t += (block->channels[ch][i] - e0[ch]) * dir[ch] * scale;
+        }
+        indices[i] = (uint8_t)(bc_clamp(t, 0.0f, max_step) + 0.5f);
+    }
+}
+
+// Least squares endpoints for the chosen steps, one refinement pass after the axis fit.
+static void bc_refine(const bc_block* block,
+                      const uint8_t indices[BC_BLOCK_TEXELS],
+                      uint32_t steps,
+                      float e0[4],
+                      float e1[4]) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {0}, bx[4] = {0};
+    for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+        const float b = (float)indices[i] / (float)(steps - 1);
+        const float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t ch = 0; ch < block->channel_count; ch++) {
+            ax[ch] += a * block->channels[ch][i];
+            bx[ch] += b * block->channels[ch][i];
+        }
+    }
+
+    const float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f) {
+        return;
+    }
+
+    const float inv_det = 1.0f / det;
+    for (uint32_t ch = 0; ch < block->channel_count; ch++) {
+        e0[ch] = bc_clamp((bb * ax[ch] - ab * bx[ch]) * inv_det, 0.0f, 255.0f);
+        e1[ch] = bc_clamp((aa * bx[ch] - ab * ax[ch]) * inv_det, 0.0f, 255.0f);
+    }
+}
+
+static uint32_t bc_quantize(float value, uint32_t max) {
+    return (uint32_t)(bc_clamp(value, 0.0f, 255.0f) * max / 255.0f + 0.5f);
+}
+
+static uint16_t bc1_pack_565(const float color[4]) {
+    return (uint16_t)(bc_quantize(color[0], 31) << 11 | bc_quantize(color[1], 63) << 5 |
+                      bc_quantize(color[2], 31));
+}
+
+static void bc1_unpack_565(uint16_t packed, float color[4]) {
+    const uint32_t r = (packed >> 11) & 31;
+    const uint32_t g = (packed >> 5) & 63;
+    const uint32_t b = packed & 31;
+
+    color[0] = (float)(r << 3 | r >> 2);
+    color[1] = (float)(g << 2 | g >> 4);
+    color[2] = (float)(b << 3 | b >> 2);
+    color[3] = 0.0f;
+}
+
+void bc1_encode_block(const uint8_t texels[BC_BLOCK_TEXELS * 4], uint8_t block[8]) {
+    bc_block src;
+    bc_block_load(texels, 3, &src);
+
+    float e0[4], e1[4];
+    bc_endpoints(&src, e0, e1);
+
+    uint8_t steps[BC_BLOCK_TEXELS];
+    bc_project(&src, e0, e1, 4, steps);
+    bc_refine(&src, steps, 4, e0, e1);
+
+    // Four color mode requires color0 > color1.
+    uint16_t c0 = bc1_pack_565(e1);
+    uint16_t c1 = bc1_pack_565(e0);
+    if (c0 < c1) {
+        const uint16_t tmp = c0;
+        c0 = c1;
+        c1 = tmp;
+    }
+
+    uint32_t bits = 0;
+    if (c0 != c1) {
+        float d0[4], d1[4];
+        bc1_unpack_565(c0, d0);
+        bc1_unpack_565(c1, d1);
+        bc_project(&src, d0, d1, 4, steps);
+
+        // Palette order is color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1.
+        static const uint32_t k_step_index[4] = {0, 2, 3, 1};
+        for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+            bits |= k_step_index[steps[i]] << (i * 2);
+        }
+    }
+
+    block[0] = (uint8_t)c0;
+    block[1] = (uint8_t)(c0 >> 8);
+    block[2] = (uint8_t)c1;
+    block[3] = (uint8_t)(c1 >> 8);
+    for (uint32_t i = 0; i < 4; i++) {
+        block[4 + i] = (uint8_t)(bits >> (i * 8));
+    }
+}
+
+void bc4_encode_block(const uint8_t values[BC_BLOCK_TEXELS], uint8_t block[8]) {
+    uint8_t lo = 255;
+    uint8_t hi = 0;
+    bc_block src = {.channel_count = 1};
+    for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+        lo = values[i] < lo ? values[i] : lo;
+        hi = values[i] > hi ? values[i] : hi;
+        src.channels[0][i] = (float)values[i];
+    }
+
+    // Eight value mode requires red0 > red1.
+    uint64_t bits = 0;
+    if (hi != lo) {
+        const float e0[4] = {(float)hi};
+        const float e1[4] = {(float)lo};
+
+        uint8_t steps[BC_BLOCK_TEXELS];
+        bc_project(&src, e0, e1, 8, steps);
+
+        // Palette order is red0, red1, then the six interpolated values from red0 to red1.
+        for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+            const uint64_t index = steps[i] == 0 ? 0 : (steps[i] == 7 ? 1 : steps[i] + 1);
+            bits |= index << (i * 3);
+        }
+    }
+
+    block[0] = hi;
+    block[1] = lo;
+    for (uint32_t i = 0; i < 6; i++) {
+        block[2 + i] = (uint8_t)(bits >> (i * 8));
+    }
+}
+
+void bc5_encode_block(const uint8_t texels[BC_BLOCK_TEXELS * 4], uint8_t block[16]) {
+    uint8_t red[BC_BLOCK_TEXELS];
+    uint8_t green[BC_BLOCK_TEXELS];
+    for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+        red[i] = texels[i * 4 + 0];
+        green[i] = texels[i * 4 + 1];
+    }
+
+    bc4_encode_block(red, block);
+    bc4_encode_block(green, block + 8);
+}
+
+static void bc7_bits_write(uint8_t block[16], uint32_t* offset, uint32_t value, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++, (*offset)++) {
+        block[*offset / 8] |= (uint8_t)(((value >> i) & 1) << (*offset % 8));
+    }
+}
+
+// Mode 6 stores 7 bit endpoints with a shared low bit per endpoint, keeps whichever p bit
+// reconstructs the endpoint with the least error.
+static void bc7_quantize(const float endpoint[4], uint32_t quantized[4], uint32_t* pbit) {
+    float best_error = INFINITY;
+    for (uint32_t p = 0; p < 2; p++) {
+        uint32_t q[4];
+        float error = 0.0f;
+        for (uint32_t ch = 0; ch < 4; ch++) {
+            const float value = bc_clamp((endpoint[ch] - (float)p) * 0.5f + 0.5f, 0.0f, 127.0f);
+            q[ch] = (uint32_t)value;
+
+            const float diff = (float)(q[ch] * 2 + p) - endpoint[ch];
+            error += diff * diff;
+        }
+
+        if (error < best_error) {
+            best_error = error;
+            memcpy(quantized, q, sizeof(q));
+            *pbit = p;
+        }
+    }
+}
+
+void bc7_encode_block(const uint8_t texels[BC_BLOCK_TEXELS * 4], uint8_t block[16]) {
+    bc_block src;
+    bc_block_load(texels, 4, &src);
+
+    float e[2][4];
+    bc_endpoints(&src, e[0], e[1]);
+
+    uint8_t steps[BC_BLOCK_TEXELS];
+    bc_project(&src, e[0], e[1], 16, steps);
+    bc_refine(&src, steps, 16, e[0], e[1]);
+
+    uint32_t q[2][4], p[2];
+    bc7_quantize(e[0], q[0], &p[0]);
+    bc7_quantize(e[1], q[1], &p[1]);
+
+    float d[2][4];
+    for (uint32_t ep = 0; ep < 2; ep++) {
+        for (uint32_t ch = 0; ch < 4; ch++) {
+            d[ep][ch] = (float)(q[ep][ch] * 2 + p[ep]);
+        }
+    }
+
+    bc_project(&src, d[0], d[1], 16, steps);
+
+    // The anchor texel drops the index high bit, so it must sit in the first half of the range.
+    uint32_t first = 0;
+    if (steps[0] >= 8) {
+        first = 1;
+        for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+            steps[i] = (uint8_t)(15 - steps[i]);
+        }
+    }
+    const uint32_t second = 1 - first;
+
+    memset(block, 0, 16);
+    uint32_t offset = 0;
+    bc7_bits_write(block, &offset, 1 << 6, 7);
+    for (uint32_t ch = 0; ch < 4; ch++) {
+        bc7_bits_write(block, &offset, q[first][ch], 7);
+        bc7_bits_write(block, &offset, q[second][ch], 7);
+    }
+    bc7_bits_write(block, &offset, p[first], 1);
+    bc7_bits_write(block, &offset, p[second], 1);
+
+    for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+        bc7_bits_write(block, &offset, steps[i], i == 0 ? 3 : 4);
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef MGFX_BC_ENCODE_H_
+#define MGFX_BC_ENCODE_H_
+
+#include <mx/mx.h>
+
+// Block encoders take a 4x4 block of rgba8 texels in row major order.
+enum { BC_BLOCK_TEXELS = 16 };
+
+// Opaque rgb, 8 bytes.
+void bc1_encode_block(const uint8_t texels[BC_BLOCK_TEXELS * 4], uint8_t block[8]);
+
+// Single channel, 8 bytes.
+void bc4_encode_block(const uint8_t values[BC_BLOCK_TEXELS], uint8_t block[8]);
+
+// Red and green as two bc4 blocks, 16 bytes. Used for tangent space normals.
+void bc5_encode_block(const uint8_t texels[BC_BLOCK_TEXELS * 4], uint8_t block[16]);
+
+// Rgba with mode 6, a single subset with 4 bit indices, 16 bytes.
+void bc7_encode_block(const uint8_t texels[BC_BLOCK_TEXELS * 4], uint8_t block[16]);
+
+#endif
@@ -0,0 +1,473 @@
+#include "bc_encode.h"
+#include "jobs.h"
+#include "ktx2.h"
+
+#include <mx/mx_log.h>
+#include <mx/mx_memory.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vulkan/vulkan_core.h>
+
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MGFX_TEXBAKE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MGFX_TEXBAKE_NEON
+#endif
+
+// Bakes a png or jpeg into a block compressed ktx2 with a full mip chain, so the runtime uploads
+// the levels as is instead of decoding and generating mips:
+//
+//   mgfx_texbake [--srgb | --linear | --normal] [--format bc1 | bc5 | bc7] [--no-mips] in out
+//
+// Mips are box filtered in linear space, srgb sources are decoded before filtering and encoded
+// again per level. Normal maps are renormalized per level and default to bc5.
+
+enum { TEXBAKE_MAX_LEVELS = 16 };
+enum { TEXBAKE_LEVEL_ALIGNMENT = 16 };
+enum { TEXBAKE_LINEAR_TO_SRGB_STEPS = 4096 };
+
+// Khronos data format descriptor, a single basic block.
+enum { KDF_MODEL_BC1A = 128, KDF_MODEL_BC5 = 132, KDF_MODEL_BC7 = 134 };
+enum { KDF_PRIMARIES_BT709 = 1 };
+enum { KDF_TRANSFER_LINEAR = 1, KDF_TRANSFER_SRGB = 2 };
+enum { KDF_VERSION = 2 };
+enum { KDF_BLOCK_HEADER_SIZE = 24, KDF_SAMPLE_SIZE = 16 };
+
+typedef enum texbake_mode {
+    TEXBAKE_MODE_SRGB,
+    TEXBAKE_MODE_LINEAR,
+    TEXBAKE_MODE_NORMAL,
+} texbake_mode;
+
+typedef void (*texbake_block_fn)(const uint8_t* texels, uint8_t* block);
+
+typedef struct texbake_format {
+    const char* name;
+    uint32_t block_size;
+    VkFormat unorm;
+    VkFormat srgb; // VK_FORMAT_UNDEFINED when the format has no srgb variant.
+    uint32_t model;
+    uint32_t sample_count;
+    texbake_block_fn encode;
+} texbake_format;
+
+static const texbake_format k_formats[] = {
+    {"bc1",
+     8,
+     VK_FORMAT_BC1_RGB_UNORM_BLOCK,
+     VK_FORMAT_BC1_RGB_SRGB_BLOCK,
+     KDF_MODEL_BC1A,
+     1,
+     bc1_encode_block},
+    {"bc5", 16, VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_UNDEFINED, KDF_MODEL_BC5, 2, bc5_encode_block},
+    {"bc7",
+     16,
+     VK_FORMAT_BC7_UNORM_BLOCK,
+     VK_FORMAT_BC7_SRGB_BLOCK,
+     KDF_MODEL_BC7,
+     1,
+     bc7_encode_block},
+};
+static const uint32_t k_format_count = sizeof(k_formats) / sizeof(texbake_format);
+
+// Rgba32f texels, linear unless the mode is normal where xyz stay biased to [0, 1].
+typedef struct texbake_image {
+    float* texels;
+    uint32_t width;
+    uint32_t height;
+} texbake_image;
+
+typedef struct texbake_level {
+    uint8_t* data;
+    size_t size;
+} texbake_level;
+
+typedef struct texbake_job {
+    const texbake_image* src;
+    texbake_image* dst;
+    const texbake_format* format;
+    texbake_mode mode;
+
+    const uint8_t* pixels;
+    uint8_t* blocks;
+} texbake_job;
+
+static float s_srgb_to_linear[256];
+static uint8_t s_linear_to_srgb[TEXBAKE_LINEAR_TO_SRGB_STEPS];
+
+static void texbake_tables_init() {
+    for (uint32_t i = 0; i < 256; i++) {
+        const float c = i / 255.0f;
+        s_srgb_to_linear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    for (uint32_t i = 0; i < TEXBAKE_LINEAR_TO_SRGB_STEPS; i++) {
+        const float c = i / (float)(TEXBAKE_LINEAR_TO_SRGB_STEPS - 1);
+        const float s = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+        s_linear_to_srgb[i] = (uint8_t)(s * 255.0f + 0.5f);
+    }
+}
+
+static float texbake_saturate(float value) {
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+static uint8_t texbake_unorm8(float value) {
+    return (uint8_t)(texbake_saturate(value) * 255.0f + 0.5f);
+}
+
+static uint8_t texbake_srgb8(float value) {
+    const float step = texbake_saturate(value) * (TEXBAKE_LINEAR_TO_SRGB_STEPS - 1) + 0.5f;
+    return s_linear_to_srgb[(uint32_t)step];
+}
+
+static void texbake_normal_renormalize(float* texel) {
+    float n[3];
+    float len2 = 0.0f;
+    for (uint32_t ch = 0; ch < 3; ch++) {
+        n[ch] = texel[ch] * 2.0f - 1.0f;
+        len2 += n[ch] * n[ch];
+    }
+
+    if (len2 < 1e-12f) {
+        return;
+    }
+
+    const float inv_len = 1.0f / sqrtf(len2);
+    for (uint32_t ch = 0; ch < 3; ch++) {
+        texel[ch] = n[ch] * inv_len * 0.5f + 0.5f;
+    }
+}
+
+static void texbake_image_create(texbake_image* image, uint32_t width, uint32_t height) {
+    image->width = width;
+    image->height = height;
+    image->texels = mx_alloc(mx_default_allocator(), (size_t)width * height * 4 * sizeof(float));
+}
+
+static void texbake_image_destroy(texbake_image* image) {
+    mx_free(mx_default_allocator(), image->texels);
+    image->texels = NULL;
+}
+
+static void texbake_decode_fn(void* ctx, uint32_t begin, uint32_t end, uint32_t worker) {
+    const texbake_job* job = ctx;
+    const uint32_t width = job->dst->width;
+
+    for (uint32_t y = begin; y < end; y++) {
+        const uint8_t* src = job->pixels + (size_t)y * width * 4;
+        float* dst = job->dst->texels + (size_t)y * width * 4;
+
+        for (uint32_t x = 0; x < width * 4; x += 4) {
+            for (uint32_t ch = 0; ch < 3; ch++) {
+                dst[x + ch] = job->mode == TEXBAKE_MODE_SRGB ? s_srgb_to_linear[src[x + ch]]
+                                                             : src[x + ch] / 255.0f;
+            }
+            dst[x + 3] = src[x + 3] / 255.0f;
+        }
+    }
+}
+
+// 2x2 box filter, odd edges reuse the last row or column.
+static void texbake_downsample_fn(void* ctx, uint32_t begin, uint32_t end, uint32_t worker) {
+    const texbake_job* job = ctx;
+    const texbake_image* src = job->src;
+    texbake_image* dst = job->dst;
+
+    for (uint32_t y = begin; y < end; y++) {
+        const uint32_t y1 = y * 2 + 1 < src->height ? y * 2 + 1 : src->height - 1;
+        const float* row0 = src->texels + (size_t)(y * 2) * src->width * 4;
+        const float* row1 = src->texels + (size_t)y1 * src->width * 4;
+        float* out = dst->texels + (size_t)y * dst->width * 4;
+
+        for (uint32_t x = 0; x < dst->width; x++) {
+            const uint32_t x0 = x * 2 * 4;
+            const uint32_t x1 = (x * 2 + 1 < src->width ? x * 2 + 1 : src->width - 1) * 4;
+            float* texel = out + x * 4;
+
+#if defined(MGFX_TEXBAKE_SSE)
+            const __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1));
+            const __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1));
+            _mm_storeu_ps(texel, _mm_mul_ps(_mm_add_ps(top, bottom), _mm_set1_ps(0.25f)));
+#elif defined(MGFX_TEXBAKE_NEON)
+            const float32x4_t top = vaddq_f32(vld1q_f32(row0 + x0), vld1q_f32(row0 + x1));
+            const float32x4_t bottom = vaddq_f32(vld1q_f32(row1 + x0), vld1q_f32(row1 + x1));
+            vst1q_f32(texel, vmulq_n_f32(vaddq_f32(top, bottom), 0.25f));
+#else
+            for (uint32_t ch = 0; ch < 4; ch++) {
+                texel[ch] = (row0[x0 + ch] + row0[x1 + ch] + row1[x0 + ch] + row1[x1 + ch]) * 0.25f;
+            }
+#endif
+
+            if (job->mode == TEXBAKE_MODE_NORMAL) {
+                texbake_normal_renormalize(texel);
+            }
+        }
+    }
+}
+
+// One range item per row of blocks, edge blocks repeat the last texel.
+static void texbake_encode_fn(void* ctx, uint32_t begin, uint32_t end, uint32_t worker) {
+    const texbake_job* job = ctx;
+    const texbake_image* src = job->src;
+    const uint32_t blocks_x = (src->width + 3) / 4;
+
+    for (uint32_t by = begin; by < end; by++) {
+        for (uint32_t bx = 0; bx < blocks_x; bx++) {
+            uint8_t texels[BC_BLOCK_TEXELS * 4];
+
+            for (uint32_t i = 0; i < BC_BLOCK_TEXELS; i++) {
+                const uint32_t sx = bx * 4 + i % 4 < src->width ? bx * 4 + i % 4 : src->width - 1;
+                const uint32_t sy = by * 4 + i / 4 < src->height ? by * 4 + i / 4 : src->height - 1;
+                const float* texel = src->texels + ((size_t)sy * src->width + sx) * 4;
+
+                for (uint32_t ch = 0; ch < 3; ch++) {
+                    texels[i * 4 + ch] = job->mode == TEXBAKE_MODE_SRGB ? texbake_srgb8(texel[ch])
+                                                                        : texbake_unorm8(texel[ch]);
+                }
+                texels[i * 4 + 3] = texbake_unorm8(texel[3]);
+            }
+
+            const size_t block_idx = (size_t)by * blocks_x + bx;
+            job->format->encode(texels, job->blocks + block_idx * job->format->block_size);
+        }
+    }
+}
+
+static void texbake_level_encode(const texbake_image* image,
+                                 const texbake_format* format,
+                                 texbake_mode mode,
+                                 texbake_level* level) {
+    const uint32_t blocks_x = (image->width + 3) / 4;
+    const uint32_t blocks_y = (image->height + 3) / 4;
+
+    level->size = (size_t)blocks_x * blocks_y * format->block_size;
+    level->data = mx_alloc(mx_default_allocator(), level->size);
+
+    texbake_job job = {.src = image, .format = format, .mode = mode, .blocks = level->data};
+    jobs_parallel_for(blocks_y, 1, texbake_encode_fn, &job);
+}
+
+static uint32_t texbake_dfd_write(FILE* file, const texbake_format* format, texbake_mode mode) {
+    const uint32_t block_size = KDF_BLOCK_HEADER_SIZE + KDF_SAMPLE_SIZE * format->sample_count;
+    const uint32_t transfer = mode == TEXBAKE_MODE_SRGB ? KDF_TRANSFER_SRGB : KDF_TRANSFER_LINEAR;
+
+    uint32_t words[1 + (KDF_BLOCK_HEADER_SIZE + KDF_SAMPLE_SIZE * 2) / 4] = {0};
+    uint32_t count = 0;
+
+    words[count++] = 4 + block_size;
+    words[count++] = 0; // Khronos vendor, basic descriptor type.
+    words[count++] = KDF_VERSION | block_size << 16;
+    words[count++] = format->model | KDF_PRIMARIES_BT709 << 8 | transfer << 16;
+    words[count++] = 3 | 3 << 8; // 4x4x1x1 texel blocks, stored minus one.
+    words[count++] = format->block_size;
+    words[count++] = 0;
+
+    // Bc5 has a red and a green sample of 64 bits each, the others one sample for the block.
+    const uint32_t sample_bits = format->block_size * 8 / format->sample_count;
+    for (uint32_t sample = 0; sample < format->sample_count; sample++) {
+        words[count++] = (sample * sample_bits) | (sample_bits - 1) << 16 | sample << 24;
+        words[count++] = 0;
+        words[count++] = 0;
+        words[count++] = 0xFFFFFFFF;
+    }
+
+    fwrite(words, sizeof(uint32_t), count, file);
+    return count * sizeof(uint32_t);
+}
+
+static mx_bool texbake_write(const char* path,
+                             const texbake_format* format,
+                             texbake_mode mode,
+                             uint32_t width,
+                             uint32_t height,
+                             const texbake_level* levels,
+                             uint32_t level_count) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        MX_LOG_ERROR("[TexBake] Failed to open %s for writing!", path);
+        return MX_FALSE;
+    }
+
+    const uint32_t dfd_offset = sizeof(ktx2_header) + level_count * sizeof(ktx2_level);
+    const uint32_t dfd_length = 4 + KDF_BLOCK_HEADER_SIZE + KDF_SAMPLE_SIZE * format->sample_count;
+
+    ktx2_header header = {
+        .identifier = KTX2_IDENTIFIER,
+        .vk_format = mode == TEXBAKE_MODE_SRGB ? format->srgb : format->unorm,
+        .type_size = 1,
+        .pixel_width = width,
+        .pixel_height = height,
+        .face_count = 1,
+        .level_count = level_count,
+        .dfd_byte_offset = dfd_offset,
+        .dfd_byte_length = dfd_length,
+    };
+
+    // Level data is stored smallest first, the index still lists level 0 first.
+    ktx2_level index[TEXBAKE_MAX_LEVELS] = {0};
+    uint64_t offset = dfd_offset + dfd_length;
+    for (uint32_t i = level_count; i-- > 0;) {
+        offset = (offset + TEXBAKE_LEVEL_ALIGNMENT - 1) & ~(uint64_t)(TEXBAKE_LEVEL_ALIGNMENT - 1);
+        index[i] = (ktx2_level){
+            .byte_offset = offset,
+            .byte_length = levels[i].size,
+            .uncompressed_byte_length = levels[i].size,
+        };
+        offset += levels[i].size;
+    }
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(index, sizeof(ktx2_level), level_count, file);
+    uint64_t written = dfd_offset + texbake_dfd_write(file, format, mode);
+
+    static const uint8_t k_padding[TEXBAKE_LEVEL_ALIGNMENT] = {0};
+    for (uint32_t i = level_count; i-- > 0;) {
+        fwrite(k_padding, 1, (size_t)(index[i].byte_offset - written), file);
+        fwrite(levels[i].data, 1, levels[i].size, file);
+        written = index[i].byte_offset + levels[i].size;
+    }
+
+    const mx_bool success = ferror(file) == 0;
+    fclose(file);
+
+    if (!success) {
+        MX_LOG_ERROR("[TexBake] Failed to write %s!", path);
+    }
+    return success;
+}
+
+static const texbake_format* texbake_format_find(const char* name) {
+    for (uint32_t i = 0; i < k_format_count; i++) {
+        if (strcmp(k_formats[i].name, name) == 0) {
+            return &k_formats[i];
+        }
+    }
+    return NULL;
+}
+
+static void texbake_usage() {
+    MX_LOG_INFO("usage: mgfx_texbake [--srgb | --linear | --normal] [--format bc1 | bc5 | bc7] "
+                "[--no-mips] <input> <output.ktx2>");
+}
+
+int main(int argc, char** argv) {
+    texbake_mode mode = TEXBAKE_MODE_SRGB;
+    const texbake_format* format = NULL;
+    mx_bool mips = MX_TRUE;
+    const char* paths[2] = {NULL, NULL};
+    uint32_t path_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--srgb") == 0) {
+            mode = TEXBAKE_MODE_SRGB;
+        } else if (strcmp(argv[i], "--linear") == 0) {
+            mode = TEXBAKE_MODE_LINEAR;
+        } else if (strcmp(argv[i], "--normal") == 0) {
+            mode = TEXBAKE_MODE_NORMAL;
+        } else if (strcmp(argv[i], "--no-mips") == 0) {
+            mips = MX_FALSE;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            format = texbake_format_find(argv[++i]);
+            if (!format) {
+                MX_LOG_ERROR("[TexBake] Unknown format %s!", argv[i]);
+                return 1;
+            }
+        } else if (argv[i][0] != '-' && path_count < 2) {
+            paths[path_count++] = argv[i];
+        } else {
+            texbake_usage();
+            return 1;
+        }
+    }
+
+    if (path_count != 2) {
+        texbake_usage();
+        return 1;
+    }
+
+    if (!format) {
+        format = texbake_format_find(mode == TEXBAKE_MODE_NORMAL ? "bc5" : "bc7");
+    }
+
+    if (mode == TEXBAKE_MODE_SRGB && format->srgb == VK_FORMAT_UNDEFINED) {
+        MX_LOG_ERROR("[TexBake] %s has no srgb variant, use --linear or --normal!", format->name);
+        return 1;
+    }
+
+    int width, height, channels;
+    uint8_t* pixels = stbi_load(paths[0], &width, &height, &channels, 4);
+    if (!pixels) {
+        MX_LOG_ERROR("[TexBake] Failed to load %s: %s", paths[0], stbi_failure_reason());
+        return 1;
+    }
+
+    jobs_init(0);
+    texbake_tables_init();
+
+    uint32_t level_count = 1;
+    if (mips) {
+        for (uint32_t extent = width > height ? width : height; extent > 1; extent >>= 1) {
+            level_count++;
+        }
+        level_count = level_count > TEXBAKE_MAX_LEVELS ? TEXBAKE_MAX_LEVELS : level_count;
+    }
+
+    texbake_image image;
+    texbake_image_create(&image, (uint32_t)width, (uint32_t)height);
+
+    texbake_job decode_job = {.dst = &image, .mode = mode, .pixels = pixels};
+    jobs_parallel_for(image.height, 16, texbake_decode_fn, &decode_job);
+    stbi_image_free(pixels);
+
+    texbake_level levels[TEXBAKE_MAX_LEVELS] = {0};
+    for (uint32_t i = 0; i < level_count; i++) {
+        if (i > 0) {
+            texbake_image next;
+            texbake_image_create(&next,
+                                 image.width > 1 ? image.width / 2 : 1,
+                                 image.height > 1 ? image.height / 2 : 1);
+
+            texbake_job downsample_job = {.src = &image, .dst = &next, .mode = mode};
+            jobs_parallel_for(next.height, 16, texbake_downsample_fn, &downsample_job);
+
+            texbake_image_destroy(&image);
+            image = next;
+        }
+
+        texbake_level_encode(&image, format, mode, &levels[i]);
+    }
+    texbake_image_destroy(&image);
+
+    const mx_bool success = texbake_write(
+        paths[1], format, mode, (uint32_t)width, (uint32_t)height, levels, level_count);
+
+    size_t total_size = 0;
+    for (uint32_t i = 0; i < level_count; i++) {
+        total_size += levels[i].size;
+        mx_free(mx_default_allocator(), levels[i].data);
+    }
+
+    if (success) {
+        MX_LOG_INFO("[TexBake] %s -> %s: %ux%u %s, %u levels, %zu kb",
+                    paths[0],
+                    paths[1],
+                    width,
+                    height,
+                    format->name,
+                    level_count,
+                    total_size / MX_KB);
+    }
+
+    jobs_shutdown();
+    return success ? 0 : 1;
+}